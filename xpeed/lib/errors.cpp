@@ -128,6 +128,10 @@ std::string xpeed::error_rpc_messages::message (int ev) const
 			return "Bad source";
 		case xpeed::error_rpc::bad_timeout:
 			return "Bad timeout number";
+		case xpeed::error_rpc::batch_action_not_allowed:
+			return "Action is not allowed in a batch";
+		case xpeed::error_rpc::batch_size_exceeded:
+			return "Batch size exceeds max_batch_size";
 		case xpeed::error_rpc::block_create_balance_mismatch:
 			return "Balance mismatch for previous block";
 		case xpeed::error_rpc::block_create_key_required:
@@ -80,6 +80,8 @@ enum class error_rpc
 	bad_representative_number,
 	bad_source,
 	bad_timeout,
+	batch_action_not_allowed,
+	batch_size_exceeded,
 	block_create_balance_mismatch,
 	block_create_key_required,
 	block_create_public_key_mismatch,
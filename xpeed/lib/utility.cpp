@@ -99,6 +99,18 @@ namespace thread_role
 			case xpeed::thread_role::name::slow_db_upgrade:
 				thread_role_name_string = "Slow db upgrade";
 				break;
+			case xpeed::thread_role::name::confirmation_height_processing:
+				thread_role_name_string = "Conf height";
+				break;
+			case xpeed::thread_role::name::udp_ingress:
+				thread_role_name_string = "UDP ingress";
+				break;
+			case xpeed::thread_role::name::udp_egress:
+				thread_role_name_string = "UDP egress";
+				break;
+			case xpeed::thread_role::name::network_simulator:
+				thread_role_name_string = "Net simulator";
+				break;
 		}
 
 		/*
@@ -86,6 +86,10 @@ namespace thread_role
 		voting,
 		signature_checking,
 		slow_db_upgrade,
+		confirmation_height_processing,
+		udp_ingress,
+		udp_egress,
+		network_simulator,
 	};
 	/*
 	 * Get/Set the identifier for the current thread
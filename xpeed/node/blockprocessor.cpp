@@ -185,7 +185,9 @@ void xpeed::block_processor::verify_state_blocks (xpeed::transaction const & tra
 			signatures.push_back (blocks_signatures.back ().bytes.data ());
 		}
 		xpeed::signature_check_set check = { size, messages.data (), lengths.data (), pub_keys.data (), signatures.data (), verifications.data () };
+		auto verify_begin (std::chrono::steady_clock::now ());
 		node.checker.verify (check);
+		node.stats.add (xpeed::stat::type::block_processor, xpeed::stat::detail::signature_verify, xpeed::stat::dir::in, std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::steady_clock::now () - verify_begin).count ());
 		lock_a.lock ();
 		for (auto i (0); i < size; ++i)
 		{
@@ -295,26 +297,33 @@ void xpeed::block_processor::process_batch (std::unique_lock<std::mutex> & lock_
 				// Replace our block with the winner and roll back any dependent blocks
 				BOOST_LOG (node.log) << boost::str (boost::format ("Rolling back %1% and replacing with %2%") % successor->hash ().to_string () % hash.to_string ());
 				std::vector<xpeed::block_hash> rollback_list;
-				node.ledger.rollback (transaction, successor->hash (), rollback_list);
-				BOOST_LOG (node.log) << boost::str (boost::format ("%1% blocks rolled back") % rollback_list.size ());
-				lock_a.lock ();
-				// Prevent rolled back blocks second insertion
-				auto inserted (rolled_back.insert (xpeed::rolled_hash{ std::chrono::steady_clock::now (), successor->hash () }));
-				if (inserted.second)
+				if (!node.ledger.rollback (transaction, successor->hash (), rollback_list))
 				{
-					// Possible election winner change
-					rolled_back.get<1> ().erase (hash);
-					// Prevent overflow
-					if (rolled_back.size () > rolled_back_max)
+					BOOST_LOG (node.log) << boost::str (boost::format ("%1% blocks rolled back") % rollback_list.size ());
+					lock_a.lock ();
+					// Prevent rolled back blocks second insertion
+					auto inserted (rolled_back.insert (xpeed::rolled_hash{ std::chrono::steady_clock::now (), successor->hash () }));
+					if (inserted.second)
 					{
-						rolled_back.erase (rolled_back.begin ());
+						// Possible election winner change
+						rolled_back.get<1> ().erase (hash);
+						// Prevent overflow
+						if (rolled_back.size () > rolled_back_max)
+						{
+							rolled_back.erase (rolled_back.begin ());
+						}
+					}
+					lock_a.unlock ();
+					// Deleting from votes cache
+					for (auto & i : rollback_list)
+					{
+						node.votes_cache.remove (i);
 					}
 				}
-				lock_a.unlock ();
-				// Deleting from votes cache
-				for (auto & i : rollback_list)
+				else
 				{
-					node.votes_cache.remove (i);
+					// Cemented blocks are final, the forced block is processed as a fork
+					BOOST_LOG (node.log) << boost::str (boost::format ("Failed to roll back %1% because it or a successor was cemented") % successor->hash ().to_string ());
 				}
 			}
 		}
@@ -355,10 +364,11 @@ void xpeed::block_processor::process_live (xpeed::block_hash const & hash_a, std
 		{
 			// Check if votes were already requested
 			bool send_request (false);
+			auto existing (node_l->active.election (block_a->hash ()));
+			if (existing != nullptr)
 			{
-				std::lock_guard<std::mutex> lock (node_l->active.mutex);
-				auto existing (node_l->active.blocks.find (block_a->hash ()));
-				if (existing != node_l->active.blocks.end () && !existing->second->confirmed && !existing->second->stopped && existing->second->announcements == 0)
+				auto lock (node_l->active.lock_shard (node_l->active.root_shard (existing->root)));
+				if (!existing->erased && !existing->confirmed && !existing->stopped && existing->announcements == 0)
 				{
 					send_request = true;
 				}
@@ -376,7 +386,9 @@ xpeed::process_return xpeed::block_processor::process_one (xpeed::transaction co
 {
 	xpeed::process_return result;
 	auto hash (info_a.block->hash ());
+	auto apply_begin (std::chrono::steady_clock::now ());
 	result = node.ledger.process (transaction_a, *(info_a.block), info_a.verified);
+	node.stats.add (xpeed::stat::type::block_processor, xpeed::stat::detail::ledger_apply, xpeed::stat::dir::in, std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::steady_clock::now () - apply_begin).count ());
 	switch (result.code)
 	{
 		case xpeed::process_result::progress:
@@ -518,6 +530,7 @@ xpeed::process_return xpeed::block_processor::process_one (xpeed::transaction co
 
 void xpeed::block_processor::queue_unchecked (xpeed::transaction const & transaction_a, xpeed::block_hash const & hash_a)
 {
+	auto resolve_begin (std::chrono::steady_clock::now ());
 	auto unchecked_blocks (node.store.unchecked_get (transaction_a, hash_a));
 	for (auto & info : unchecked_blocks)
 	{
@@ -527,6 +540,7 @@ void xpeed::block_processor::queue_unchecked (xpeed::transaction const & transac
 		}
 		add (info);
 	}
+	node.stats.add (xpeed::stat::type::block_processor, xpeed::stat::detail::unchecked_resolve, xpeed::stat::dir::in, std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::steady_clock::now () - resolve_begin).count ());
 	std::lock_guard<std::mutex> lock (node.gap_cache.mutex);
 	node.gap_cache.blocks.get<1> ().erase (hash_a);
 }
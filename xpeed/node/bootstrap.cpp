@@ -4,6 +4,8 @@
 #include <xpeed/node/node.hpp>
 
 #include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <boost/log/trivial.hpp>
 
 constexpr double bootstrap_connection_scale_target_blocks = 50000.0;
@@ -15,8 +17,34 @@ constexpr unsigned bootstrap_frontier_retry_limit = 16;
 constexpr double bootstrap_minimum_termination_time_sec = 30.0;
 constexpr unsigned bootstrap_max_new_connections = 10;
 constexpr unsigned bulk_push_cost_limit = 200;
+constexpr unsigned bootstrap_pull_chunk_blocks = 4096;
+constexpr double bootstrap_score_weight = 0.25;
+constexpr double bootstrap_lagging_ratio = 0.25;
+constexpr size_t bootstrap_pull_times_max = 1024;
+constexpr size_t bootstrap_ascending_batch = 256;
+constexpr std::chrono::seconds bootstrap_checkpoint_interval = std::chrono::seconds (xpeed::is_test_network ? 1 : 60);
+constexpr size_t bootstrap_checkpoint_pulls_max = xpeed::is_test_network ? 1024 : 64 * 1024;
+
+namespace
+{
+// First byte of each record of a bootstrap checkpoint
+enum class checkpoint_record : uint8_t
+{
+	mode,
+	pull,
+	frontier_range,
+	lazy_key,
+	lazy_pull,
+	bulk_push_target,
+	ascending_cursor
+};
+}
 
 size_t constexpr xpeed::frontier_req_client::size_frontier;
+size_t constexpr xpeed::account_probe_client::size_entry;
+size_t constexpr xpeed::bulk_pull_client::buffer_size;
+size_t constexpr xpeed::bulk_pull_server::max_write_size;
+size_t constexpr xpeed::frontier_req_server::max_write_size;
 
 xpeed::socket::socket (std::shared_ptr<xpeed::node> node_a) :
 socket_m (node_a->io_ctx),
@@ -51,6 +79,21 @@ void xpeed::socket::async_read (std::shared_ptr<std::vector<uint8_t>> buffer_a,
 	}
 }
 
+void xpeed::socket::async_read_some (std::shared_ptr<std::vector<uint8_t>> buffer_a, size_t offset_a, std::function<void(boost::system::error_code const &, size_t)> callback_a)
+{
+	assert (offset_a < buffer_a->size ());
+	auto this_l (shared_from_this ());
+	if (socket_m.is_open ())
+	{
+		start ();
+		socket_m.async_read_some (boost::asio::buffer (buffer_a->data () + offset_a, buffer_a->size () - offset_a), [this_l, buffer_a, callback_a](boost::system::error_code const & ec, size_t size_a) {
+			this_l->node->stats.add (xpeed::stat::type::traffic_bootstrap, xpeed::stat::dir::in, size_a);
+			this_l->stop ();
+			callback_a (ec, size_a);
+		});
+	}
+}
+
 void xpeed::socket::async_write (std::shared_ptr<std::vector<uint8_t>> buffer_a, std::function<void(boost::system::error_code const &, size_t)> callback_a)
 {
 	auto this_l (shared_from_this ());
@@ -135,8 +178,13 @@ receive_buffer (std::make_shared<std::vector<uint8_t>> ()),
 endpoint (endpoint_a),
 start_time (std::chrono::steady_clock::now ()),
 block_count (0),
+byte_count (0),
 pending_stop (false),
-hard_stop (false)
+hard_stop (false),
+score (0.0),
+score_blocks (0),
+score_time (std::chrono::steady_clock::now ()),
+lagging (false)
 {
 	++attempt->connections;
 	receive_buffer->resize (256);
@@ -153,6 +201,12 @@ double xpeed::bootstrap_client::block_rate () const
 	return static_cast<double> (block_count.load () / elapsed);
 }
 
+double xpeed::bootstrap_client::byte_rate () const
+{
+	auto elapsed = std::max (elapsed_seconds (), bootstrap_minimum_elapsed_seconds_blockrate);
+	return static_cast<double> (byte_count.load () / elapsed);
+}
+
 double xpeed::bootstrap_client::elapsed_seconds () const
 {
 	return std::chrono::duration_cast<std::chrono::duration<double>> (std::chrono::steady_clock::now () - start_time).count ();
@@ -203,7 +257,7 @@ void xpeed::bootstrap_client::run ()
 void xpeed::frontier_req_client::run ()
 {
 	std::unique_ptr<xpeed::frontier_req> request (new xpeed::frontier_req);
-	request->start.clear ();
+	request->start = range->start;
 	request->age = std::numeric_limits<decltype (request->age)>::max ();
 	request->count = std::numeric_limits<decltype (request->count)>::max ();
 	auto send_buffer (std::make_shared<std::vector<uint8_t>> ());
@@ -232,9 +286,10 @@ std::shared_ptr<xpeed::bootstrap_client> xpeed::bootstrap_client::shared ()
 	return shared_from_this ();
 }
 
-xpeed::frontier_req_client::frontier_req_client (std::shared_ptr<xpeed::bootstrap_client> connection_a) :
+xpeed::frontier_req_client::frontier_req_client (std::shared_ptr<xpeed::bootstrap_client> connection_a, std::shared_ptr<xpeed::frontier_range> range_a) :
 connection (connection_a),
-current (0),
+range (range_a),
+current (range_a->start.is_zero () ? 0 : range_a->start.number () - 1),
 count (0),
 bulk_push_cost (0)
 {
@@ -315,8 +370,10 @@ void xpeed::frontier_req_client::received_frontier (boost::system::error_code co
 			BOOST_LOG (connection->node->log) << boost::str (boost::format ("Received %1% frontiers from %2%") % std::to_string (count) % connection->socket->remote_endpoint ());
 		}
 		auto transaction (connection->node->store.tx_begin_read ());
-		if (!account.is_zero ())
+		if (in_range (account))
 		{
+			++range->frontiers;
+			range->position = static_cast<uint64_t> (account.number () >> 192);
 			while (!current.is_zero () && current < account)
 			{
 				// We know about an account they don't.
@@ -340,7 +397,7 @@ void xpeed::frontier_req_client::received_frontier (boost::system::error_code co
 						}
 						else
 						{
-							connection->attempt->add_pull (xpeed::pull_info (account, latest, frontier));
+							pulls.push_back (xpeed::pull_info (account, latest, frontier));
 							// Either we're behind or there's a fork we differ on
 							// Either way, bulk pushing will probably not be effective
 							bulk_push_cost += 5;
@@ -351,12 +408,12 @@ void xpeed::frontier_req_client::received_frontier (boost::system::error_code co
 				else
 				{
 					assert (account < current);
-					connection->attempt->add_pull (xpeed::pull_info (account, latest, xpeed::block_hash (0)));
+					pulls.push_back (xpeed::pull_info (account, latest, xpeed::block_hash (0)));
 				}
 			}
 			else
 			{
-				connection->attempt->add_pull (xpeed::pull_info (account, latest, xpeed::block_hash (0)));
+				pulls.push_back (xpeed::pull_info (account, latest, xpeed::block_hash (0)));
 			}
 			receive_frontier ();
 		}
@@ -372,6 +429,7 @@ void xpeed::frontier_req_client::received_frontier (boost::system::error_code co
 			{
 				BOOST_LOG (connection->node->log) << "Bulk push cost: " << bulk_push_cost;
 			}
+			connection->attempt->add_pulls (pulls);
 			{
 				try
 				{
@@ -380,7 +438,11 @@ void xpeed::frontier_req_client::received_frontier (boost::system::error_code co
 				catch (std::future_error &)
 				{
 				}
-				connection->attempt->pool_connection (connection);
+				// The peer keeps sending frontiers past the end of a range, such a connection can't be reused
+				if (account.is_zero ())
+				{
+					connection->attempt->pool_connection (connection);
+				}
 			}
 		}
 	}
@@ -399,12 +461,12 @@ void xpeed::frontier_req_client::next (xpeed::transaction const & transaction_a)
 	if (accounts.empty ())
 	{
 		size_t max_size (128);
-		for (auto i (connection->node->store.latest_begin (transaction_a, current.number () + 1)), n (connection->node->store.latest_end ()); i != n && accounts.size () != max_size; ++i)
+		for (auto i (connection->node->store.latest_begin (transaction_a, current.number () + 1)), n (connection->node->store.latest_end ()); i != n && accounts.size () != max_size && in_range (xpeed::account (i->first)); ++i)
 		{
 			xpeed::account_info info (i->second);
 			accounts.push_back (std::make_pair (xpeed::account (i->first), info.head));
 		}
-		/* If loop breaks before max_size, then latest_end () is reached
+		/* If loop breaks before max_size, then latest_end () or the end of the range is reached
 		Add empty record to finish frontier_req_server */
 		if (accounts.size () != max_size)
 		{
@@ -418,14 +480,46 @@ void xpeed::frontier_req_client::next (xpeed::transaction const & transaction_a)
 	frontier = account_pair.second;
 }
 
+bool xpeed::frontier_req_client::in_range (xpeed::account const & account_a) const
+{
+	return !account_a.is_zero () && (range->end.is_zero () || account_a < range->end);
+}
+
+xpeed::frontier_range::frontier_range (xpeed::account const & start_a, xpeed::account const & end_a) :
+start (start_a),
+end (end_a),
+frontiers (0),
+position (static_cast<uint64_t> (start_a.number () >> 192)),
+attempts (0),
+done (false)
+{
+}
+
+double xpeed::frontier_range::progress () const
+{
+	auto first (static_cast<double> (static_cast<uint64_t> (start.number () >> 192)));
+	auto last (end.is_zero () ? std::pow (2.0, 64) : static_cast<double> (static_cast<uint64_t> (end.number () >> 192)));
+	return done ? 1.0 : std::max (0.0, std::min (1.0, (static_cast<double> (position.load ()) - first) / (last - first)));
+}
+
 xpeed::bulk_pull_client::bulk_pull_client (std::shared_ptr<xpeed::bootstrap_client> connection_a, xpeed::pull_info const & pull_a) :
 connection (connection_a),
 known_account (0),
 pull (pull_a),
 total_blocks (0),
-unexpected_count (0)
+unexpected_count (0),
+start_time (std::chrono::steady_clock::now ()),
+buffer (connection_a->pull_buffer),
+buffer_begin (0),
+buffer_end (0)
 {
+	if (buffer == nullptr)
+	{
+		buffer = std::make_shared<std::vector<uint8_t>> (buffer_size);
+		connection->pull_buffer = buffer;
+	}
 	std::lock_guard<std::mutex> mutex (connection->attempt->mutex);
+	connection->attempt->pulls_in_progress[this] = pull;
 	connection->attempt->condition.notify_all ();
 }
 
@@ -435,23 +529,43 @@ xpeed::bulk_pull_client::~bulk_pull_client ()
 	if (expected != pull.end)
 	{
 		pull.head = expected;
-		if (connection->attempt->mode != xpeed::bootstrap_mode::legacy)
+		if (!connection->attempt->pulls_chains () || connection->lagging || chunk_complete ())
 		{
+			// Resume from the last block received instead of pulling the chain from its head again
 			pull.account = expected;
 		}
-		connection->attempt->requeue_pull (pull);
-		if (connection->node->config.logging.bulk_pull_logging ())
+		if (chunk_complete ())
 		{
-			BOOST_LOG (connection->node->log) << boost::str (boost::format ("Bulk pull end block is not expected %1% for account %2%") % pull.end.to_string () % pull.account.to_account ());
+			pull.processed += total_blocks;
+			connection->attempt->pull_finished (std::chrono::steady_clock::now () - start_time);
+			connection->attempt->add_continuation (pull);
+		}
+		else
+		{
+			connection->attempt->requeue_pull (pull);
+			if (connection->node->config.logging.bulk_pull_logging ())
+			{
+				BOOST_LOG (connection->node->log) << boost::str (boost::format ("Bulk pull end block is not expected %1% for account %2%") % pull.end.to_string () % pull.account.to_account ());
+			}
 		}
 	}
+	else
+	{
+		connection->attempt->pull_finished (std::chrono::steady_clock::now () - start_time);
+	}
 	{
 		std::lock_guard<std::mutex> mutex (connection->attempt->mutex);
+		connection->attempt->pulls_in_progress.erase (this);
 		--connection->attempt->pulling;
 	}
 	connection->attempt->condition.notify_all ();
 }
 
+bool xpeed::bulk_pull_client::chunk_complete () const
+{
+	return connection->attempt->pulls_chains () && pull.count != 0 && total_blocks >= pull.count && unexpected_count == 0 && !connection->hard_stop;
+}
+
 void xpeed::bulk_pull_client::request ()
 {
 	expected = pull.head;
@@ -495,154 +609,213 @@ void xpeed::bulk_pull_client::request ()
 void xpeed::bulk_pull_client::receive_block ()
 {
 	auto this_l (shared_from_this ());
-	connection->socket->async_read (connection->receive_buffer, 1, [this_l](boost::system::error_code const & ec, size_t size_a) {
-		if (!ec)
-		{
-			this_l->received_type ();
-		}
-		else
-		{
-			if (this_l->connection->node->config.logging.bulk_pull_logging ())
-			{
-				BOOST_LOG (this_l->connection->node->log) << boost::str (boost::format ("Error receiving block type: %1%") % ec.message ());
-			}
-		}
+	connection->socket->async_read_some (buffer, buffer_end, [this_l](boost::system::error_code const & ec, size_t size_a) {
+		this_l->received_data (ec, size_a);
 	});
 }
 
-void xpeed::bulk_pull_client::received_type ()
+void xpeed::bulk_pull_client::received_data (boost::system::error_code const & ec, size_t size_a)
 {
-	auto this_l (shared_from_this ());
-	xpeed::block_type type (static_cast<xpeed::block_type> (connection->receive_buffer->data ()[0]));
-	switch (type)
+	if (!ec)
 	{
-		case xpeed::block_type::send:
-		{
-			connection->socket->async_read (connection->receive_buffer, xpeed::send_block::size, [this_l, type](boost::system::error_code const & ec, size_t size_a) {
-				this_l->received_block (ec, size_a, type);
-			});
-			break;
-		}
-		case xpeed::block_type::receive:
-		{
-			connection->socket->async_read (connection->receive_buffer, xpeed::receive_block::size, [this_l, type](boost::system::error_code const & ec, size_t size_a) {
-				this_l->received_block (ec, size_a, type);
-			});
-			break;
-		}
-		case xpeed::block_type::open:
+		buffer_end += size_a;
+		connection->byte_count += size_a;
+		auto error (false);
+		auto end (false);
+		std::vector<std::shared_ptr<xpeed::block>> blocks;
+		while (!error && !end && buffer_begin < buffer_end)
 		{
-			connection->socket->async_read (connection->receive_buffer, xpeed::open_block::size, [this_l, type](boost::system::error_code const & ec, size_t size_a) {
-				this_l->received_block (ec, size_a, type);
-			});
-			break;
+			xpeed::block_type type (static_cast<xpeed::block_type> ((*buffer)[buffer_begin]));
+			if (type == xpeed::block_type::not_a_block)
+			{
+				++buffer_begin;
+				end = true;
+			}
+			else if (type == xpeed::block_type::send || type == xpeed::block_type::receive || type == xpeed::block_type::open || type == xpeed::block_type::change || type == xpeed::block_type::state)
+			{
+				auto size (xpeed::block::size (type));
+				if (buffer_end - buffer_begin > size)
+				{
+					xpeed::bufferstream stream (buffer->data () + buffer_begin + 1, size);
+					std::shared_ptr<xpeed::block> block (xpeed::deserialize_block (stream, type));
+					if (block != nullptr && !xpeed::work_validate (*block))
+					{
+						blocks.push_back (block);
+						buffer_begin += 1 + size;
+					}
+					else
+					{
+						error = true;
+						if (connection->node->config.logging.bulk_pull_logging ())
+						{
+							BOOST_LOG (connection->node->log) << "Error deserializing block received from pull request";
+						}
+					}
+				}
+				else
+				{
+					// Rest of the block hasn't arrived yet
+					break;
+				}
+			}
+			else
+			{
+				error = true;
+				if (connection->node->config.logging.network_packet_logging ())
+				{
+					BOOST_LOG (connection->node->log) << boost::str (boost::format ("Unknown type received as block type: %1%") % static_cast<int> (type));
+				}
+			}
 		}
-		case xpeed::block_type::change:
+		std::vector<xpeed::signature_verification> verified;
+		// Nothing of a batch with invalid data reaches the block processor, the pull is requeued from the last block processed
+		auto stop (error || verify (blocks, verified));
+		if (stop)
 		{
-			connection->socket->async_read (connection->receive_buffer, xpeed::change_block::size, [this_l, type](boost::system::error_code const & ec, size_t size_a) {
-				this_l->received_block (ec, size_a, type);
-			});
-			break;
+			connection->attempt->penalize (connection);
 		}
-		case xpeed::block_type::state:
+		for (size_t i (0), n (blocks.size ()); i != n && !stop; ++i)
 		{
-			connection->socket->async_read (connection->receive_buffer, xpeed::state_block::size, [this_l, type](boost::system::error_code const & ec, size_t size_a) {
-				this_l->received_block (ec, size_a, type);
-			});
-			break;
+			stop = received_block (blocks[i], verified[i]);
 		}
-		case xpeed::block_type::not_a_block:
+		if (!stop && !error)
 		{
-			// Avoid re-using slow peers, or peers that sent the wrong blocks.
-			if (!connection->pending_stop && expected == pull.end)
+			if (end)
 			{
-				connection->attempt->pool_connection (connection);
+				// Avoid re-using slow peers, or peers that sent the wrong blocks.
+				if (!connection->pending_stop && (expected == pull.end || chunk_complete ()))
+				{
+					connection->attempt->pool_connection (connection);
+				}
 			}
-			break;
-		}
-		default:
-		{
-			if (connection->node->config.logging.network_packet_logging ())
+			else
 			{
-				BOOST_LOG (connection->node->log) << boost::str (boost::format ("Unknown type received as block type: %1%") % static_cast<int> (type));
+				// Move the partial block to the front so the buffer always has room for a whole one
+				std::memmove (buffer->data (), buffer->data () + buffer_begin, buffer_end - buffer_begin);
+				buffer_end -= buffer_begin;
+				buffer_begin = 0;
+				receive_block ();
 			}
-			break;
+		}
+	}
+	else
+	{
+		if (connection->node->config.logging.bulk_pull_logging ())
+		{
+			BOOST_LOG (connection->node->log) << boost::str (boost::format ("Error bulk receiving block: %1%") % ec.message ());
 		}
 	}
 }
 
-void xpeed::bulk_pull_client::received_block (boost::system::error_code const & ec, size_t size_a, xpeed::block_type type_a)
+bool xpeed::bulk_pull_client::verify (std::vector<std::shared_ptr<xpeed::block>> const & blocks_a, std::vector<xpeed::signature_verification> & verified_a)
 {
-	if (!ec)
+	auto & ledger (connection->node->ledger);
+	verified_a.assign (blocks_a.size (), xpeed::signature_verification::unknown);
+	std::vector<size_t> indices;
+	std::vector<bool> epochs;
+	std::vector<xpeed::block_hash> hashes;
+	std::vector<xpeed::account> accounts;
+	std::vector<xpeed::signature> signatures;
+	for (size_t i (0), n (blocks_a.size ()); i != n; ++i)
 	{
-		xpeed::bufferstream stream (connection->receive_buffer->data (), size_a);
-		std::shared_ptr<xpeed::block> block (xpeed::deserialize_block (stream, type_a));
-		if (block != nullptr && !xpeed::work_validate (*block))
+		auto & block (*blocks_a[i]);
+		// Other legacy blocks don't name their account, the block processor verifies them once it's known
+		if (block.type () == xpeed::block_type::state || block.type () == xpeed::block_type::open)
 		{
-			auto hash (block->hash ());
-			if (connection->node->config.logging.bulk_pull_logging ())
-			{
-				std::string block_l;
-				block->serialize_json (block_l);
-				BOOST_LOG (connection->node->log) << boost::str (boost::format ("Pulled block %1% %2%") % hash.to_string () % block_l);
-			}
-			// Is block expected?
-			bool block_expected (false);
-			if (hash == expected)
-			{
-				expected = block->previous ();
-				block_expected = true;
-			}
-			else
-			{
-				unexpected_count++;
-			}
-			if (total_blocks == 0 && block_expected)
-			{
-				known_account = block->account ();
-			}
-			if (connection->block_count++ == 0)
-			{
-				connection->start_time = std::chrono::steady_clock::now ();
-			}
-			connection->attempt->total_blocks++;
-			total_blocks++;
-			bool stop_pull (connection->attempt->process_block (block, known_account, total_blocks, block_expected));
-			if (!stop_pull && !connection->hard_stop.load ())
-			{
-				/* Process block in lazy pull if not stopped
-				Stop usual pull request with unexpected block & more than 16k blocks processed
-				to prevent spam */
-				if (connection->attempt->mode != xpeed::bootstrap_mode::legacy || unexpected_count < 16384)
-				{
-					receive_block ();
-				}
-			}
-			else if (stop_pull && block_expected)
-			{
-				expected = pull.end;
-				connection->attempt->pool_connection (connection);
-			}
-			if (stop_pull)
-			{
-				connection->attempt->lazy_stopped++;
-			}
+			auto epoch (block.type () == xpeed::block_type::state && ledger.is_epoch_link (block.link ()));
+			indices.push_back (i);
+			epochs.push_back (epoch);
+			hashes.push_back (block.hash ());
+			accounts.push_back (epoch ? ledger.epoch_signer : block.account ());
+			signatures.push_back (block.block_signature ());
 		}
-		else
+	}
+	auto result (false);
+	if (!indices.empty ())
+	{
+		auto size (indices.size ());
+		std::vector<unsigned char const *> messages;
+		std::vector<size_t> lengths (size, sizeof (xpeed::block_hash));
+		std::vector<unsigned char const *> pub_keys;
+		std::vector<unsigned char const *> signature_bytes;
+		std::vector<int> verifications (size, 0);
+		for (size_t i (0); i != size; ++i)
 		{
-			if (connection->node->config.logging.bulk_pull_logging ())
+			messages.push_back (hashes[i].bytes.data ());
+			pub_keys.push_back (accounts[i].bytes.data ());
+			signature_bytes.push_back (signatures[i].bytes.data ());
+		}
+		xpeed::signature_check_set check = { size, messages.data (), lengths.data (), pub_keys.data (), signature_bytes.data (), verifications.data () };
+		connection->node->checker.verify (check);
+		for (size_t i (0); i != size && !result; ++i)
+		{
+			if (verifications[i] == 1)
 			{
-				BOOST_LOG (connection->node->log) << "Error deserializing block received from pull request";
+				verified_a[indices[i]] = epochs[i] ? xpeed::signature_verification::valid_epoch : xpeed::signature_verification::valid;
 			}
+			else if (!epochs[i])
+			{
+				result = true;
+			}
+			// A state block with the epoch link which isn't signed by the epoch signer can still be a send, the ledger decides
 		}
+		connection->node->stats.add (xpeed::stat::type::bootstrap, xpeed::stat::detail::blocks_verified, xpeed::stat::dir::in, size);
+	}
+	return result;
+}
+
+bool xpeed::bulk_pull_client::received_block (std::shared_ptr<xpeed::block> block_a, xpeed::signature_verification verified_a)
+{
+	auto hash (block_a->hash ());
+	if (connection->node->config.logging.bulk_pull_logging ())
+	{
+		std::string block_l;
+		block_a->serialize_json (block_l);
+		BOOST_LOG (connection->node->log) << boost::str (boost::format ("Pulled block %1% %2%") % hash.to_string () % block_l);
+	}
+	// Is block expected?
+	bool block_expected (false);
+	if (hash == expected)
+	{
+		expected = block_a->previous ();
+		block_expected = true;
 	}
 	else
 	{
-		if (connection->node->config.logging.bulk_pull_logging ())
+		unexpected_count++;
+	}
+	if (total_blocks == 0 && block_expected)
+	{
+		known_account = block_a->account ();
+	}
+	if (connection->block_count++ == 0)
+	{
+		connection->start_time = std::chrono::steady_clock::now ();
+	}
+	connection->attempt->total_blocks++;
+	total_blocks++;
+	auto result (true);
+	bool stop_pull (connection->attempt->process_block (block_a, known_account, total_blocks, block_expected, verified_a));
+	if (!stop_pull && !connection->hard_stop.load ())
+	{
+		/* Process block in lazy pull if not stopped
+		Stop usual pull request with unexpected block & more than 16k blocks processed
+		to prevent spam */
+		if (!connection->attempt->pulls_chains () || unexpected_count < 16384)
 		{
-			BOOST_LOG (connection->node->log) << boost::str (boost::format ("Error bulk receiving block: %1%") % ec.message ());
+			result = false;
 		}
 	}
+	else if (stop_pull && block_expected)
+	{
+		expected = pull.end;
+		connection->attempt->pool_connection (connection);
+	}
+	if (stop_pull)
+	{
+		connection->attempt->lazy_stopped++;
+	}
+	return result;
 }
 
 xpeed::bulk_push_client::bulk_push_client (std::shared_ptr<xpeed::bootstrap_client> const & connection_a) :
@@ -892,11 +1065,144 @@ void xpeed::bulk_pull_account_client::receive_pending ()
 	});
 }
 
+xpeed::account_probe_client::account_probe_client (std::shared_ptr<xpeed::bootstrap_client> connection_a, xpeed::probe_batch const & batch_a) :
+connection (connection_a),
+accounts (batch_a.accounts),
+attempts (batch_a.attempts),
+current (0),
+frontier_read (false),
+done (false)
+{
+	assert (!accounts.empty ());
+	connection->attempt->condition.notify_all ();
+}
+
+xpeed::account_probe_client::~account_probe_client ()
+{
+	if (!done)
+	{
+		// Accounts answered before the failure keep their pulls, the rest are probed again
+		connection->attempt->add_pulls (pulls);
+		auto answered (current + (frontier_read ? 1 : 0));
+		if (answered < accounts.size ())
+		{
+			connection->attempt->requeue_probe (xpeed::probe_batch{ std::vector<std::pair<xpeed::account, xpeed::block_hash>> (accounts.begin () + answered, accounts.end ()), attempts + 1 });
+		}
+	}
+	{
+		std::lock_guard<std::mutex> mutex (connection->attempt->mutex);
+		auto & probing (connection->attempt->ascending_probing);
+		probing.erase (probing.find (accounts.front ().first));
+		--connection->attempt->pulling;
+	}
+	connection->attempt->condition.notify_all ();
+}
+
+void xpeed::account_probe_client::request ()
+{
+	auto buffer (std::make_shared<std::vector<uint8_t>> ());
+	{
+		xpeed::vectorstream stream (*buffer);
+		for (auto & account : accounts)
+		{
+			xpeed::bulk_pull_account req;
+			req.account = account.first;
+			req.minimum_amount = std::numeric_limits<xpeed::uint128_t>::max ();
+			req.flags = xpeed::bulk_pull_account_flags::pending_hash_and_amount;
+			req.serialize (stream);
+		}
+	}
+	if (connection->node->config.logging.bulk_pull_logging ())
+	{
+		BOOST_LOG (connection->node->log) << boost::str (boost::format ("Probing frontiers of %1% accounts from %2% starting at %3%") % accounts.size () % connection->endpoint % accounts.front ().first.to_account ());
+	}
+	auto this_l (shared_from_this ());
+	connection->socket->async_write (buffer, [this_l](boost::system::error_code const & ec, size_t size_a) {
+		if (!ec)
+		{
+			this_l->receive_frontier ();
+		}
+		else
+		{
+			if (this_l->connection->node->config.logging.bulk_pull_logging ())
+			{
+				BOOST_LOG (this_l->connection->node->log) << boost::str (boost::format ("Error starting account probe to %1%: %2%") % this_l->connection->endpoint % ec.message ());
+			}
+		}
+	});
+}
+
+void xpeed::account_probe_client::receive_frontier ()
+{
+	auto this_l (shared_from_this ());
+	connection->socket->async_read (connection->receive_buffer, size_entry, [this_l](boost::system::error_code const & ec, size_t size_a) {
+		if (!ec && size_a == size_entry)
+		{
+			xpeed::block_hash hash;
+			xpeed::bufferstream stream (this_l->connection->receive_buffer->data (), sizeof (xpeed::uint256_union));
+			auto error (xpeed::try_read (stream, hash));
+			assert (!error);
+			this_l->received_frontier (hash);
+		}
+		else
+		{
+			if (this_l->connection->node->config.logging.network_logging ())
+			{
+				BOOST_LOG (this_l->connection->node->log) << boost::str (boost::format ("Error while receiving account probe from %1%: %2%") % this_l->connection->endpoint % ec.message ());
+			}
+		}
+	});
+}
+
+void xpeed::account_probe_client::received_frontier (xpeed::block_hash const & hash_a)
+{
+	auto attempt (connection->attempt);
+	if (!frontier_read)
+	{
+		frontier_read = true;
+		auto & account (accounts[current]);
+		// A zero frontier is an account the peer doesn't know
+		if (!hash_a.is_zero () && hash_a != account.second)
+		{
+			auto transaction (connection->node->store.tx_begin_read ());
+			// Having the peer's frontier means the peer is behind us on this account
+			if (!connection->node->store.block_exists (transaction, hash_a))
+			{
+				pulls.push_back (xpeed::pull_info (account.first, hash_a, account.second));
+			}
+		}
+		receive_frontier ();
+	}
+	else if (!hash_a.is_zero ())
+	{
+		// No pending entry reaches the minimum amount asked for, a peer sending some anyway is read past
+		receive_frontier ();
+	}
+	else
+	{
+		frontier_read = false;
+		++current;
+		++attempt->ascending_probed;
+		if (current < accounts.size ())
+		{
+			receive_frontier ();
+		}
+		else
+		{
+			done = true;
+			attempt->ascending_differing += pulls.size ();
+			attempt->add_pulls (pulls);
+			attempt->pool_connection (connection);
+		}
+	}
+}
+
 xpeed::pull_info::pull_info () :
 account (0),
 end (0),
 count (0),
-attempts (0)
+attempts (0),
+processed (0)
 {
 }
 
@@ -905,12 +1211,14 @@ account (account_a),
 head (head_a),
 end (end_a),
 count (count_a),
-attempts (0)
+attempts (0),
+processed (0)
 {
 }
 
 xpeed::bootstrap_attempt::bootstrap_attempt (std::shared_ptr<xpeed::node> node_a) :
 next_log (std::chrono::steady_clock::now ()),
+pull_times (bootstrap_pull_times_max),
 connections (0),
 pulling (0),
 node (node_a),
@@ -919,7 +1227,16 @@ total_blocks (0),
 runs_count (0),
 stopped (false),
 mode (xpeed::bootstrap_mode::legacy),
-lazy_stopped (0)
+completed (false),
+next_checkpoint (std::chrono::steady_clock::now () + bootstrap_checkpoint_interval),
+checkpoint_sequence (0),
+checkpoint_written (0),
+lazy_spill_failed (false),
+lazy_stopped (0),
+ascending_next (0),
+ascending_exhausted (false),
+ascending_probed (0),
+ascending_differing (0)
 {
 	BOOST_LOG (node->log) << "Starting bootstrap attempt";
 	node->bootstrap_initiator.notify_listeners (true);
@@ -944,40 +1261,86 @@ bool xpeed::bootstrap_attempt::should_log ()
 	return result;
 }
 
-bool xpeed::bootstrap_attempt::request_frontier (std::unique_lock<std::mutex> & lock_a)
+void xpeed::bootstrap_attempt::request_frontiers (std::unique_lock<std::mutex> & lock_a)
 {
-	auto result (true);
-	auto connection_l (connection (lock_a));
-	connection_frontier_request = connection_l;
-	if (connection_l)
+	// Ranges restored from a checkpoint are kept, only the ones which weren't finished are requested again
+	if (frontier_ranges.empty ())
 	{
-		std::future<bool> future;
-		{
-			auto client (std::make_shared<xpeed::frontier_req_client> (connection_l));
-			client->run ();
-			frontiers = client;
-			future = client->promise.get_future ();
-		}
-		lock_a.unlock ();
-		result = consume_future (future); // This is out of scope of `client' so when the last reference via boost::asio::io_context is lost and the client is destroyed, the future throws an exception.
-		lock_a.lock ();
-		if (result)
+		// Account numbers are public keys so equal slices of the account space hold about as many accounts each
+		auto count (std::max (1U, node->config.bootstrap_connections));
+		xpeed::uint256_t step (std::numeric_limits<xpeed::uint256_t>::max () / count);
+		for (auto i (0U); i < count; ++i)
 		{
-			pulls.clear ();
+			xpeed::account start (i == 0 ? 0 : step * i);
+			xpeed::account end (i + 1 == count ? 0 : step * (i + 1));
+			frontier_ranges.push_back (std::make_shared<xpeed::frontier_range> (start, end));
 		}
-		if (node->config.logging.network_logging ())
+	}
+	auto first (std::find_if (frontier_ranges.begin (), frontier_ranges.end (), [](std::shared_ptr<xpeed::frontier_range> const & range_a) { return !range_a->done; }));
+	if (first != frontier_ranges.end ())
+	{
+		// Wait for the first connection, the rest of the ranges are started as more become idle
+		request_frontier (lock_a, *first);
+	}
+	update_frontier_ranges (lock_a);
+}
+
+void xpeed::bootstrap_attempt::request_frontier (std::unique_lock<std::mutex> & lock_a, std::shared_ptr<xpeed::frontier_range> range_a)
+{
+	auto connection_l (connection (lock_a));
+	if (connection_l)
+	{
+		auto client (std::make_shared<xpeed::frontier_req_client> (connection_l, range_a));
+		client->run ();
+		range_a->client = client;
+		range_a->connection = connection_l;
+		range_a->endpoint = connection_l->endpoint;
+		range_a->future = client->promise.get_future ();
+		++range_a->attempts;
+	}
+}
+
+void xpeed::bootstrap_attempt::update_frontier_ranges (std::unique_lock<std::mutex> & lock_a)
+{
+	for (auto & range : frontier_ranges)
+	{
+		if (!range->done && range->future.valid () && range->future.wait_for (std::chrono::seconds (0)) == std::future_status::ready)
 		{
-			if (!result)
+			auto error (consume_future (range->future));
+			if (!error)
 			{
-				BOOST_LOG (node->log) << boost::str (boost::format ("Completed frontier request, %1% out of sync accounts according to %2%") % pulls.size () % connection_l->endpoint);
+				range->done = true;
+				if (range->end.is_zero ())
+				{
+					// Only the last range ends with the frontier_req, its connection is used to push
+					connection_frontier_request = range->connection;
+				}
 			}
-			else
+			if (node->config.logging.network_logging ())
 			{
-				BOOST_LOG (node->log) << "frontier_req failed, reattempting";
+				if (!error)
+				{
+					BOOST_LOG (node->log) << boost::str (boost::format ("Completed frontier request for range %1% to %2%, %3% frontiers from %4%") % range->start.to_string () % range->end.to_string () % range->frontiers % range->endpoint);
+				}
+				else
+				{
+					BOOST_LOG (node->log) << boost::str (boost::format ("frontier_req failed for range %1% to %2%, reattempting") % range->start.to_string () % range->end.to_string ());
+				}
 			}
 		}
+		if (!stopped && !range->done && !range->future.valid () && !idle.empty ())
+		{
+			range->frontiers = 0;
+			range->position = static_cast<uint64_t> (range->start.number () >> 192);
+			request_frontier (lock_a, range);
+		}
 	}
-	return result;
+}
+
+size_t xpeed::bootstrap_attempt::frontier_ranges_pending ()
+{
+	assert (!mutex.try_lock ());
+	return std::count_if (frontier_ranges.begin (), frontier_ranges.end (), [](std::shared_ptr<xpeed::frontier_range> const & range_a) { return !range_a->done; });
 }
 
 void xpeed::bootstrap_attempt::request_pull (std::unique_lock<std::mutex> & lock_a)
@@ -987,17 +1350,32 @@ void xpeed::bootstrap_attempt::request_pull (std::unique_lock<std::mutex> & lock
 	{
 		auto pull (pulls.front ());
 		pulls.pop_front ();
-		if (mode != xpeed::bootstrap_mode::legacy)
+		if (!pulls_chains ())
 		{
 			// Check if pull is obsolete (head was processed)
 			std::unique_lock<std::mutex> lock (lazy_mutex);
 			auto transaction (node->store.tx_begin_read ());
-			while (!pulls.empty () && !pull.head.is_zero () && (lazy_blocks.find (pull.head) != lazy_blocks.end () || node->store.block_exists (transaction, pull.head)))
+			while (!pulls.empty () && !pull.head.is_zero () && (lazy_blocks.exists (pull.head) || node->store.block_exists (transaction, pull.head)))
 			{
 				pull = pulls.front ();
 				pulls.pop_front ();
 			}
 		}
+		else if (pull.count == 0)
+		{
+			// Pull long chains a chunk at a time so each chunk can go to whichever peer is fastest at the time
+			pull.count = bootstrap_pull_chunk_blocks;
+		}
+		if (pull.processed > 0)
+		{
+			auto best (std::max_element (idle.begin (), idle.end (), [](std::shared_ptr<xpeed::bootstrap_client> const & lhs, std::shared_ptr<xpeed::bootstrap_client> const & rhs) {
+				return lhs->score < rhs->score;
+			}));
+			if (best != idle.end () && (*best)->score > connection_l->score)
+			{
+				std::swap (*best, connection_l);
+			}
+		}
 		++pulling;
 		// The bulk_pull_client destructor attempt to requeue_pull which can cause a deadlock if this is the last reference
 		// Dispatch request in an external thread in case it needs to be destroyed
@@ -1038,7 +1416,7 @@ bool xpeed::bootstrap_attempt::still_pulling ()
 {
 	assert (!mutex.try_lock ());
 	auto running (!stopped);
-	auto more_pulls (!pulls.empty ());
+	auto more_pulls (!pulls.empty () || frontier_ranges_pending () > 0);
 	auto still_pulling (pulling > 0);
 	return running && (more_pulls || still_pulling);
 }
@@ -1047,25 +1425,12 @@ void xpeed::bootstrap_attempt::run ()
 {
 	populate_connections ();
 	std::unique_lock<std::mutex> lock (mutex);
-	auto frontier_failure (true);
-	while (!stopped && frontier_failure)
-	{
-		frontier_failure = request_frontier (lock);
-	}
-	// Shuffle pulls.
-	release_assert (std::numeric_limits<CryptoPP::word32>::max () > pulls.size ());
-	if (!pulls.empty ())
-	{
-		for (auto i = static_cast<CryptoPP::word32> (pulls.size () - 1); i > 0; --i)
-		{
-			auto k = xpeed::random_pool::generate_word32 (0, i);
-			std::swap (pulls[i], pulls[k]);
-		}
-	}
+	request_frontiers (lock);
 	while (still_pulling ())
 	{
 		while (still_pulling ())
 		{
+			update_frontier_ranges (lock);
 			if (!pulls.empty ())
 			{
 				if (!node->block_processor.full ())
@@ -1077,6 +1442,11 @@ void xpeed::bootstrap_attempt::run ()
 					condition.wait_for (lock, std::chrono::seconds (15));
 				}
 			}
+			else if (frontier_ranges_pending () > 0)
+			{
+				// A frontier client which is destroyed without finishing doesn't notify
+				condition.wait_for (lock, std::chrono::seconds (1));
+			}
 			else
 			{
 				condition.wait (lock);
@@ -1092,6 +1462,7 @@ void xpeed::bootstrap_attempt::run ()
 	if (!stopped)
 	{
 		BOOST_LOG (node->log) << "Completed pulls";
+		completed = true;
 		request_push (lock);
 		runs_count++;
 		// Start wallet lazy bootstrap if required
@@ -1179,6 +1550,8 @@ void xpeed::bootstrap_attempt::populate_connections ()
 	{
 		std::unique_lock<std::mutex> lock (mutex);
 		num_pulls = pulls.size ();
+		// Penalized peers count as connected so no new connection goes to them
+		endpoints.insert (penalized.begin (), penalized.end ());
 		std::deque<std::weak_ptr<xpeed::bootstrap_client>> new_clients;
 		for (auto & c : clients)
 		{
@@ -1189,6 +1562,19 @@ void xpeed::bootstrap_attempt::populate_connections ()
 				double elapsed_sec = client->elapsed_seconds ();
 				auto blocks_per_sec = client->block_rate ();
 				rate_sum += blocks_per_sec;
+				auto now (std::chrono::steady_clock::now ());
+				auto blocks (client->block_count.load ());
+				if (std::find (idle.begin (), idle.end (), client) == idle.end ())
+				{
+					// Only time spent working counts, a fast peer waiting for pulls keeps its score
+					auto interval (std::chrono::duration<double> (now - client->score_time).count ());
+					if (interval > 0.0)
+					{
+						client->score = client->score * (1.0 - bootstrap_score_weight) + bootstrap_score_weight * (blocks - client->score_blocks) / interval;
+					}
+				}
+				client->score_blocks = blocks;
+				client->score_time = now;
 				if (client->elapsed_seconds () > bootstrap_connection_warmup_time_sec && client->block_count > 0)
 				{
 					sorted_connections.push (client);
@@ -1208,6 +1594,7 @@ void xpeed::bootstrap_attempt::populate_connections ()
 		}
 		// Cleanup expired clients
 		clients.swap (new_clients);
+		steal_pull (lock);
 	}
 
 	auto target = target_connections (num_pulls);
@@ -1241,7 +1628,7 @@ void xpeed::bootstrap_attempt::populate_connections ()
 	if (node->config.logging.bulk_pull_logging ())
 	{
 		std::unique_lock<std::mutex> lock (mutex);
-		BOOST_LOG (node->log) << boost::str (boost::format ("Bulk pull connections: %1%, rate: %2% blocks/sec, remaining account pulls: %3%, total blocks: %4%") % connections.load () % (int)rate_sum % pulls.size () % (int)total_blocks.load ());
+		BOOST_LOG (node->log) << boost::str (boost::format ("Bulk pull connections: %1%, rate: %2% blocks/sec, remaining account pulls: %3%, total blocks: %4%, pull time p50/p90/p99: %5%/%6%/%7% ms") % connections.load () % (int)rate_sum % pulls.size () % (int)total_blocks.load () % (int)pull_time_percentile (0.5) % (int)pull_time_percentile (0.9) % (int)pull_time_percentile (0.99));
 	}
 
 	if (connections < target)
@@ -1269,6 +1656,11 @@ void xpeed::bootstrap_attempt::populate_connections ()
 			}
 		}
 	}
+	if (!stopped && std::chrono::steady_clock::now () >= next_checkpoint)
+	{
+		next_checkpoint = std::chrono::steady_clock::now () + bootstrap_checkpoint_interval;
+		checkpoint (true);
+	}
 	if (!stopped)
 	{
 		std::weak_ptr<xpeed::bootstrap_attempt> this_w (shared_from_this ());
@@ -1281,6 +1673,18 @@ void xpeed::bootstrap_attempt::populate_connections ()
 	}
 }
 
+void xpeed::bootstrap_attempt::penalize (std::shared_ptr<xpeed::bootstrap_client> client_a)
+{
+	node->stats.inc (xpeed::stat::type::bootstrap, xpeed::stat::detail::peer_penalized, xpeed::stat::dir::in);
+	if (node->config.logging.bulk_pull_logging ())
+	{
+		BOOST_LOG (node->log) << boost::str (boost::format ("Dropping peer %1% for sending invalid blocks") % client_a->endpoint);
+	}
+	client_a->stop (true);
+	std::lock_guard<std::mutex> lock (mutex);
+	penalized.insert (client_a->endpoint);
+}
+
 void xpeed::bootstrap_attempt::add_connection (xpeed::endpoint const & endpoint_a)
 {
 	auto client (std::make_shared<xpeed::bootstrap_client> (node, shared_from_this (), xpeed::tcp_endpoint (endpoint_a.address (), endpoint_a.port ())));
@@ -1311,14 +1715,17 @@ void xpeed::bootstrap_attempt::stop ()
 			client->socket->close ();
 		}
 	}
-	if (auto i = frontiers.lock ())
+	for (auto & range : frontier_ranges)
 	{
-		try
-		{
-			i->promise.set_value (true);
-		}
-		catch (std::future_error &)
+		if (auto i = range->client.lock ())
 		{
+			try
+			{
+				i->promise.set_value (true);
+			}
+			catch (std::future_error &)
+			{
+			}
 		}
 	}
 	if (auto i = push.lock ())
@@ -1342,6 +1749,24 @@ void xpeed::bootstrap_attempt::add_pull (xpeed::pull_info const & pull)
 	condition.notify_all ();
 }
 
+void xpeed::bootstrap_attempt::add_pulls (std::vector<xpeed::pull_info> & pulls_a)
+{
+	release_assert (std::numeric_limits<CryptoPP::word32>::max () > pulls_a.size ());
+	if (!pulls_a.empty ())
+	{
+		for (auto i = static_cast<CryptoPP::word32> (pulls_a.size () - 1); i > 0; --i)
+		{
+			auto k = xpeed::random_pool::generate_word32 (0, i);
+			std::swap (pulls_a[i], pulls_a[k]);
+		}
+	}
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		pulls.insert (pulls.end (), pulls_a.begin (), pulls_a.end ());
+	}
+	condition.notify_all ();
+}
+
 void xpeed::bootstrap_attempt::requeue_pull (xpeed::pull_info const & pull_a)
 {
 	auto pull (pull_a);
@@ -1370,10 +1795,361 @@ void xpeed::bootstrap_attempt::requeue_pull (xpeed::pull_info const & pull_a)
 	}
 }
 
-void xpeed::bootstrap_attempt::add_bulk_push_target (xpeed::block_hash const & head, xpeed::block_hash const & end)
+void xpeed::bootstrap_attempt::steal_pull (std::unique_lock<std::mutex> & lock_a)
+{
+	// Only worth it once there's nothing else for idle peers to do, wallet pulls aren't resumable
+	if (pulls.empty () && !idle.empty () && mode != xpeed::bootstrap_mode::wallet_lazy)
+	{
+		auto best (std::max_element (idle.begin (), idle.end (), [](std::shared_ptr<xpeed::bootstrap_client> const & lhs, std::shared_ptr<xpeed::bootstrap_client> const & rhs) {
+			return lhs->score < rhs->score;
+		}));
+		std::shared_ptr<xpeed::bootstrap_client> slowest;
+		for (auto & c : clients)
+		{
+			auto client (c.lock ());
+			if (client != nullptr && !client->pending_stop && client->block_count > 0 && client->elapsed_seconds () > bootstrap_connection_warmup_time_sec && client->score < (*best)->score * bootstrap_lagging_ratio && std::find (idle.begin (), idle.end (), client) == idle.end ())
+			{
+				auto requesting_frontiers (std::any_of (frontier_ranges.begin (), frontier_ranges.end (), [&client](std::shared_ptr<xpeed::frontier_range> const & range_a) {
+					return !range_a->done && range_a->connection.lock () == client;
+				}));
+				if (!requesting_frontiers && (slowest == nullptr || client->score < slowest->score))
+				{
+					slowest = client;
+				}
+			}
+		}
+		if (slowest != nullptr)
+		{
+			if (node->config.logging.bulk_pull_logging ())
+			{
+				BOOST_LOG (node->log) << boost::str (boost::format ("Handing pull from %1% at %2$.1f blocks/sec to %3% at %4$.1f blocks/sec") % slowest->endpoint % slowest->score % (*best)->endpoint % (*best)->score);
+			}
+			// The bulk_pull_client requeues the rest of the chain from the last block received once its read is aborted
+			slowest->lagging = true;
+			slowest->stop (true);
+			auto socket (slowest->socket);
+			node->background ([socket]() {
+				socket->close ();
+			});
+		}
+	}
+}
+
+void xpeed::bootstrap_attempt::add_continuation (xpeed::pull_info const & pull_a)
+{
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		pulls.push_front (pull_a);
+	}
+	condition.notify_all ();
+}
+
+void xpeed::bootstrap_attempt::pull_finished (std::chrono::steady_clock::duration const & duration_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	pull_times.push_back (std::chrono::duration<double, std::milli> (duration_a).count ());
+}
+
+double xpeed::bootstrap_attempt::pull_time_percentile (double percentile_a)
+{
+	auto result (0.0);
+	if (!pull_times.empty ())
+	{
+		std::vector<double> sorted (pull_times.begin (), pull_times.end ());
+		auto index (std::min (sorted.size () - 1, static_cast<size_t> (percentile_a * sorted.size ())));
+		std::nth_element (sorted.begin (), sorted.begin () + index, sorted.end ());
+		result = sorted[index];
+	}
+	return result;
+}
+
+void xpeed::bootstrap_attempt::add_bulk_push_target (xpeed::block_hash const & head, xpeed::block_hash const & end)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	bulk_push_targets.push_back (std::make_pair (head, end));
+}
+
+void xpeed::bootstrap_attempt::checkpoint (bool background_a)
+{
+	std::vector<std::vector<uint8_t>> records;
+	auto record ([&records](checkpoint_record type_a) -> std::vector<uint8_t> & {
+		records.emplace_back (1, static_cast<uint8_t> (type_a));
+		return records.back ();
+	});
+	// A legacy bootstrap can queue millions of pulls, only a prefix is saved so the checkpoint stays cheap to take and write
+	size_t pulls_saved (0);
+	auto add_pull ([&record, &pulls_saved](xpeed::pull_info const & pull_a) {
+		if (pulls_saved < bootstrap_checkpoint_pulls_max)
+		{
+			++pulls_saved;
+			xpeed::vectorstream stream (record (checkpoint_record::pull));
+			xpeed::write (stream, pull_a.account);
+			xpeed::write (stream, pull_a.head);
+			xpeed::write (stream, pull_a.end);
+			xpeed::write (stream, pull_a.count);
+			xpeed::write (stream, pull_a.attempts);
+			xpeed::write (stream, pull_a.processed);
+		}
+	});
+	auto wallet (false);
+	uint64_t sequence;
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		sequence = ++checkpoint_sequence;
+		wallet = mode == xpeed::bootstrap_mode::wallet_lazy;
+		if (!wallet)
+		{
+			{
+				xpeed::vectorstream stream (record (checkpoint_record::mode));
+				xpeed::write (stream, static_cast<uint8_t> (mode));
+			}
+			for (auto & pull : pulls)
+			{
+				add_pull (pull);
+			}
+			// Pulls being received are saved as they were requested, a resumed attempt repeats whatever of them arrived
+			for (auto & pull : pulls_in_progress)
+			{
+				add_pull (pull.second);
+			}
+			// Pulls past the saved prefix are found again by requesting every range's frontiers or probing from the start
+			auto truncated (pulls.size () + pulls_in_progress.size () > pulls_saved);
+			// Frontiers of a range only become pulls once the whole range is received, there's no cursor within a range worth saving
+			for (auto & range : frontier_ranges)
+			{
+				xpeed::vectorstream stream (record (checkpoint_record::frontier_range));
+				xpeed::write (stream, range->start);
+				xpeed::write (stream, range->end);
+				xpeed::write (stream, static_cast<uint8_t> (range->done && !truncated));
+			}
+			for (auto & target : bulk_push_targets)
+			{
+				xpeed::vectorstream stream (record (checkpoint_record::bulk_push_target));
+				xpeed::write (stream, target.first);
+				xpeed::write (stream, target.second);
+			}
+			if (mode == xpeed::bootstrap_mode::ascending && !truncated)
+			{
+				// Probing resumes from the first account of any batch not fully answered yet
+				auto cursor (ascending_exhausted ? xpeed::account (0) : ascending_next);
+				auto pending (!ascending_exhausted);
+				auto earlier ([&cursor, &pending](xpeed::account const & account_a) {
+					if (!pending || account_a < cursor)
+					{
+						cursor = account_a;
+						pending = true;
+					}
+				});
+				if (!ascending_probing.empty ())
+				{
+					earlier (*ascending_probing.begin ());
+				}
+				for (auto & batch : ascending_batches)
+				{
+					earlier (batch.accounts.front ().first);
+				}
+				if (!pending || !cursor.is_zero ())
+				{
+					xpeed::vectorstream stream (record (checkpoint_record::ascending_cursor));
+					xpeed::write (stream, cursor);
+					xpeed::write (stream, static_cast<uint8_t> (!pending));
+				}
+			}
+			std::lock_guard<std::mutex> lazy_lock (lazy_mutex);
+			for (auto & key : lazy_keys)
+			{
+				xpeed::vectorstream stream (record (checkpoint_record::lazy_key));
+				xpeed::write (stream, key);
+			}
+			// Spilled lazy pulls aren't saved, pulling from the keys again finds them
+			std::vector<xpeed::block_hash> lazy_pulls_l;
+			lazy_pulls.pop_front (lazy_pulls_l, lazy_pulls.memory_size ());
+			for (auto & hash : lazy_pulls_l)
+			{
+				lazy_pulls.push_back (hash);
+				xpeed::vectorstream stream (record (checkpoint_record::lazy_pull));
+				xpeed::write (stream, hash);
+			}
+		}
+	}
+	// Nothing but the mode and unfinished frontier ranges is the same as starting over
+	auto progress (std::any_of (records.begin (), records.end (), [](std::vector<uint8_t> const & record_a) {
+		return record_a[0] != static_cast<uint8_t> (checkpoint_record::mode) && (record_a[0] != static_cast<uint8_t> (checkpoint_record::frontier_range) || record_a.back () != 0);
+	}));
+	if (!wallet)
+	{
+		if (!progress)
+		{
+			records.clear ();
+		}
+		if (background_a)
+		{
+			auto this_l (shared_from_this ());
+			auto records_l (std::make_shared<std::vector<std::vector<uint8_t>>> (std::move (records)));
+			node->background ([this_l, sequence, records_l]() {
+				this_l->checkpoint_write (sequence, *records_l);
+			});
+		}
+		else
+		{
+			checkpoint_write (sequence, records);
+		}
+	}
+}
+
+void xpeed::bootstrap_attempt::checkpoint_write (uint64_t sequence_a, std::vector<std::vector<uint8_t>> const & records_a)
+{
+	std::lock_guard<std::mutex> lock (checkpoint_mutex);
+	// A background write running late mustn't replace a newer checkpoint or bring one back after checkpoint_clear
+	if (sequence_a > checkpoint_written)
+	{
+		checkpoint_written = sequence_a;
+		auto transaction (node->store.tx_begin_write ());
+		node->store.bootstrap_checkpoint_put (transaction, records_a);
+		if (node->config.logging.bulk_pull_logging ())
+		{
+			BOOST_LOG (node->log) << boost::str (boost::format ("Saved bootstrap checkpoint of %1% records") % records_a.size ());
+		}
+	}
+}
+
+void xpeed::bootstrap_attempt::restore ()
+{
+	std::vector<std::vector<uint8_t>> records;
+	{
+		auto transaction (node->store.tx_begin_read ());
+		records = node->store.bootstrap_checkpoint_get (transaction);
+	}
+	if (!records.empty ())
+	{
+		size_t restored (0);
+		size_t satisfied (0);
+		auto error (false);
+		auto other_mode (false);
+		std::lock_guard<std::mutex> lock (mutex);
+		std::lock_guard<std::mutex> lazy_lock (lazy_mutex);
+		auto transaction (node->store.tx_begin_read ());
+		for (auto i (records.begin ()), n (records.end ()); i != n && !error && !other_mode; ++i)
+		{
+			xpeed::bufferstream stream (i->data (), i->size ());
+			checkpoint_record type;
+			error = xpeed::try_read (stream, type);
+			if (!error)
+			{
+				switch (type)
+				{
+					case checkpoint_record::mode:
+					{
+						uint8_t mode_l;
+						error = xpeed::try_read (stream, mode_l);
+						// The mode is the first record so nothing was restored yet if it's another one
+						other_mode = !error && static_cast<xpeed::bootstrap_mode> (mode_l) != mode;
+						break;
+					}
+					case checkpoint_record::pull:
+					{
+						xpeed::pull_info pull;
+						error = xpeed::try_read (stream, pull.account) || xpeed::try_read (stream, pull.head) || xpeed::try_read (stream, pull.end) || xpeed::try_read (stream, pull.count) || xpeed::try_read (stream, pull.attempts) || xpeed::try_read (stream, pull.processed);
+						if (!error && !node->store.block_exists (transaction, pull.head))
+						{
+							pulls.push_back (pull);
+							++restored;
+						}
+						else
+						{
+							++satisfied;
+						}
+						break;
+					}
+					case checkpoint_record::frontier_range:
+					{
+						xpeed::account start;
+						xpeed::account end;
+						uint8_t done;
+						error = xpeed::try_read (stream, start) || xpeed::try_read (stream, end) || xpeed::try_read (stream, done);
+						if (!error)
+						{
+							frontier_ranges.push_back (std::make_shared<xpeed::frontier_range> (start, end));
+							frontier_ranges.back ()->done = done != 0;
+						}
+						break;
+					}
+					case checkpoint_record::lazy_key:
+					case checkpoint_record::lazy_pull:
+					{
+						xpeed::block_hash hash;
+						error = xpeed::try_read (stream, hash);
+						if (!error && !node->store.block_exists (transaction, hash))
+						{
+							if (type == checkpoint_record::lazy_key)
+							{
+								lazy_keys.insert (hash);
+							}
+							else
+							{
+								lazy_pulls.push_back (hash);
+							}
+							++restored;
+						}
+						else
+						{
+							++satisfied;
+						}
+						break;
+					}
+					case checkpoint_record::bulk_push_target:
+					{
+						std::pair<xpeed::block_hash, xpeed::block_hash> target;
+						error = xpeed::try_read (stream, target.first) || xpeed::try_read (stream, target.second);
+						if (!error)
+						{
+							bulk_push_targets.push_back (target);
+						}
+						break;
+					}
+					case checkpoint_record::ascending_cursor:
+					{
+						uint8_t exhausted;
+						error = xpeed::try_read (stream, ascending_next) || xpeed::try_read (stream, exhausted);
+						ascending_exhausted = exhausted != 0;
+						break;
+					}
+					default:
+						error = true;
+						break;
+				}
+			}
+		}
+		if (other_mode)
+		{
+			// The checkpoint of another mode is left for that mode to resume until this attempt saves its own
+			BOOST_LOG (node->log) << "Bootstrap checkpoint was saved by another mode, starting over";
+		}
+		else if (!error)
+		{
+			BOOST_LOG (node->log) << boost::str (boost::format ("Resuming bootstrap from checkpoint, %1% entries restored and %2% already in the ledger, %3% of %4% frontier ranges done") % restored % satisfied % (frontier_ranges.size () - frontier_ranges_pending ()) % frontier_ranges.size ());
+		}
+		else
+		{
+			BOOST_LOG (node->log) << "Bootstrap checkpoint is corrupt, starting over";
+			pulls.clear ();
+			frontier_ranges.clear ();
+			bulk_push_targets.clear ();
+			lazy_clear ();
+			ascending_next = 0;
+			ascending_exhausted = false;
+		}
+	}
+}
+
+void xpeed::bootstrap_attempt::checkpoint_clear ()
 {
-	std::lock_guard<std::mutex> lock (mutex);
-	bulk_push_targets.push_back (std::make_pair (head, end));
+	uint64_t sequence;
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		sequence = ++checkpoint_sequence;
+	}
+	checkpoint_write (sequence, std::vector<std::vector<uint8_t>> ());
 }
 
 void xpeed::bootstrap_attempt::lazy_start (xpeed::block_hash const & hash_a)
@@ -1381,7 +2157,7 @@ void xpeed::bootstrap_attempt::lazy_start (xpeed::block_hash const & hash_a)
 	std::unique_lock<std::mutex> lock (lazy_mutex);
 	// Add start blocks, limit 1024 (32k with disabled legacy bootstrap)
 	size_t max_keys (node->flags.disable_legacy_bootstrap ? 32 * 1024 : 1024);
-	if (lazy_keys.size () < max_keys && lazy_keys.find (hash_a) == lazy_keys.end () && lazy_blocks.find (hash_a) == lazy_blocks.end ())
+	if (lazy_keys.size () < max_keys && lazy_keys.find (hash_a) == lazy_keys.end () && !lazy_blocks.exists (hash_a))
 	{
 		lazy_keys.insert (hash_a);
 		lazy_pulls.push_back (hash_a);
@@ -1392,7 +2168,7 @@ void xpeed::bootstrap_attempt::lazy_add (xpeed::block_hash const & hash_a)
 {
 	// Add only unknown blocks
 	assert (!lazy_mutex.try_lock ());
-	if (lazy_blocks.find (hash_a) == lazy_blocks.end ())
+	if (!lazy_blocks.exists (hash_a))
 	{
 		lazy_pulls.push_back (hash_a);
 	}
@@ -1402,16 +2178,24 @@ void xpeed::bootstrap_attempt::lazy_pull_flush ()
 {
 	assert (!mutex.try_lock ());
 	std::unique_lock<std::mutex> lazy_lock (lazy_mutex);
+	auto count (lazy_pulls.size ());
+	if (node->config.bootstrap_lazy_memory != 0)
+	{
+		// Keep the pull queue within an eighth of the lazy memory limit, the rest waits in lazy_pulls which can spill
+		auto max_pulls (std::max<size_t> (1024, static_cast<size_t> (node->config.bootstrap_lazy_memory) * 1024 * 1024 / 8 / sizeof (xpeed::pull_info)));
+		count = std::min (count, max_pulls - std::min (max_pulls, pulls.size ()));
+	}
+	std::vector<xpeed::block_hash> pull_starts;
+	lazy_pulls.pop_front (pull_starts, count);
 	auto transaction (node->store.tx_begin_read ());
-	for (auto & pull_start : lazy_pulls)
+	for (auto & pull_start : pull_starts)
 	{
 		// Recheck if block was already processed
-		if (lazy_blocks.find (pull_start) == lazy_blocks.end () && !node->store.block_exists (transaction, pull_start))
+		if (!lazy_blocks.exists (pull_start) && !node->store.block_exists (transaction, pull_start))
 		{
 			pulls.push_back (xpeed::pull_info (pull_start, pull_start, xpeed::block_hash (0), lazy_max_pull_blocks));
 		}
 	}
-	lazy_pulls.clear ();
 }
 
 bool xpeed::bootstrap_attempt::lazy_finished ()
@@ -1451,6 +2235,57 @@ void xpeed::bootstrap_attempt::lazy_clear ()
 	lazy_stopped = 0;
 }
 
+size_t xpeed::bootstrap_attempt::lazy_memory_bytes () const
+{
+	return lazy_blocks.memory_bytes () + lazy_state_unknown.memory_bytes () + lazy_balances.memory_bytes () + lazy_pulls.memory_bytes ();
+}
+
+void xpeed::bootstrap_attempt::lazy_spill ()
+{
+	assert (!lazy_mutex.try_lock ());
+	auto limit (static_cast<size_t> (node->config.bootstrap_lazy_memory) * 1024 * 1024);
+	if (limit != 0 && !lazy_spill_failed && lazy_memory_bytes () > limit)
+	{
+		auto error (false);
+		if (lazy_spill_store == nullptr)
+		{
+			lazy_spill_store = std::make_unique<xpeed::spill_store> (error, node->application_path / "bootstrap_spill.ldb");
+		}
+		if (!error)
+		{
+			size_t spilled (0);
+			auto largest (std::max ({ lazy_blocks.memory_bytes (), lazy_state_unknown.memory_bytes (), lazy_balances.memory_bytes (), lazy_pulls.memory_bytes () }));
+			if (largest == lazy_blocks.memory_bytes ())
+			{
+				spilled = lazy_blocks.spill (*lazy_spill_store);
+			}
+			else if (largest == lazy_state_unknown.memory_bytes ())
+			{
+				spilled = lazy_state_unknown.spill (*lazy_spill_store);
+			}
+			else if (largest == lazy_balances.memory_bytes ())
+			{
+				spilled = lazy_balances.spill (*lazy_spill_store);
+			}
+			else
+			{
+				spilled = lazy_pulls.spill (*lazy_spill_store);
+			}
+			node->stats.add (xpeed::stat::type::bootstrap, xpeed::stat::detail::lazy_spilled, xpeed::stat::dir::out, spilled);
+			if (node->config.logging.bulk_pull_logging ())
+			{
+				BOOST_LOG (node->log) << boost::str (boost::format ("Spilled %1% lazy bootstrap entries to disk, %2% bytes of lazy state left in memory") % spilled % lazy_memory_bytes ());
+			}
+		}
+		else
+		{
+			BOOST_LOG (node->log) << boost::str (boost::format ("Unable to open %1%, keeping lazy bootstrap state in memory") % lazy_spill_store->path);
+			lazy_spill_store.reset ();
+			lazy_spill_failed = true;
+		}
+	}
+}
+
 void xpeed::bootstrap_attempt::lazy_run ()
 {
 	populate_connections ();
@@ -1494,6 +2329,7 @@ void xpeed::bootstrap_attempt::lazy_run ()
 	if (!stopped)
 	{
 		BOOST_LOG (node->log) << "Completed lazy pulls";
+		completed = true;
 		std::unique_lock<std::mutex> lazy_lock (lazy_mutex);
 		runs_count++;
 		// Start wallet lazy bootstrap if required
@@ -1524,22 +2360,22 @@ void xpeed::bootstrap_attempt::lazy_run ()
 	idle.clear ();
 }
 
-bool xpeed::bootstrap_attempt::process_block (std::shared_ptr<xpeed::block> block_a, xpeed::account const & known_account_a, uint64_t total_blocks, bool block_expected)
+bool xpeed::bootstrap_attempt::process_block (std::shared_ptr<xpeed::block> block_a, xpeed::account const & known_account_a, uint64_t total_blocks, bool block_expected, xpeed::signature_verification verified_a)
 {
 	bool stop_pull (false);
-	if (mode != xpeed::bootstrap_mode::legacy && block_expected)
+	if (!pulls_chains () && block_expected)
 	{
 		auto hash (block_a->hash ());
 		std::unique_lock<std::mutex> lock (lazy_mutex);
 		// Processing new blocks
-		if (lazy_blocks.find (hash) == lazy_blocks.end ())
+		if (!lazy_blocks.exists (hash))
 		{
 			// Search block in ledger (old)
 			auto transaction (node->store.tx_begin_read ());
 			if (!node->store.block_exists (transaction, block_a->type (), hash))
 			{
 				xpeed::uint128_t balance (std::numeric_limits<xpeed::uint128_t>::max ());
-				xpeed::unchecked_info info (block_a, known_account_a, 0, xpeed::signature_verification::unknown);
+				xpeed::unchecked_info info (block_a, known_account_a, 0, verified_a);
 				node->block_processor.add (info);
 				// Search for new dependencies
 				if (!block_a->source ().is_zero () && !node->store.block_exists (transaction, block_a->source ()))
@@ -1563,7 +2399,7 @@ bool xpeed::bootstrap_attempt::process_block (std::shared_ptr<xpeed::block> bloc
 						balance = block_l->hashables.balance.number ();
 						xpeed::block_hash link (block_l->hashables.link);
 						// If link is not epoch link or 0. And if block from link unknown
-						if (!link.is_zero () && link != node->ledger.epoch_link && lazy_blocks.find (link) == lazy_blocks.end () && !node->store.block_exists (transaction, link))
+						if (!link.is_zero () && link != node->ledger.epoch_link && !lazy_blocks.exists (link) && !node->store.block_exists (transaction, link))
 						{
 							xpeed::block_hash previous (block_l->hashables.previous);
 							// If state block previous is 0 then source block required
@@ -1581,34 +2417,34 @@ bool xpeed::bootstrap_attempt::process_block (std::shared_ptr<xpeed::block> bloc
 								}
 							}
 							// Search balance of already processed previous blocks
-							else if (lazy_blocks.find (previous) != lazy_blocks.end ())
+							else if (lazy_blocks.exists (previous))
 							{
-								auto previous_balance (lazy_balances.find (previous));
-								if (previous_balance != lazy_balances.end ())
+								xpeed::uint128_union previous_balance;
+								if (lazy_balances.find (previous, previous_balance))
 								{
-									if (previous_balance->second <= balance)
+									if (previous_balance.number () <= balance)
 									{
 										lazy_add (link);
 									}
-									lazy_balances.erase (previous_balance);
+									lazy_balances.erase (previous);
 								}
 							}
 							// Insert in unknown state blocks if previous wasn't already processed
 							else
 							{
-								lazy_state_unknown.insert (std::make_pair (previous, std::make_pair (link, balance)));
+								lazy_state_unknown.insert (previous, xpeed::lazy_state_backlog_item{ link, balance });
 							}
 						}
 					}
 				}
-				lazy_blocks.insert (hash);
+				lazy_blocks.insert (hash, xpeed::no_value::dummy);
 				// Adding lazy balances
 				if (total_blocks == 0)
 				{
-					lazy_balances.insert (std::make_pair (hash, balance));
+					lazy_balances.insert (hash, balance);
 				}
 				// Removing lazy balances
-				if (!block_a->previous ().is_zero () && lazy_balances.find (block_a->previous ()) != lazy_balances.end ())
+				if (!block_a->previous ().is_zero ())
 				{
 					lazy_balances.erase (block_a->previous ());
 				}
@@ -1625,27 +2461,26 @@ bool xpeed::bootstrap_attempt::process_block (std::shared_ptr<xpeed::block> bloc
 				}
 			}
 			//Search unknown state blocks balances
-			auto find_state (lazy_state_unknown.find (hash));
-			if (find_state != lazy_state_unknown.end ())
+			xpeed::lazy_state_backlog_item next_block;
+			if (lazy_state_unknown.find (hash, next_block))
 			{
-				auto next_block (find_state->second);
 				lazy_state_unknown.erase (hash);
 				// Retrieve balance for previous state blocks
 				if (block_a->type () == xpeed::block_type::state)
 				{
 					std::shared_ptr<xpeed::state_block> block_l (std::static_pointer_cast<xpeed::state_block> (block_a));
-					if (block_l->hashables.balance.number () <= next_block.second)
+					if (block_l->hashables.balance.number () <= next_block.balance.number ())
 					{
-						lazy_add (next_block.first);
+						lazy_add (next_block.link);
 					}
 				}
 				// Retrieve balance for previous legacy send blocks
 				else if (block_a->type () == xpeed::block_type::send)
 				{
 					std::shared_ptr<xpeed::send_block> block_l (std::static_pointer_cast<xpeed::send_block> (block_a));
-					if (block_l->hashables.balance.number () <= next_block.second)
+					if (block_l->hashables.balance.number () <= next_block.balance.number ())
 					{
-						lazy_add (next_block.first);
+						lazy_add (next_block.link);
 					}
 				}
 				// Weak assumption for other legacy block types
@@ -1654,6 +2489,7 @@ bool xpeed::bootstrap_attempt::process_block (std::shared_ptr<xpeed::block> bloc
 					// Disabled
 				}
 			}
+			lazy_spill ();
 		}
 		// Drop bulk_pull if block is already known (processed set)
 		else
@@ -1667,14 +2503,14 @@ bool xpeed::bootstrap_attempt::process_block (std::shared_ptr<xpeed::block> bloc
 			}
 		}
 	}
-	else if (mode != xpeed::bootstrap_mode::legacy)
+	else if (!pulls_chains ())
 	{
 		// Drop connection with unexpected block for lazy bootstrap
 		stop_pull = true;
 	}
 	else
 	{
-		xpeed::unchecked_info info (block_a, known_account_a, 0, xpeed::signature_verification::unknown);
+		xpeed::unchecked_info info (block_a, known_account_a, 0, verified_a);
 		node->block_processor.add (info);
 	}
 	return stop_pull;
@@ -1756,6 +2592,129 @@ void xpeed::bootstrap_attempt::wallet_run ()
 	idle.clear ();
 }
 
+bool xpeed::bootstrap_attempt::pulls_chains () const
+{
+	return mode == xpeed::bootstrap_mode::legacy || mode == xpeed::bootstrap_mode::ascending;
+}
+
+void xpeed::bootstrap_attempt::request_probe (std::unique_lock<std::mutex> & lock_a)
+{
+	auto connection_l (connection (lock_a));
+	if (connection_l)
+	{
+		// The batch is taken only once there's a connection for it so a checkpoint never misses it
+		xpeed::probe_batch batch{ {}, 0 };
+		if (!ascending_batches.empty ())
+		{
+			batch = std::move (ascending_batches.front ());
+			ascending_batches.pop_front ();
+		}
+		else if (!ascending_exhausted)
+		{
+			auto transaction (node->store.tx_begin_read ());
+			for (auto i (node->store.latest_begin (transaction, ascending_next)), n (node->store.latest_end ()); i != n && batch.accounts.size () < bootstrap_ascending_batch; ++i)
+			{
+				xpeed::account_info info (i->second);
+				batch.accounts.push_back (std::make_pair (xpeed::account (i->first), info.head));
+			}
+			if (batch.accounts.size () == bootstrap_ascending_batch)
+			{
+				ascending_next = batch.accounts.back ().first.number () + 1;
+				ascending_exhausted = ascending_next.is_zero ();
+			}
+			else
+			{
+				ascending_exhausted = true;
+			}
+		}
+		if (!batch.accounts.empty ())
+		{
+			ascending_probing.insert (batch.accounts.front ().first);
+			++pulling;
+			// The account_probe_client destructor locks the attempt mutex, dispatch the request in an external thread in case it needs to be destroyed
+			node->background ([connection_l, batch]() {
+				auto client (std::make_shared<xpeed::account_probe_client> (connection_l, batch));
+				client->request ();
+			});
+		}
+		else
+		{
+			idle.push_front (connection_l);
+		}
+	}
+}
+
+void xpeed::bootstrap_attempt::requeue_probe (xpeed::probe_batch const & batch_a)
+{
+	if (batch_a.attempts < bootstrap_frontier_retry_limit)
+	{
+		{
+			std::lock_guard<std::mutex> lock (mutex);
+			ascending_batches.push_front (batch_a);
+		}
+		condition.notify_all ();
+	}
+	else if (node->config.logging.bulk_pull_logging ())
+	{
+		BOOST_LOG (node->log) << boost::str (boost::format ("Failed to probe %1% accounts starting at %2% after %3% attempts") % batch_a.accounts.size () % batch_a.accounts.front ().first.to_account () % batch_a.attempts);
+	}
+}
+
+bool xpeed::bootstrap_attempt::ascending_finished ()
+{
+	assert (!mutex.try_lock ());
+	return ascending_exhausted && ascending_batches.empty () && ascending_probing.empty ();
+}
+
+void xpeed::bootstrap_attempt::ascending_run ()
+{
+	populate_connections ();
+	std::unique_lock<std::mutex> lock (mutex);
+	while (still_pulling () || (!stopped && !ascending_finished ()))
+	{
+		while (still_pulling () || (!stopped && !ascending_finished ()))
+		{
+			// Pulls go first so probing a ledger that's far behind doesn't queue up more than the block processor takes
+			if (!pulls.empty ())
+			{
+				if (!node->block_processor.full ())
+				{
+					request_pull (lock);
+				}
+				else
+				{
+					condition.wait_for (lock, std::chrono::seconds (15));
+				}
+			}
+			else if (!ascending_exhausted || !ascending_batches.empty ())
+			{
+				request_probe (lock);
+			}
+			else
+			{
+				condition.wait (lock);
+			}
+		}
+		// Flushing may resolve forks which can add more pulls
+		lock.unlock ();
+		node->block_processor.flush ();
+		lock.lock ();
+	}
+	if (!stopped)
+	{
+		BOOST_LOG (node->log) << boost::str (boost::format ("Completed ascending pulls, %1% accounts probed and %2% differed") % ascending_probed % ascending_differing);
+		completed = true;
+		runs_count++;
+		if (!node->flags.disable_unchecked_cleanup)
+		{
+			node->unchecked_cleanup ();
+		}
+	}
+	stopped = true;
+	condition.notify_all ();
+	idle.clear ();
+}
+
 xpeed::bootstrap_initiator::bootstrap_initiator (xpeed::node & node_a) :
 node (node_a),
 stopped (false),
@@ -1779,6 +2738,7 @@ void xpeed::bootstrap_initiator::bootstrap ()
 	{
 		node.stats.inc (xpeed::stat::type::bootstrap, xpeed::stat::detail::initiate, xpeed::stat::dir::out);
 		attempt = std::make_shared<xpeed::bootstrap_attempt> (node.shared ());
+		attempt->restore ();
 		condition.notify_all ();
 	}
 }
@@ -1799,6 +2759,7 @@ void xpeed::bootstrap_initiator::bootstrap (xpeed::endpoint const & endpoint_a,
 		}
 		node.stats.inc (xpeed::stat::type::bootstrap, xpeed::stat::detail::initiate, xpeed::stat::dir::out);
 		attempt = std::make_shared<xpeed::bootstrap_attempt> (node.shared ());
+		attempt->restore ();
 		attempt->add_connection (endpoint_a);
 		condition.notify_all ();
 	}
@@ -1821,6 +2782,7 @@ void xpeed::bootstrap_initiator::bootstrap_lazy (xpeed::block_hash const & hash_
 		{
 			attempt = std::make_shared<xpeed::bootstrap_attempt> (node.shared ());
 			attempt->mode = xpeed::bootstrap_mode::lazy;
+			attempt->restore ();
 		}
 		attempt->lazy_start (hash_a);
 	}
@@ -1842,6 +2804,21 @@ void xpeed::bootstrap_initiator::bootstrap_wallet (std::deque<xpeed::account> &
 	condition.notify_all ();
 }
 
+void xpeed::bootstrap_initiator::bootstrap_ascending ()
+{
+	{
+		std::unique_lock<std::mutex> lock (mutex);
+		if (!stopped && attempt == nullptr)
+		{
+			node.stats.inc (xpeed::stat::type::bootstrap, xpeed::stat::detail::initiate_ascending, xpeed::stat::dir::out);
+			attempt = std::make_shared<xpeed::bootstrap_attempt> (node.shared ());
+			attempt->mode = xpeed::bootstrap_mode::ascending;
+			attempt->restore ();
+		}
+	}
+	condition.notify_all ();
+}
+
 void xpeed::bootstrap_initiator::run_bootstrap ()
 {
 	std::unique_lock<std::mutex> lock (mutex);
@@ -1858,10 +2835,23 @@ void xpeed::bootstrap_initiator::run_bootstrap ()
 			{
 				attempt->lazy_run ();
 			}
+			else if (attempt->mode == xpeed::bootstrap_mode::ascending)
+			{
+				attempt->ascending_run ();
+			}
 			else
 			{
 				attempt->wallet_run ();
 			}
+			// A finished attempt leaves nothing to resume, one which was stopped saves where it got to
+			if (attempt->completed)
+			{
+				attempt->checkpoint_clear ();
+			}
+			else
+			{
+				attempt->checkpoint ();
+			}
 			lock.lock ();
 			attempt = nullptr;
 			condition.notify_all ();
@@ -2060,11 +3050,20 @@ xpeed::bootstrap_server::~bootstrap_server ()
 xpeed::bootstrap_server::bootstrap_server (std::shared_ptr<xpeed::socket> socket_a, std::shared_ptr<xpeed::node> node_a) :
 receive_buffer (std::make_shared<std::vector<uint8_t>> ()),
 socket (socket_a),
+remote (socket_a->remote_endpoint ()),
 node (node_a)
 {
 	receive_buffer->resize (512);
 }
 
+void xpeed::bootstrap_server::send (std::shared_ptr<std::vector<uint8_t>> buffer_a, std::function<void(boost::system::error_code const &, size_t)> const & callback_a)
+{
+	auto socket_l (socket);
+	node->serving.send (remote, buffer_a->size (), [socket_l, buffer_a, callback_a]() {
+		socket_l->async_write (buffer_a, callback_a);
+	});
+}
+
 void xpeed::bootstrap_server::receive ()
 {
 	auto this_l (shared_from_this ());
@@ -2195,8 +3194,12 @@ void xpeed::bootstrap_server::receive_keepalive_action (boost::system::error_cod
 		std::unique_ptr<xpeed::keepalive> request (new xpeed::keepalive (error, stream, header_a));
 		if (!error)
 		{
-			add_request (std::unique_ptr<xpeed::message> (request.release ()));
-			receive ();
+			// A realtime channel takes the connection over, otherwise the keepalive is answered like any other
+			if (!header_a.keepalive_is_tcp_realtime () || !node->network.channels.accept (socket, *request))
+			{
+				add_request (std::unique_ptr<xpeed::message> (request.release ()));
+				receive ();
+			}
 		}
 	}
 	else
@@ -2424,30 +3427,77 @@ void xpeed::bulk_pull_server::set_current_end ()
 
 void xpeed::bulk_pull_server::send_next ()
 {
-	auto block (get_next ());
-	if (block != nullptr)
+	if (next_buffer->empty () && !finished)
 	{
-		{
-			send_buffer->clear ();
-			xpeed::vectorstream stream (*send_buffer);
-			xpeed::serialize_block (stream, *block);
-		}
+		fill ();
+	}
+	std::swap (send_buffer, next_buffer);
+	if (!send_buffer->empty ())
+	{
+		outstanding = 2;
 		auto this_l (shared_from_this ());
-		if (connection->node->config.logging.bulk_pull_logging ())
-		{
-			BOOST_LOG (connection->node->log) << boost::str (boost::format ("Sending block: %1%") % block->hash ().to_string ());
-		}
-		connection->socket->async_write (send_buffer, [this_l](boost::system::error_code const & ec, size_t size_a) {
+		connection->send (send_buffer, [this_l](boost::system::error_code const & ec, size_t size_a) {
 			this_l->sent_action (ec, size_a);
 		});
+		// Filling inline could finish the request from inside run_next, which holds the server's request mutex
+		connection->node->background ([this_l]() {
+			this_l->fill ();
+			this_l->step ();
+		});
 	}
 	else
 	{
-		send_finished ();
+		connection->finish_request ();
+	}
+}
+
+void xpeed::bulk_pull_server::fill ()
+{
+	next_buffer->clear ();
+	if (!finished)
+	{
+		uint64_t blocks (0);
+		size_t size (0);
+		{
+			auto transaction (connection->node->store.tx_begin_read ());
+			xpeed::vectorstream stream (*next_buffer);
+			while (!finished && size < max_write_size)
+			{
+				auto block (get_next (transaction));
+				if (block != nullptr)
+				{
+					if (connection->node->config.logging.bulk_pull_logging ())
+					{
+						BOOST_LOG (connection->node->log) << boost::str (boost::format ("Sending block: %1%") % block->hash ().to_string ());
+					}
+					xpeed::serialize_block (stream, *block);
+					size += 1 + xpeed::block::size (block->type ());
+					++blocks;
+				}
+				else
+				{
+					if (connection->node->config.logging.bulk_pull_logging ())
+					{
+						BOOST_LOG (connection->node->log) << "Bulk sending finished";
+					}
+					xpeed::write (stream, xpeed::block_type::not_a_block);
+					finished = true;
+				}
+			}
+		}
+		connection->node->stats.add (xpeed::stat::type::bootstrap, xpeed::stat::detail::blocks_served, xpeed::stat::dir::out, blocks);
+	}
+}
+
+void xpeed::bulk_pull_server::step ()
+{
+	if (--outstanding == 0)
+	{
+		send_next ();
 	}
 }
 
-std::shared_ptr<xpeed::block> xpeed::bulk_pull_server::get_next ()
+std::shared_ptr<xpeed::block> xpeed::bulk_pull_server::get_next (xpeed::transaction const & transaction_a)
 {
 	std::shared_ptr<xpeed::block> result;
 	bool send_current = false, set_current_to_end = false;
@@ -2488,8 +3538,7 @@ std::shared_ptr<xpeed::block> xpeed::bulk_pull_server::get_next ()
 
 	if (send_current)
 	{
-		auto transaction (connection->node->store.tx_begin_read ());
-		result = connection->node->store.block_get (transaction, current);
+		result = connection->node->store.block_get (transaction_a, current);
 		if (result != nullptr && set_current_to_end == false)
 		{
 			auto previous (result->previous ());
@@ -2523,7 +3572,7 @@ void xpeed::bulk_pull_server::sent_action (boost::system::error_code const & ec,
 {
 	if (!ec)
 	{
-		send_next ();
+		step ();
 	}
 	else
 	{
@@ -2534,40 +3583,13 @@ void xpeed::bulk_pull_server::sent_action (boost::system::error_code const & ec,
 	}
 }
 
-void xpeed::bulk_pull_server::send_finished ()
-{
-	send_buffer->clear ();
-	send_buffer->push_back (static_cast<uint8_t> (xpeed::block_type::not_a_block));
-	auto this_l (shared_from_this ());
-	if (connection->node->config.logging.bulk_pull_logging ())
-	{
-		BOOST_LOG (connection->node->log) << "Bulk sending finished";
-	}
-	connection->socket->async_write (send_buffer, [this_l](boost::system::error_code const & ec, size_t size_a) {
-		this_l->no_block_sent (ec, size_a);
-	});
-}
-
-void xpeed::bulk_pull_server::no_block_sent (boost::system::error_code const & ec, size_t size_a)
-{
-	if (!ec)
-	{
-		assert (size_a == 1);
-		connection->finish_request ();
-	}
-	else
-	{
-		if (connection->node->config.logging.bulk_pull_logging ())
-		{
-			BOOST_LOG (connection->node->log) << "Unable to send not-a-block";
-		}
-	}
-}
-
 xpeed::bulk_pull_server::bulk_pull_server (std::shared_ptr<xpeed::bootstrap_server> const & connection_a, std::unique_ptr<xpeed::bulk_pull> request_a) :
 connection (connection_a),
 request (std::move (request_a)),
-send_buffer (std::make_shared<std::vector<uint8_t>> ())
+send_buffer (std::make_shared<std::vector<uint8_t>> ()),
+next_buffer (std::make_shared<std::vector<uint8_t>> ()),
+finished (false),
+outstanding (0)
 {
 	set_current_end ();
 }
@@ -2664,7 +3686,7 @@ void xpeed::bulk_pull_account_server::send_frontier ()
 	 ** Send the buffer to the requestor
 	 **/
 	auto this_l (shared_from_this ());
-	connection->socket->async_write (send_buffer, [this_l](boost::system::error_code const & ec, size_t size_a) {
+	connection->send (send_buffer, [this_l](boost::system::error_code const & ec, size_t size_a) {
 		this_l->sent_action (ec, size_a);
 	});
 }
@@ -2719,7 +3741,7 @@ void xpeed::bulk_pull_account_server::send_next_block ()
 		}
 
 		auto this_l (shared_from_this ());
-		connection->socket->async_write (send_buffer, [this_l](boost::system::error_code const & ec, size_t size_a) {
+		connection->send (send_buffer, [this_l](boost::system::error_code const & ec, size_t size_a) {
 			this_l->sent_action (ec, size_a);
 		});
 	}
@@ -2867,7 +3889,7 @@ void xpeed::bulk_pull_account_server::send_finished ()
 		BOOST_LOG (connection->node->log) << "Bulk sending for an account finished";
 	}
 
-	connection->socket->async_write (send_buffer, [this_l](boost::system::error_code const & ec, size_t size_a) {
+	connection->send (send_buffer, [this_l](boost::system::error_code const & ec, size_t size_a) {
 		this_l->complete (ec, size_a);
 	});
 }
@@ -3039,68 +4061,83 @@ current (request_a->start.number () - 1),
 frontier (0),
 request (std::move (request_a)),
 send_buffer (std::make_shared<std::vector<uint8_t>> ()),
-count (0)
+next_buffer (std::make_shared<std::vector<uint8_t>> ()),
+count (0),
+finished (false),
+outstanding (0)
 {
 	next ();
 }
 
 void xpeed::frontier_req_server::send_next ()
 {
-	if (!current.is_zero () && count <= request->count)
+	if (next_buffer->empty () && !finished)
 	{
-		{
-			send_buffer->clear ();
-			xpeed::vectorstream stream (*send_buffer);
-			write (stream, current.bytes);
-			write (stream, frontier.bytes);
-		}
+		fill ();
+	}
+	std::swap (send_buffer, next_buffer);
+	if (!send_buffer->empty ())
+	{
+		outstanding = 2;
 		auto this_l (shared_from_this ());
-		if (connection->node->config.logging.bulk_pull_logging ())
-		{
-			BOOST_LOG (connection->node->log) << boost::str (boost::format ("Sending frontier for %1% %2%") % current.to_account () % frontier.to_string ());
-		}
-		next ();
-		connection->socket->async_write (send_buffer, [this_l](boost::system::error_code const & ec, size_t size_a) {
+		connection->send (send_buffer, [this_l](boost::system::error_code const & ec, size_t size_a) {
 			this_l->sent_action (ec, size_a);
 		});
+		connection->node->background ([this_l]() {
+			this_l->fill ();
+			this_l->step ();
+		});
 	}
 	else
 	{
-		send_finished ();
+		connection->finish_request ();
 	}
 }
 
-void xpeed::frontier_req_server::send_finished ()
+void xpeed::frontier_req_server::fill ()
 {
+	next_buffer->clear ();
+	if (!finished)
 	{
-		send_buffer->clear ();
-		xpeed::vectorstream stream (*send_buffer);
-		xpeed::uint256_union zero (0);
-		write (stream, zero.bytes);
-		write (stream, zero.bytes);
-	}
-	auto this_l (shared_from_this ());
-	if (connection->node->config.logging.network_logging ())
-	{
-		BOOST_LOG (connection->node->log) << "Frontier sending finished";
+		uint64_t frontiers (0);
+		{
+			xpeed::vectorstream stream (*next_buffer);
+			while (!finished && frontiers * xpeed::frontier_req_client::size_frontier < max_write_size)
+			{
+				if (!current.is_zero () && count <= request->count)
+				{
+					if (connection->node->config.logging.bulk_pull_logging ())
+					{
+						BOOST_LOG (connection->node->log) << boost::str (boost::format ("Sending frontier for %1% %2%") % current.to_account () % frontier.to_string ());
+					}
+					write (stream, current.bytes);
+					write (stream, frontier.bytes);
+					++frontiers;
+					++count;
+					next ();
+				}
+				else
+				{
+					if (connection->node->config.logging.network_logging ())
+					{
+						BOOST_LOG (connection->node->log) << "Frontier sending finished";
+					}
+					xpeed::uint256_union zero (0);
+					write (stream, zero.bytes);
+					write (stream, zero.bytes);
+					finished = true;
+				}
+			}
+		}
+		connection->node->stats.add (xpeed::stat::type::bootstrap, xpeed::stat::detail::frontiers_served, xpeed::stat::dir::out, frontiers);
 	}
-	connection->socket->async_write (send_buffer, [this_l](boost::system::error_code const & ec, size_t size_a) {
-		this_l->no_block_sent (ec, size_a);
-	});
 }
 
-void xpeed::frontier_req_server::no_block_sent (boost::system::error_code const & ec, size_t size_a)
+void xpeed::frontier_req_server::step ()
 {
-	if (!ec)
-	{
-		connection->finish_request ();
-	}
-	else
+	if (--outstanding == 0)
 	{
-		if (connection->node->config.logging.network_logging ())
-		{
-			BOOST_LOG (connection->node->log) << boost::str (boost::format ("Error sending frontier finish: %1%") % ec.message ());
-		}
+		send_next ();
 	}
 }
 
@@ -3108,8 +4145,7 @@ void xpeed::frontier_req_server::sent_action (boost::system::error_code const &
 {
 	if (!ec)
 	{
-		count++;
-		send_next ();
+		step ();
 	}
 	else
 	{
@@ -1,15 +1,18 @@
 #pragma once
 
 #include <xpeed/node/common.hpp>
+#include <xpeed/node/spill.hpp>
 #include <xpeed/secure/blockstore.hpp>
 #include <xpeed/secure/ledger.hpp>
 
 #include <atomic>
 #include <future>
 #include <queue>
+#include <set>
 #include <stack>
 #include <unordered_set>
 
+#include <boost/circular_buffer.hpp>
 #include <boost/log/sources/logger.hpp>
 #include <boost/thread/thread.hpp>
 
@@ -30,6 +33,8 @@ public:
 	socket (std::shared_ptr<xpeed::node>);
 	void async_connect (xpeed::tcp_endpoint const &, std::function<void(boost::system::error_code const &)>);
 	void async_read (std::shared_ptr<std::vector<uint8_t>>, size_t, std::function<void(boost::system::error_code const &, size_t)>);
+	/** Read whatever is available, at least one byte, in to the buffer from the given offset up to its end */
+	void async_read_some (std::shared_ptr<std::vector<uint8_t>>, size_t, std::function<void(boost::system::error_code const &, size_t)>);
 	void async_write (std::shared_ptr<std::vector<uint8_t>>, std::function<void(boost::system::error_code const &, size_t)>);
 	void start (std::chrono::steady_clock::time_point = std::chrono::steady_clock::now () + std::chrono::seconds (5));
 	void stop ();
@@ -61,16 +66,59 @@ public:
 	xpeed::block_hash end;
 	count_t count;
 	unsigned attempts;
+	/** Blocks of this chain received by earlier chunks, non-zero once the chain has outgrown a single pull */
+	uint64_t processed;
+};
+/** Local accounts, with their heads, whose frontiers are probed with one request */
+class probe_batch
+{
+public:
+	std::vector<std::pair<xpeed::account, xpeed::block_hash>> accounts;
+	/** Requests for these accounts which failed so far */
+	unsigned attempts;
 };
 enum class bootstrap_mode
 {
 	legacy,
 	lazy,
-	wallet_lazy
+	wallet_lazy,
+	ascending
+};
+/** State block whose link is pulled once its previous block turns out to have a lower balance */
+class lazy_state_backlog_item
+{
+public:
+	xpeed::block_hash link;
+	xpeed::uint128_union balance;
 };
 class frontier_req_client;
+class bulk_pull_client;
 class bulk_push_client;
 class bulk_pull_account_client;
+class account_probe_client;
+/**
+ * A slice of the account space whose frontiers are requested from one peer. Pulls found for the range are scheduled
+ * together once all of it has been compared with the local ledger, a failed range is requested again from another peer.
+ */
+class frontier_range
+{
+public:
+	frontier_range (xpeed::account const &, xpeed::account const &);
+	/** Fraction of the range received so far */
+	double progress () const;
+	xpeed::account const start;
+	/** First account past the range, zero for the end of the account space */
+	xpeed::account const end;
+	std::atomic<uint64_t> frontiers;
+	/** Most significant 64 bits of the last account received */
+	std::atomic<uint64_t> position;
+	std::weak_ptr<xpeed::frontier_req_client> client;
+	std::weak_ptr<xpeed::bootstrap_client> connection;
+	xpeed::tcp_endpoint endpoint;
+	std::future<bool> future;
+	unsigned attempts;
+	bool done;
+};
 class bootstrap_attempt : public std::enable_shared_from_this<bootstrap_attempt>
 {
 public:
@@ -80,37 +128,73 @@ public:
 	std::shared_ptr<xpeed::bootstrap_client> connection (std::unique_lock<std::mutex> &);
 	bool consume_future (std::future<bool> &);
 	void populate_connections ();
-	bool request_frontier (std::unique_lock<std::mutex> &);
+	void request_frontiers (std::unique_lock<std::mutex> &);
+	void request_frontier (std::unique_lock<std::mutex> &, std::shared_ptr<xpeed::frontier_range>);
+	void update_frontier_ranges (std::unique_lock<std::mutex> &);
+	size_t frontier_ranges_pending ();
 	void request_pull (std::unique_lock<std::mutex> &);
 	void request_push (std::unique_lock<std::mutex> &);
 	void add_connection (xpeed::endpoint const &);
 	void pool_connection (std::shared_ptr<xpeed::bootstrap_client>);
 	void stop ();
 	void requeue_pull (xpeed::pull_info const &);
+	/** Schedule the next chunk of a chain whose previous chunk completed */
+	void add_continuation (xpeed::pull_info const &);
 	void add_pull (xpeed::pull_info const &);
+	/** Schedule the pulls found for a frontier range, in random order */
+	void add_pulls (std::vector<xpeed::pull_info> &);
 	bool still_pulling ();
 	unsigned target_connections (size_t pulls_remaining);
 	bool should_log ();
+	/** Hand the pull of a peer much slower than an idle one to that idle peer */
+	void steal_pull (std::unique_lock<std::mutex> &);
+	void pull_finished (std::chrono::steady_clock::duration const &);
+	/** Pull completion time in milliseconds at \p percentile_a of recent pulls, mutex must be held */
+	double pull_time_percentile (double percentile_a);
 	void add_bulk_push_target (xpeed::block_hash const &, xpeed::block_hash const &);
-	bool process_block (std::shared_ptr<xpeed::block>, xpeed::account const &, uint64_t, bool);
+	bool process_block (std::shared_ptr<xpeed::block>, xpeed::account const &, uint64_t, bool, xpeed::signature_verification);
+	/** Drop a peer which sent invalid data and don't connect to it again for the rest of the attempt */
+	void penalize (std::shared_ptr<xpeed::bootstrap_client>);
 	void lazy_run ();
 	void lazy_start (xpeed::block_hash const &);
 	void lazy_add (xpeed::block_hash const &);
 	bool lazy_finished ();
 	void lazy_pull_flush ();
 	void lazy_clear ();
+	/** Move the largest lazy table to disk while they're over the configured memory limit */
+	void lazy_spill ();
+	size_t lazy_memory_bytes () const;
 	void request_pending (std::unique_lock<std::mutex> &);
 	void requeue_pending (xpeed::account const &);
+	/** Save queued and in progress pulls, frontier ranges, lazy queues and push targets for a later attempt to resume, writing them from a background task if \p background_a */
+	void checkpoint (bool background_a = false);
+	/** Replace the stored checkpoint with \p records_a unless a later snapshot was written already */
+	void checkpoint_write (uint64_t sequence_a, std::vector<std::vector<uint8_t>> const & records_a);
+	/** Load the saved progress of an earlier attempt in the same mode, dropping entries the ledger has satisfied since */
+	void restore ();
+	void checkpoint_clear ();
 	void wallet_run ();
 	void wallet_start (std::deque<xpeed::account> &);
 	bool wallet_finished ();
+	/** Whether pulls are of whole account chains, as in legacy and ascending mode, rather than lazy pulls of single blocks */
+	bool pulls_chains () const;
+	void ascending_run ();
+	/** Probe the frontiers of the next batch of local accounts */
+	void request_probe (std::unique_lock<std::mutex> &);
+	/** Queue the unanswered rest of a batch again unless it ran out of attempts */
+	void requeue_probe (xpeed::probe_batch const &);
+	bool ascending_finished ();
 	std::chrono::steady_clock::time_point next_log;
 	std::deque<std::weak_ptr<xpeed::bootstrap_client>> clients;
 	std::weak_ptr<xpeed::bootstrap_client> connection_frontier_request;
-	std::weak_ptr<xpeed::frontier_req_client> frontiers;
+	std::vector<std::shared_ptr<xpeed::frontier_range>> frontier_ranges;
 	std::weak_ptr<xpeed::bulk_push_client> push;
 	std::deque<xpeed::pull_info> pulls;
+	std::unordered_map<xpeed::bulk_pull_client *, xpeed::pull_info> pulls_in_progress;
+	std::unordered_set<xpeed::tcp_endpoint> penalized;
 	std::deque<std::shared_ptr<xpeed::bootstrap_client>> idle;
+	// Completion times of the most recent pulls in milliseconds
+	boost::circular_buffer<double> pull_times;
 	std::atomic<unsigned> connections;
 	std::atomic<unsigned> pulling;
 	std::shared_ptr<xpeed::node> node;
@@ -122,30 +206,52 @@ public:
 	xpeed::bootstrap_mode mode;
 	std::mutex mutex;
 	std::condition_variable condition;
+	// Set when the attempt ran to the end instead of being stopped
+	std::atomic<bool> completed;
+	std::chrono::steady_clock::time_point next_checkpoint;
+	// Numbers checkpoint snapshots as they're taken under mutex, checkpoint_mutex orders their writes
+	uint64_t checkpoint_sequence;
+	std::mutex checkpoint_mutex;
+	uint64_t checkpoint_written;
 	// Lazy bootstrap
-	std::unordered_set<xpeed::block_hash> lazy_blocks;
-	std::unordered_map<xpeed::block_hash, std::pair<xpeed::block_hash, xpeed::uint128_t>> lazy_state_unknown;
-	std::unordered_map<xpeed::block_hash, xpeed::uint128_t> lazy_balances;
+	xpeed::spilling_map<xpeed::no_value> lazy_blocks{ "lazy_blocks" };
+	xpeed::spilling_map<xpeed::lazy_state_backlog_item> lazy_state_unknown{ "lazy_state_unknown" };
+	xpeed::spilling_map<xpeed::uint128_union> lazy_balances{ "lazy_balances" };
 	std::unordered_set<xpeed::block_hash> lazy_keys;
-	std::deque<xpeed::block_hash> lazy_pulls;
+	xpeed::spilling_queue lazy_pulls{ "lazy_pulls" };
+	// Opened the first time lazy state goes over bootstrap_lazy_memory
+	std::unique_ptr<xpeed::spill_store> lazy_spill_store;
+	// Set when lazy_spill_store couldn't be opened, the rest of the attempt keeps its lazy state in memory
+	bool lazy_spill_failed;
 	std::atomic<uint64_t> lazy_stopped;
 	uint64_t lazy_max_pull_blocks = xpeed::is_test_network ? 2 : 512;
 	uint64_t lazy_max_stopped = 256;
 	std::mutex lazy_mutex;
 	// Wallet lazy bootstrap
 	std::deque<xpeed::account> wallet_accounts;
+	// Ascending bootstrap, local accounts from ascending_next on haven't been probed yet
+	xpeed::account ascending_next;
+	bool ascending_exhausted;
+	std::deque<xpeed::probe_batch> ascending_batches;
+	// First account of each batch being probed
+	std::multiset<xpeed::account> ascending_probing;
+	std::atomic<uint64_t> ascending_probed;
+	std::atomic<uint64_t> ascending_differing;
 };
 class frontier_req_client : public std::enable_shared_from_this<xpeed::frontier_req_client>
 {
 public:
-	frontier_req_client (std::shared_ptr<xpeed::bootstrap_client>);
+	frontier_req_client (std::shared_ptr<xpeed::bootstrap_client>, std::shared_ptr<xpeed::frontier_range>);
 	~frontier_req_client ();
 	void run ();
 	void receive_frontier ();
 	void received_frontier (boost::system::error_code const &, size_t);
 	void unsynced (xpeed::block_hash const &, xpeed::block_hash const &);
 	void next (xpeed::transaction const &);
+	bool in_range (xpeed::account const &) const;
 	std::shared_ptr<xpeed::bootstrap_client> connection;
+	std::shared_ptr<xpeed::frontier_range> range;
+	std::vector<xpeed::pull_info> pulls;
 	xpeed::account current;
 	xpeed::block_hash frontier;
 	unsigned count;
@@ -158,6 +264,10 @@ public:
 	std::deque<std::pair<xpeed::account, xpeed::block_hash>> accounts;
 	static size_t constexpr size_frontier = sizeof (xpeed::account) + sizeof (xpeed::block_hash);
 };
+/**
+ * Reads the response to a bulk_pull in to a buffer as fast as the peer sends it and decodes every complete block
+ * received by each read, the blocks are then processed together before the next read is issued.
+ */
 class bulk_pull_client : public std::enable_shared_from_this<xpeed::bulk_pull_client>
 {
 public:
@@ -165,15 +275,29 @@ public:
 	~bulk_pull_client ();
 	void request ();
 	void receive_block ();
-	void received_type ();
-	void received_block (boost::system::error_code const &, size_t, xpeed::block_type);
+	void received_data (boost::system::error_code const &, size_t);
+	/**
+	 * Verify the signatures of the blocks in a received batch which name their signer, open and state blocks, in one
+	 * call to the node's checker. Returns true if one of them is invalid.
+	 */
+	bool verify (std::vector<std::shared_ptr<xpeed::block>> const &, std::vector<xpeed::signature_verification> &);
+	/** Returns true if no more blocks should be read from this pull */
+	bool received_block (std::shared_ptr<xpeed::block>, xpeed::signature_verification);
 	xpeed::block_hash first ();
+	/** Whether the peer sent all count blocks of a chunked pull without reaching its end */
+	bool chunk_complete () const;
 	std::shared_ptr<xpeed::bootstrap_client> connection;
 	xpeed::block_hash expected;
 	xpeed::account known_account;
 	xpeed::pull_info pull;
 	uint64_t total_blocks;
 	uint64_t unexpected_count;
+	std::chrono::steady_clock::time_point start_time;
+	// Received bytes not yet decoded are buffer[buffer_begin, buffer_end)
+	std::shared_ptr<std::vector<uint8_t>> buffer;
+	size_t buffer_begin;
+	size_t buffer_end;
+	static size_t constexpr buffer_size = 64 * 1024;
 };
 class bootstrap_client : public std::enable_shared_from_this<bootstrap_client>
 {
@@ -184,16 +308,26 @@ public:
 	std::shared_ptr<xpeed::bootstrap_client> shared ();
 	void stop (bool force);
 	double block_rate () const;
+	double byte_rate () const;
 	double elapsed_seconds () const;
 	std::shared_ptr<xpeed::node> node;
 	std::shared_ptr<xpeed::bootstrap_attempt> attempt;
 	std::shared_ptr<xpeed::socket> socket;
 	std::shared_ptr<std::vector<uint8_t>> receive_buffer;
+	/** Receive buffer of bulk_pull_client, allocated by the first pull and reused by later ones on this connection */
+	std::shared_ptr<std::vector<uint8_t>> pull_buffer;
 	xpeed::tcp_endpoint endpoint;
 	std::chrono::steady_clock::time_point start_time;
 	std::atomic<uint64_t> block_count;
+	std::atomic<uint64_t> byte_count;
 	std::atomic<bool> pending_stop;
 	std::atomic<bool> hard_stop;
+	// Moving average of blocks per second while pulling, maintained by populate_connections under the attempt mutex
+	double score;
+	uint64_t score_blocks;
+	std::chrono::steady_clock::time_point score_time;
+	/** Set when the rest of this peer's pull was handed to a faster one */
+	std::atomic<bool> lagging;
 };
 class bulk_push_client : public std::enable_shared_from_this<xpeed::bulk_push_client>
 {
@@ -219,6 +353,30 @@ public:
 	xpeed::account account;
 	uint64_t total_blocks;
 };
+/**
+ * Asks a peer for the frontier of each account of a batch with pipelined bulk_pull_account requests whose minimum
+ * amount filters out every pending entry, then schedules pulls for the accounts whose frontier differs from ours.
+ */
+class account_probe_client : public std::enable_shared_from_this<xpeed::account_probe_client>
+{
+public:
+	account_probe_client (std::shared_ptr<xpeed::bootstrap_client>, xpeed::probe_batch const &);
+	~account_probe_client ();
+	void request ();
+	void receive_frontier ();
+	void received_frontier (xpeed::block_hash const &);
+	std::shared_ptr<xpeed::bootstrap_client> connection;
+	// Accounts of the batch with their local head
+	std::vector<std::pair<xpeed::account, xpeed::block_hash>> accounts;
+	unsigned attempts;
+	std::vector<xpeed::pull_info> pulls;
+	// Index of the account whose response is being read
+	size_t current;
+	// Set once the frontier of current was read and its terminating entry is next
+	bool frontier_read;
+	bool done;
+	static size_t constexpr size_entry = sizeof (xpeed::uint256_union) + sizeof (xpeed::uint128_union);
+};
 class bootstrap_initiator
 {
 public:
@@ -228,6 +386,8 @@ public:
 	void bootstrap ();
 	void bootstrap_lazy (xpeed::block_hash const &, bool = false);
 	void bootstrap_wallet (std::deque<xpeed::account> &);
+	/** Start an attempt which only pulls the accounts already in the local ledger whose frontier differs from a peer's */
+	void bootstrap_ascending ();
 	void run_bootstrap ();
 	void notify_listeners (bool);
 	void add_observer (std::function<void(bool)> const &);
@@ -288,30 +448,43 @@ public:
 	void add_request (std::unique_ptr<xpeed::message>);
 	void finish_request ();
 	void run_next ();
+	/** Write a response through the node's serving scheduler */
+	void send (std::shared_ptr<std::vector<uint8_t>>, std::function<void(boost::system::error_code const &, size_t)> const &);
 	std::shared_ptr<std::vector<uint8_t>> receive_buffer;
 	std::shared_ptr<xpeed::socket> socket;
+	xpeed::tcp_endpoint remote;
 	std::shared_ptr<xpeed::node> node;
 	std::mutex mutex;
 	std::queue<std::unique_ptr<xpeed::message>> requests;
 };
 class bulk_pull;
+/**
+ * Blocks are serialized in chunks of up to max_write_size from one read transaction and each chunk is sent with a
+ * single write, the next chunk is filled while the previous one is being written.
+ */
 class bulk_pull_server : public std::enable_shared_from_this<xpeed::bulk_pull_server>
 {
 public:
 	bulk_pull_server (std::shared_ptr<xpeed::bootstrap_server> const &, std::unique_ptr<xpeed::bulk_pull>);
 	void set_current_end ();
-	std::shared_ptr<xpeed::block> get_next ();
+	std::shared_ptr<xpeed::block> get_next (xpeed::transaction const &);
 	void send_next ();
 	void sent_action (boost::system::error_code const &, size_t);
-	void send_finished ();
-	void no_block_sent (boost::system::error_code const &, size_t);
+	/** Serialize blocks in to next_buffer until it's full or the last one was added, which is followed by not_a_block */
+	void fill ();
+	void step ();
 	std::shared_ptr<xpeed::bootstrap_server> connection;
 	std::unique_ptr<xpeed::bulk_pull> request;
 	std::shared_ptr<std::vector<uint8_t>> send_buffer;
+	std::shared_ptr<std::vector<uint8_t>> next_buffer;
 	xpeed::block_hash current;
 	bool include_start;
+	bool finished;
+	// The write of send_buffer and filling next_buffer both finish a round, whichever is last starts the next
+	std::atomic<unsigned> outstanding;
 	xpeed::bulk_pull::count_t max_count;
 	xpeed::bulk_pull::count_t sent_count;
+	static size_t constexpr max_write_size = 32 * 1024;
 };
 class bulk_pull_account;
 class bulk_pull_account_server : public std::enable_shared_from_this<xpeed::bulk_pull_account_server>
@@ -345,21 +518,29 @@ public:
 	std::shared_ptr<xpeed::bootstrap_server> connection;
 };
 class frontier_req;
+/**
+ * Frontiers are sent in chunks of up to max_write_size the same way as bulk_pull_server sends blocks
+ */
 class frontier_req_server : public std::enable_shared_from_this<xpeed::frontier_req_server>
 {
 public:
 	frontier_req_server (std::shared_ptr<xpeed::bootstrap_server> const &, std::unique_ptr<xpeed::frontier_req>);
 	void send_next ();
 	void sent_action (boost::system::error_code const &, size_t);
-	void send_finished ();
-	void no_block_sent (boost::system::error_code const &, size_t);
+	/** Serialize frontiers in to next_buffer until it's full or the last one was added, which is followed by a zero pair */
+	void fill ();
+	void step ();
 	void next ();
 	std::shared_ptr<xpeed::bootstrap_server> connection;
 	xpeed::account current;
 	xpeed::block_hash frontier;
 	std::unique_ptr<xpeed::frontier_req> request;
 	std::shared_ptr<std::vector<uint8_t>> send_buffer;
+	std::shared_ptr<std::vector<uint8_t>> next_buffer;
 	size_t count;
+	bool finished;
+	std::atomic<unsigned> outstanding;
 	std::deque<std::pair<xpeed::account, xpeed::block_hash>> accounts;
+	static size_t constexpr max_write_size = 32 * 1024;
 };
 }
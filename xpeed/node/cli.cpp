@@ -34,6 +34,7 @@ void xpeed::add_node_options (boost::program_options::options_description & desc
 	("delete_node_id", "Delete the node ID in the database")
 	("online_weight_clear", "Clear online weight history records")
 	("peer_clear", "Clear online peers database dump")
+	("confirmation_height_clear", "Clear cemented confirmation heights, blocks are cemented again as elections confirm them")
 	("unchecked_clear", "Clear unchecked blocks")
 	("diagnostics", "Run internal diagnostics")
 	("key_create", "Generates a adhoc random keypair and prints it to stdout")
@@ -304,6 +305,15 @@ std::error_code xpeed::handle_node_options (boost::program_options::variables_ma
 		node.node->store.peer_clear (transaction);
 		std::cerr << "Database peers are removed" << std::endl;
 	}
+	else if (vm.count ("confirmation_height_clear"))
+	{
+		boost::filesystem::path data_path = vm.count ("data_path") ? boost::filesystem::path (vm["data_path"].as<std::string> ()) : xpeed::working_path ();
+		inactive_node node (data_path);
+		auto transaction (node.node->store.tx_begin_write ());
+		node.node->store.confirmation_height_clear (transaction);
+		node.node->store.confirmation_height_put (transaction, xpeed::genesis_account, 1);
+		std::cerr << "Confirmation heights are removed" << std::endl;
+	}
 	else if (vm.count ("diagnostics"))
 	{
 		inactive_node node (data_path);
@@ -98,6 +98,11 @@ bool xpeed::message_header::bulk_pull_is_count_present () const
 	return result;
 }
 
+bool xpeed::message_header::keepalive_is_tcp_realtime () const
+{
+	return type == xpeed::message_type::keepalive && extensions.test (keepalive_tcp_realtime_flag);
+}
+
 size_t xpeed::message_header::payload_length_bytes () const
 {
 	switch (type)
@@ -123,8 +128,8 @@ size_t xpeed::message_header::payload_length_bytes () const
 		{
 			return xpeed::keepalive::size;
 		}
-		// Add realtime network messages once they get framing support; currently the
-		// realtime messages all fit in a datagram from which they're deserialized.
+		// Realtime messages other than keepalive are either read from a datagram or from a
+		// length prefixed tcp_channel frame so their length is known up front.
 		default:
 		{
 			assert (false);
@@ -135,6 +140,7 @@ size_t xpeed::message_header::payload_length_bytes () const
 
 // MTU - IP header - UDP header
 const size_t xpeed::message_parser::max_safe_udp_message_size = 508;
+size_t constexpr xpeed::message_arena::default_capacity;
 
 std::string xpeed::message_parser::status_string ()
 {
@@ -188,6 +194,14 @@ std::string xpeed::message_parser::status_string ()
 		{
 			return "invalid_network";
 		}
+		case xpeed::message_parser::parse_status::duplicate_publish_message:
+		{
+			return "duplicate_publish_message";
+		}
+		case xpeed::message_parser::parse_status::duplicate_confirm_ack_message:
+		{
+			return "duplicate_confirm_ack_message";
+		}
 	}
 
 	assert (false);
@@ -195,12 +209,18 @@ std::string xpeed::message_parser::status_string ()
 	return "[unknown parse_status]";
 }
 
-xpeed::message_parser::message_parser (xpeed::block_uniquer & block_uniquer_a, xpeed::vote_uniquer & vote_uniquer_a, xpeed::message_visitor & visitor_a, xpeed::work_pool & pool_a) :
+xpeed::message_parser::message_parser (xpeed::block_uniquer & block_uniquer_a, xpeed::vote_uniquer & vote_uniquer_a, xpeed::message_visitor & visitor_a, xpeed::work_pool & pool_a, xpeed::network_filter & filter_a) :
 block_uniquer (block_uniquer_a),
 vote_uniquer (vote_uniquer_a),
 visitor (visitor_a),
 pool (pool_a),
-status (parse_status::success)
+filter (filter_a),
+status (parse_status::success),
+digest (0),
+arena_objects (0),
+promoted (0),
+max_message_size (max_safe_udp_message_size),
+arena (xpeed::message_arena::local ())
 {
 }
 
@@ -208,7 +228,7 @@ void xpeed::message_parser::deserialize_buffer (uint8_t const * buffer_a, size_t
 {
 	status = parse_status::success;
 	auto error (false);
-	if (size_a <= max_safe_udp_message_size)
+	if (size_a <= max_message_size)
 	{
 		// Guaranteed to be deliverable
 		xpeed::bufferstream stream (buffer_a, size_a);
@@ -242,7 +262,19 @@ void xpeed::message_parser::deserialize_buffer (uint8_t const * buffer_a, size_t
 					}
 					case xpeed::message_type::publish:
 					{
-						deserialize_publish (stream, header);
+						// Rebroadcast copies are dropped before paying for deserialization and work validation
+						if (!filter.apply (buffer_a + (size_a - stream.in_avail ()), stream.in_avail (), header.extensions.to_ulong (), digest))
+						{
+							deserialize_publish (stream, header);
+							if (status != parse_status::success)
+							{
+								filter.clear (digest);
+							}
+						}
+						else
+						{
+							status = parse_status::duplicate_publish_message;
+						}
 						break;
 					}
 					case xpeed::message_type::confirm_req:
@@ -252,7 +284,19 @@ void xpeed::message_parser::deserialize_buffer (uint8_t const * buffer_a, size_t
 					}
 					case xpeed::message_type::confirm_ack:
 					{
-						deserialize_confirm_ack (stream, header);
+						// Seeded differently from publish so a vote and a block never share a digest
+						if (!filter.apply (buffer_a + (size_a - stream.in_avail ()), stream.in_avail (), header.extensions.to_ulong () | (1ULL << 32), digest))
+						{
+							deserialize_confirm_ack (stream, header);
+							if (status != parse_status::success)
+							{
+								filter.clear (digest);
+							}
+						}
+						else
+						{
+							status = parse_status::duplicate_confirm_ack_message;
+						}
 						break;
 					}
 					case xpeed::message_type::node_id_handshake:
@@ -291,12 +335,13 @@ void xpeed::message_parser::deserialize_keepalive (xpeed::stream & stream_a, xpe
 
 void xpeed::message_parser::deserialize_publish (xpeed::stream & stream_a, xpeed::message_header const & header_a)
 {
-	auto error (false);
-	xpeed::publish incoming (error, stream_a, header_a, &block_uniquer);
-	if (!error && at_end (stream_a))
+	auto block (deserialize_block (stream_a, header_a.block_type ()));
+	if (block != nullptr && at_end (stream_a))
 	{
-		if (!xpeed::work_validate (*incoming.block))
+		if (!xpeed::work_validate (*block))
 		{
+			xpeed::publish incoming (promote (*block));
+			incoming.header = header_a;
 			visitor.publish (incoming);
 		}
 		else
@@ -312,45 +357,117 @@ void xpeed::message_parser::deserialize_publish (xpeed::stream & stream_a, xpeed
 
 void xpeed::message_parser::deserialize_confirm_req (xpeed::stream & stream_a, xpeed::message_header const & header_a)
 {
-	auto error (false);
-	xpeed::confirm_req incoming (error, stream_a, header_a, &block_uniquer);
-	if (!error && at_end (stream_a))
+	if (header_a.block_type () == xpeed::block_type::not_a_block)
 	{
-		if (incoming.block == nullptr || !xpeed::work_validate (*incoming.block))
+		auto error (false);
+		xpeed::confirm_req incoming (error, stream_a, header_a, &block_uniquer);
+		if (!error && at_end (stream_a))
 		{
 			visitor.confirm_req (incoming);
 		}
 		else
 		{
-			status = parse_status::insufficient_work;
+			status = parse_status::invalid_confirm_req_message;
 		}
 	}
 	else
 	{
-		status = parse_status::invalid_confirm_req_message;
+		auto block (deserialize_block (stream_a, header_a.block_type ()));
+		if (block != nullptr && at_end (stream_a))
+		{
+			if (!xpeed::work_validate (*block))
+			{
+				xpeed::confirm_req incoming (promote (*block));
+				incoming.header = header_a;
+				visitor.confirm_req (incoming);
+			}
+			else
+			{
+				status = parse_status::insufficient_work;
+			}
+		}
+		else
+		{
+			status = parse_status::invalid_confirm_req_message;
+		}
 	}
 }
 
 void xpeed::message_parser::deserialize_confirm_ack (xpeed::stream & stream_a, xpeed::message_header const & header_a)
 {
 	auto error (false);
-	xpeed::confirm_ack incoming (error, stream_a, header_a, &vote_uniquer);
-	if (!error && at_end (stream_a))
+	xpeed::account account;
+	xpeed::signature signature;
+	uint64_t sequence (0);
+	try
+	{
+		xpeed::read (stream_a, account.bytes);
+		xpeed::read (stream_a, signature.bytes);
+		xpeed::read (stream_a, sequence);
+	}
+	catch (std::runtime_error const &)
+	{
+		error = true;
+	}
+	// The rest of the message is a whole number of fixed size hashes or blocks
+	auto type (header_a.block_type ());
+	auto item_size (type == xpeed::block_type::not_a_block ? sizeof (xpeed::block_hash) : type == xpeed::block_type::invalid ? 0 : xpeed::block::size (type));
+	auto remaining (static_cast<size_t> (stream_a.in_avail ()));
+	auto count (item_size > 0 ? remaining / item_size : 0);
+	error = error || count == 0 || remaining % item_size != 0;
+	xpeed::block_hash * hashes (nullptr);
+	xpeed::block ** blocks (nullptr);
+	if (!error)
 	{
-		for (auto & vote_block : incoming.vote->blocks)
+		++arena_objects;
+		if (type == xpeed::block_type::not_a_block)
+		{
+			hashes = arena.make_array<xpeed::block_hash> (count);
+			for (size_t i (0); i < count && !error; ++i)
+			{
+				error = xpeed::try_read (stream_a, hashes[i]);
+			}
+		}
+		else
 		{
-			if (!vote_block.which ())
+			blocks = arena.make_array<xpeed::block *> (count);
+			for (size_t i (0); i < count && !error; ++i)
 			{
-				auto block (boost::get<std::shared_ptr<xpeed::block>> (vote_block));
-				if (xpeed::work_validate (*block))
+				blocks[i] = deserialize_block (stream_a, type);
+				error = blocks[i] == nullptr;
+			}
+			for (size_t i (0); i < count && !error && status == parse_status::success; ++i)
+			{
+				if (xpeed::work_validate (*blocks[i]))
 				{
 					status = parse_status::insufficient_work;
-					break;
 				}
 			}
 		}
+	}
+	if (!error)
+	{
 		if (status == parse_status::success)
 		{
+			auto vote (std::make_shared<xpeed::vote> ());
+			vote->account = account;
+			vote->signature = signature;
+			vote->sequence = sequence;
+			vote->blocks.reserve (count);
+			for (size_t i (0); i < count; ++i)
+			{
+				if (blocks != nullptr)
+				{
+					vote->blocks.push_back (promote (*blocks[i]));
+				}
+				else
+				{
+					vote->blocks.push_back (hashes[i]);
+				}
+			}
+			++promoted;
+			xpeed::confirm_ack incoming (vote_uniquer.unique (vote));
+			incoming.header = header_a;
 			visitor.confirm_ack (incoming);
 		}
 	}
@@ -381,6 +498,126 @@ bool xpeed::message_parser::at_end (xpeed::stream & stream_a)
 	return end;
 }
 
+xpeed::block * xpeed::message_parser::deserialize_block (xpeed::stream & stream_a, xpeed::block_type type_a)
+{
+	xpeed::block * result (nullptr);
+	auto error (false);
+	switch (type_a)
+	{
+		case xpeed::block_type::send:
+			result = arena.make<xpeed::send_block> (error, stream_a);
+			break;
+		case xpeed::block_type::receive:
+			result = arena.make<xpeed::receive_block> (error, stream_a);
+			break;
+		case xpeed::block_type::open:
+			result = arena.make<xpeed::open_block> (error, stream_a);
+			break;
+		case xpeed::block_type::change:
+			result = arena.make<xpeed::change_block> (error, stream_a);
+			break;
+		case xpeed::block_type::state:
+			result = arena.make<xpeed::state_block> (error, stream_a);
+			break;
+		default:
+			error = true;
+			break;
+	}
+	if (result != nullptr)
+	{
+		++arena_objects;
+	}
+	return error ? nullptr : result;
+}
+
+std::shared_ptr<xpeed::block> xpeed::message_parser::promote (xpeed::block const & block_a)
+{
+	std::shared_ptr<xpeed::block> result;
+	switch (block_a.type ())
+	{
+		case xpeed::block_type::send:
+			result = std::make_shared<xpeed::send_block> (static_cast<xpeed::send_block const &> (block_a));
+			break;
+		case xpeed::block_type::receive:
+			result = std::make_shared<xpeed::receive_block> (static_cast<xpeed::receive_block const &> (block_a));
+			break;
+		case xpeed::block_type::open:
+			result = std::make_shared<xpeed::open_block> (static_cast<xpeed::open_block const &> (block_a));
+			break;
+		case xpeed::block_type::change:
+			result = std::make_shared<xpeed::change_block> (static_cast<xpeed::change_block const &> (block_a));
+			break;
+		case xpeed::block_type::state:
+			result = std::make_shared<xpeed::state_block> (static_cast<xpeed::state_block const &> (block_a));
+			break;
+		default:
+			assert (false);
+			break;
+	}
+	++promoted;
+	return block_uniquer.unique (result);
+}
+
+xpeed::message_arena::message_arena (size_t capacity_a) :
+buffer (new uint8_t[capacity_a]),
+capacity (capacity_a),
+offset (0),
+overflow_size (0)
+{
+}
+
+xpeed::message_arena::~message_arena ()
+{
+	reset ();
+}
+
+void * xpeed::message_arena::allocate (size_t size_a, size_t alignment_a)
+{
+	void * result (nullptr);
+	auto aligned ((offset + alignment_a - 1) & ~(alignment_a - 1));
+	if (aligned + size_a <= capacity)
+	{
+		result = buffer.get () + aligned;
+		offset = aligned + size_a;
+	}
+	else
+	{
+		// operator new[] memory is aligned for any fundamental type
+		overflow.emplace_back (new uint8_t[size_a]);
+		overflow_size += size_a;
+		result = overflow.back ().get ();
+	}
+	return result;
+}
+
+void xpeed::message_arena::reset ()
+{
+	for (auto i (destructors.rbegin ()), n (destructors.rend ()); i != n; ++i)
+	{
+		i->first (i->second);
+	}
+	destructors.clear ();
+	if (!overflow.empty ())
+	{
+		overflow.clear ();
+		capacity = capacity + overflow_size;
+		buffer.reset (new uint8_t[capacity]);
+		overflow_size = 0;
+	}
+	offset = 0;
+}
+
+size_t xpeed::message_arena::used () const
+{
+	return offset + overflow_size;
+}
+
+xpeed::message_arena & xpeed::message_arena::local ()
+{
+	static thread_local xpeed::message_arena arena (default_capacity);
+	return arena;
+}
+
 xpeed::keepalive::keepalive () :
 message (xpeed::message_type::keepalive)
 {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <xpeed/lib/interface.h>
+#include <xpeed/node/network_filter.hpp>
 #include <xpeed/secure/common.hpp>
 
 #include <boost/asio.hpp>
@@ -205,6 +206,10 @@ public:
 	static size_t constexpr bulk_pull_count_present_flag = 0;
 	bool bulk_pull_is_count_present () const;
 
+	/** Set on a keepalive sent over a bootstrap connection to ask for a realtime channel, echoed if the peer agrees */
+	static size_t constexpr keepalive_tcp_realtime_flag = 0;
+	bool keepalive_is_tcp_realtime () const;
+
 	/** Size of the payload in bytes. For some messages, the payload size is based on header flags. */
 	size_t payload_length_bytes () const;
 
@@ -236,6 +241,52 @@ public:
 	xpeed::message_header header;
 };
 class work_pool;
+/**
+ * Bump allocator for objects decoded from incoming messages. Each thread processing messages owns one through local (),
+ * everything made in it is destroyed at once when the thread calls reset after a batch of messages. Allocations which
+ * don't fit are served from the heap and the buffer grows to cover them on the next reset.
+ */
+class message_arena
+{
+public:
+	message_arena (size_t);
+	~message_arena ();
+	/** Construct a T valid until the next reset */
+	template <typename T, typename... Args>
+	T * make (Args &&... args_a)
+	{
+		auto result (new (allocate (sizeof (T), alignof (T))) T (std::forward<Args> (args_a)...));
+		if (!std::is_trivially_destructible<T>::value)
+		{
+			destructors.emplace_back ([](void * object_a) { static_cast<T *> (object_a)->~T (); }, result);
+		}
+		return result;
+	}
+	/** Uninitialized storage for \p count_a objects which need no destruction */
+	template <typename T>
+	T * make_array (size_t count_a)
+	{
+		static_assert (std::is_trivially_destructible<T>::value, "Arena arrays are never destroyed");
+		return static_cast<T *> (allocate (sizeof (T) * count_a, alignof (T)));
+	}
+	void reset ();
+	size_t used () const;
+	static xpeed::message_arena & local ();
+	static size_t constexpr default_capacity = 64 * 1024;
+
+private:
+	void * allocate (size_t, size_t);
+	std::unique_ptr<uint8_t[]> buffer;
+	size_t capacity;
+	size_t offset;
+	std::vector<std::unique_ptr<uint8_t[]>> overflow;
+	size_t overflow_size;
+	std::vector<std::pair<void (*) (void *), void *>> destructors;
+};
+/**
+ * Blocks and votes are decoded in to the thread's message_arena and checked there, only messages which pass are copied
+ * to shared ownership before being handed to the visitor.
+ */
 class message_parser
 {
 public:
@@ -252,9 +303,11 @@ public:
 		invalid_node_id_handshake_message,
 		outdated_version,
 		invalid_magic,
-		invalid_network
+		invalid_network,
+		duplicate_publish_message,
+		duplicate_confirm_ack_message
 	};
-	message_parser (xpeed::block_uniquer &, xpeed::vote_uniquer &, xpeed::message_visitor &, xpeed::work_pool &);
+	message_parser (xpeed::block_uniquer &, xpeed::vote_uniquer &, xpeed::message_visitor &, xpeed::work_pool &, xpeed::network_filter &);
 	void deserialize_buffer (uint8_t const *, size_t);
 	void deserialize_keepalive (xpeed::stream &, xpeed::message_header const &);
 	void deserialize_publish (xpeed::stream &, xpeed::message_header const &);
@@ -266,9 +319,22 @@ public:
 	xpeed::vote_uniquer & vote_uniquer;
 	xpeed::message_visitor & visitor;
 	xpeed::work_pool & pool;
+	xpeed::network_filter & filter;
 	parse_status status;
+	/** Filter digest of a publish or confirm_ack payload, zero for other messages */
+	uint64_t digest;
+	/** Blocks and votes decoded in the arena and those of them copied to shared ownership */
+	size_t arena_objects;
+	size_t promoted;
+	/** Larger messages are rejected, raised for frames from a realtime TCP channel */
+	size_t max_message_size;
 	std::string status_string ();
 	static const size_t max_safe_udp_message_size;
+
+private:
+	xpeed::block * deserialize_block (xpeed::stream &, xpeed::block_type);
+	std::shared_ptr<xpeed::block> promote (xpeed::block const &);
+	xpeed::message_arena & arena;
 };
 class keepalive : public message
 {
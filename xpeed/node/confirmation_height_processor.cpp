@@ -0,0 +1,204 @@
+#include <xpeed/node/confirmation_height_processor.hpp>
+
+#include <xpeed/node/node.hpp>
+
+size_t constexpr xpeed::confirmation_height_processor::batch_write_size;
+size_t constexpr xpeed::confirmation_height_processor::max_blocks;
+std::chrono::milliseconds constexpr xpeed::confirmation_height_processor::batch_write_delay;
+
+xpeed::confirmation_height_processor::confirmation_height_processor (xpeed::node & node_a) :
+node (node_a),
+stopped (false),
+thread ([this]() {
+	xpeed::thread_role::set (xpeed::thread_role::name::confirmation_height_processing);
+	run ();
+})
+{
+}
+
+xpeed::confirmation_height_processor::~confirmation_height_processor ()
+{
+	stop ();
+}
+
+void xpeed::confirmation_height_processor::add (xpeed::block_hash const & hash_a)
+{
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		if (blocks.size () < max_blocks)
+		{
+			blocks.push_back (hash_a);
+		}
+		else
+		{
+			// A block dropped here is cemented along with the next confirmed block above it
+			node.stats.inc (xpeed::stat::type::confirmation_height, xpeed::stat::detail::overflow);
+		}
+	}
+	condition.notify_all ();
+}
+
+void xpeed::confirmation_height_processor::stop ()
+{
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		stopped = true;
+	}
+	condition.notify_all ();
+	if (thread.joinable ())
+	{
+		thread.join ();
+	}
+}
+
+size_t xpeed::confirmation_height_processor::size ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	return blocks.size ();
+}
+
+void xpeed::confirmation_height_processor::run ()
+{
+	std::unique_lock<std::mutex> lock (mutex);
+	while (!stopped)
+	{
+		if (!blocks.empty ())
+		{
+			auto hash (blocks.front ());
+			blocks.pop_front ();
+			lock.unlock ();
+			if (pending_writes.empty ())
+			{
+				pending_since = std::chrono::steady_clock::now ();
+			}
+			process (hash);
+			// Under sustained load the queue may never drain, bound how long a cemented height stays unwritten
+			if (pending_writes.size () >= batch_write_size || (!pending_writes.empty () && std::chrono::steady_clock::now () - pending_since >= batch_write_delay))
+			{
+				write_pending ();
+			}
+			lock.lock ();
+		}
+		else if (!pending_writes.empty ())
+		{
+			lock.unlock ();
+			write_pending ();
+			lock.lock ();
+		}
+		else
+		{
+			condition.wait (lock);
+		}
+	}
+	lock.unlock ();
+	write_pending ();
+}
+
+uint64_t xpeed::confirmation_height_processor::height (xpeed::transaction const & transaction_a, xpeed::account const & account_a)
+{
+	auto existing (pending_writes.find (account_a));
+	return existing != pending_writes.end () ? existing->second : node.store.confirmation_height_get (transaction_a, account_a);
+}
+
+void xpeed::confirmation_height_processor::process (xpeed::block_hash const & hash_a)
+{
+	auto transaction (node.store.tx_begin_read ());
+	std::vector<xpeed::block_hash> targets (1, hash_a);
+	std::vector<xpeed::block_hash> sources;
+	while (!targets.empty ())
+	{
+		auto current (targets.back ());
+		xpeed::block_sideband sideband;
+		auto block (node.store.block_get (transaction, current, &sideband));
+		if (block == nullptr || sideband.height == 0)
+		{
+			// Rolled back since it was confirmed or still waiting for its sideband upgrade
+			node.stats.inc (xpeed::stat::type::confirmation_height, xpeed::stat::detail::invalid_block);
+			targets.pop_back ();
+		}
+		else
+		{
+			// Sideband doesn't repeat the account for blocks which contain it
+			auto account (block->account ().is_zero () ? sideband.account : block->account ());
+			auto cemented (height (transaction, account));
+			if (sideband.height > cemented)
+			{
+				// Walk down to the cemented height collecting receive sources which aren't cemented yet, highest first
+				sources.clear ();
+				auto lowest_dependent (sideband.height + 1);
+				for (auto block_height (sideband.height); block != nullptr && block_height > cemented; --block_height)
+				{
+					auto source (node.ledger.block_source (transaction, *block));
+					if (!source.is_zero () && !node.ledger.is_epoch_link (source))
+					{
+						xpeed::block_sideband source_sideband;
+						auto source_block (node.store.block_get (transaction, source, &source_sideband));
+						if (source_block != nullptr && source_sideband.height > height (transaction, source_block->account ().is_zero () ? source_sideband.account : source_block->account ()))
+						{
+							sources.push_back (source);
+							lowest_dependent = block_height;
+						}
+					}
+					block = block_height > cemented + 1 ? node.store.block_get (transaction, block->previous ()) : nullptr;
+				}
+				// Everything below the lowest receive with an uncemented source can be cemented right away
+				auto new_height (lowest_dependent - 1);
+				if (new_height > cemented)
+				{
+					pending_writes[account] = new_height;
+					node.stats.add (xpeed::stat::type::confirmation_height, xpeed::stat::detail::blocks_confirmed, xpeed::stat::dir::in, new_height - cemented);
+				}
+				if (sources.empty ())
+				{
+					targets.pop_back ();
+				}
+				else
+				{
+					// Sources are revisited lowest first, then this block is walked again from the new height
+					targets.insert (targets.end (), sources.begin (), sources.end ());
+				}
+			}
+			else
+			{
+				targets.pop_back ();
+			}
+		}
+	}
+}
+
+void xpeed::confirmation_height_processor::write_pending ()
+{
+	if (!pending_writes.empty ())
+	{
+		auto transaction (node.store.tx_begin_write ());
+		for (auto & i : pending_writes)
+		{
+			xpeed::account_info info;
+			if (!node.store.account_get (transaction, i.first, info))
+			{
+				// Blocks may have been rolled back after being queued, never cement beyond the current chain
+				auto new_height (std::min (i.second, info.block_count));
+				if (new_height > node.store.confirmation_height_get (transaction, i.first))
+				{
+					node.store.confirmation_height_put (transaction, i.first, new_height);
+				}
+			}
+		}
+		pending_writes.clear ();
+	}
+}
+
+namespace xpeed
+{
+std::unique_ptr<seq_con_info_component> collect_seq_con_info (confirmation_height_processor & confirmation_height_processor, const std::string & name)
+{
+	size_t blocks_count;
+	{
+		std::lock_guard<std::mutex> guard (confirmation_height_processor.mutex);
+		blocks_count = confirmation_height_processor.blocks.size ();
+	}
+	auto composite = std::make_unique<seq_con_info_composite> (name);
+	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "blocks", blocks_count, sizeof (decltype (confirmation_height_processor.blocks)::value_type) }));
+	return composite;
+}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <xpeed/lib/numbers.hpp>
+#include <xpeed/lib/utility.hpp>
+#include <xpeed/secure/common.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace xpeed
+{
+class node;
+class transaction;
+/**
+ * Raises the persistent confirmation height of account chains once an election confirms one of their blocks.
+ * Cementing a block also cements every block below it and, transitively, the sources of any receives among them;
+ * dependencies are walked iteratively and new heights are written in batches from a single background thread.
+ */
+class confirmation_height_processor
+{
+public:
+	confirmation_height_processor (xpeed::node &);
+	~confirmation_height_processor ();
+	void add (xpeed::block_hash const &);
+	void stop ();
+	size_t size ();
+	/** Cemented heights are written once this many accounts are waiting, the oldest has waited batch_write_delay or the queue drains */
+	static size_t constexpr batch_write_size = 4096;
+	static std::chrono::milliseconds constexpr batch_write_delay = std::chrono::milliseconds (500);
+	static size_t constexpr max_blocks = 65536;
+
+private:
+	void run ();
+	void process (xpeed::block_hash const &);
+	uint64_t height (xpeed::transaction const &, xpeed::account const &);
+	void write_pending ();
+	xpeed::node & node;
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::deque<xpeed::block_hash> blocks;
+	/** Heights cemented but not yet written, only accessed by the processing thread */
+	std::unordered_map<xpeed::account, uint64_t> pending_writes;
+	/** When the oldest of pending_writes was cemented */
+	std::chrono::steady_clock::time_point pending_since;
+	bool stopped;
+	std::thread thread;
+
+	friend std::unique_ptr<seq_con_info_component> collect_seq_con_info (confirmation_height_processor &, const std::string &);
+};
+
+std::unique_ptr<seq_con_info_component> collect_seq_con_info (confirmation_height_processor &, const std::string &);
+}
@@ -767,8 +767,10 @@ env (error_a, path_a, lmdb_max_dbs)
 		error_a |= mdb_dbi_open (env.tx (transaction), "unchecked", MDB_CREATE, &unchecked) != 0;
 		error_a |= mdb_dbi_open (env.tx (transaction), "vote", MDB_CREATE, &vote) != 0;
 		error_a |= mdb_dbi_open (env.tx (transaction), "online_weight", MDB_CREATE, &online_weight) != 0;
+		error_a |= mdb_dbi_open (env.tx (transaction), "confirmation_height", MDB_CREATE, &confirmation_height) != 0;
 		error_a |= mdb_dbi_open (env.tx (transaction), "meta", MDB_CREATE, &meta) != 0;
 		error_a |= mdb_dbi_open (env.tx (transaction), "peers", MDB_CREATE, &peers) != 0;
+		error_a |= mdb_dbi_open (env.tx (transaction), "bootstrap_checkpoint", MDB_CREATE, &bootstrap_checkpoint) != 0;
 		if (!full_sideband (transaction))
 		{
 			error_a |= mdb_dbi_open (env.tx (transaction), "blocks_info", MDB_CREATE, &blocks_info) != 0;
@@ -830,6 +832,7 @@ void xpeed::mdb_store::initialize (xpeed::transaction const & transaction_a, xpe
 	account_put (transaction_a, genesis_account, { hash_l, genesis_a.open->hash (), genesis_a.open->hash (), std::numeric_limits<xpeed::uint128_t>::max (), xpeed::seconds_since_epoch (), 1, xpeed::epoch::epoch_0 });
 	representation_put (transaction_a, genesis_account, std::numeric_limits<xpeed::uint128_t>::max ());
 	frontier_put (transaction_a, hash_l, genesis_account);
+	confirmation_height_put (transaction_a, genesis_account, 1);
 }
 
 void xpeed::mdb_store::version_put (xpeed::transaction const & transaction_a, int version_a)
@@ -941,6 +944,35 @@ xpeed::store_iterator<xpeed::endpoint_key, xpeed::no_value> xpeed::mdb_store::pe
 	return result;
 }
 
+void xpeed::mdb_store::bootstrap_checkpoint_put (xpeed::transaction const & transaction_a, std::vector<std::vector<uint8_t>> const & records_a)
+{
+	bootstrap_checkpoint_clear (transaction_a);
+	uint64_t sequence (0);
+	for (auto & record : records_a)
+	{
+		auto key (boost::endian::native_to_big (sequence++));
+		auto status (mdb_put (env.tx (transaction_a), bootstrap_checkpoint, xpeed::mdb_val (sizeof (key), &key), xpeed::mdb_val (record.size (), const_cast<uint8_t *> (record.data ())), MDB_APPEND));
+		release_assert (status == 0);
+	}
+}
+
+std::vector<std::vector<uint8_t>> xpeed::mdb_store::bootstrap_checkpoint_get (xpeed::transaction const & transaction_a)
+{
+	std::vector<std::vector<uint8_t>> result;
+	for (xpeed::mdb_iterator<uint64_t, xpeed::no_value> i (transaction_a, bootstrap_checkpoint), n (nullptr); i != n; ++i)
+	{
+		auto data (reinterpret_cast<uint8_t const *> (i->second.data ()));
+		result.emplace_back (data, data + i->second.size ());
+	}
+	return result;
+}
+
+void xpeed::mdb_store::bootstrap_checkpoint_clear (xpeed::transaction const & transaction_a)
+{
+	auto status (mdb_drop (env.tx (transaction_a), bootstrap_checkpoint, 0));
+	release_assert (status == 0);
+}
+
 void xpeed::mdb_store::do_upgrades (xpeed::transaction const & transaction_a, bool & slow_upgrade)
 {
 	switch (version_get (transaction_a))
@@ -2189,6 +2221,45 @@ void xpeed::mdb_store::online_weight_clear (xpeed::transaction const & transacti
 	release_assert (status == 0);
 }
 
+void xpeed::mdb_store::confirmation_height_put (xpeed::transaction const & transaction_a, xpeed::account const & account_a, uint64_t height_a)
+{
+	auto status (mdb_put (env.tx (transaction_a), confirmation_height, xpeed::mdb_val (account_a), xpeed::mdb_val (height_a), 0));
+	release_assert (status == 0);
+}
+
+uint64_t xpeed::mdb_store::confirmation_height_get (xpeed::transaction const & transaction_a, xpeed::account const & account_a)
+{
+	uint64_t result (0);
+	xpeed::mdb_val value;
+	auto status (mdb_get (env.tx (transaction_a), confirmation_height, xpeed::mdb_val (account_a), value));
+	release_assert (status == 0 || status == MDB_NOTFOUND);
+	if (status == 0)
+	{
+		result = static_cast<uint64_t> (value);
+	}
+	return result;
+}
+
+void xpeed::mdb_store::confirmation_height_del (xpeed::transaction const & transaction_a, xpeed::account const & account_a)
+{
+	auto status (mdb_del (env.tx (transaction_a), confirmation_height, xpeed::mdb_val (account_a), nullptr));
+	release_assert (status == 0 || status == MDB_NOTFOUND);
+}
+
+size_t xpeed::mdb_store::confirmation_height_count (xpeed::transaction const & transaction_a)
+{
+	MDB_stat confirmation_height_stats;
+	auto status (mdb_stat (env.tx (transaction_a), confirmation_height, &confirmation_height_stats));
+	release_assert (status == 0);
+	return confirmation_height_stats.ms_entries;
+}
+
+void xpeed::mdb_store::confirmation_height_clear (xpeed::transaction const & transaction_a)
+{
+	auto status (mdb_drop (env.tx (transaction_a), confirmation_height, 0));
+	release_assert (status == 0);
+}
+
 void xpeed::mdb_store::flush (xpeed::transaction const & transaction_a)
 {
 	{
@@ -246,6 +246,12 @@ public:
 	size_t online_weight_count (xpeed::transaction const &) const override;
 	void online_weight_clear (xpeed::transaction const &) override;
 
+	void confirmation_height_put (xpeed::transaction const &, xpeed::account const &, uint64_t) override;
+	uint64_t confirmation_height_get (xpeed::transaction const &, xpeed::account const &) override;
+	void confirmation_height_del (xpeed::transaction const &, xpeed::account const &) override;
+	size_t confirmation_height_count (xpeed::transaction const &) override;
+	void confirmation_height_clear (xpeed::transaction const &) override;
+
 	std::mutex cache_mutex;
 	std::unordered_map<xpeed::account, std::shared_ptr<xpeed::vote>> vote_cache_l1;
 	std::unordered_map<xpeed::account, std::shared_ptr<xpeed::vote>> vote_cache_l2;
@@ -283,6 +289,10 @@ public:
 	xpeed::store_iterator<xpeed::endpoint_key, xpeed::no_value> peers_begin (xpeed::transaction const & transaction_a) override;
 	xpeed::store_iterator<xpeed::endpoint_key, xpeed::no_value> peers_end () override;
 
+	void bootstrap_checkpoint_put (xpeed::transaction const &, std::vector<std::vector<uint8_t>> const &) override;
+	std::vector<std::vector<uint8_t>> bootstrap_checkpoint_get (xpeed::transaction const &) override;
+	void bootstrap_checkpoint_clear (xpeed::transaction const &) override;
+
 	void stop ();
 
 	xpeed::logging & logging;
@@ -385,6 +395,12 @@ public:
 	 */
 	MDB_dbi online_weight{ 0 };
 
+	/**
+	 * Height of the highest cemented block in each account chain, accounts without an entry have nothing cemented
+	 * xpeed::account -> uint64_t
+	 */
+	MDB_dbi confirmation_height{ 0 };
+
 	/**
 	 * Meta information about block store, such as versions.
 	 * xpeed::uint256_union (arbitrary key) -> blob
@@ -397,6 +413,12 @@ public:
 	*/
 	MDB_dbi peers{ 0 };
 
+	/**
+	 * Progress of an unfinished bootstrap attempt, rewritten whole at every checkpoint
+	 * uint64_t (big endian sequence) -> blob
+	 */
+	MDB_dbi bootstrap_checkpoint{ 0 };
+
 private:
 	bool entry_has_sideband (MDB_val, xpeed::block_type);
 	xpeed::account block_account_computed (xpeed::transaction const &, xpeed::block_hash const &);
@@ -0,0 +1,45 @@
+#include <xpeed/node/network_filter.hpp>
+
+#include <crypto/xxhash/xxhash.h>
+
+#include <cassert>
+
+xpeed::network_filter::network_filter (size_t count_a) :
+items (std::make_unique<std::atomic<uint64_t>[]> (count_a)),
+count (count_a)
+{
+	assert (count > 0);
+	clear ();
+}
+
+bool xpeed::network_filter::apply (uint8_t const * buffer_a, size_t size_a, uint64_t seed_a, uint64_t & digest_a)
+{
+	digest_a = XXH64 (buffer_a, size_a, seed_a);
+	// Zero marks an empty slot
+	digest_a = digest_a != 0 ? digest_a : 1;
+	return slot (digest_a).exchange (digest_a, std::memory_order_relaxed) == digest_a;
+}
+
+void xpeed::network_filter::clear (uint64_t digest_a)
+{
+	auto expected (digest_a);
+	slot (digest_a).compare_exchange_strong (expected, 0, std::memory_order_relaxed);
+}
+
+void xpeed::network_filter::clear ()
+{
+	for (size_t i (0); i < count; ++i)
+	{
+		items[i].store (0, std::memory_order_relaxed);
+	}
+}
+
+size_t xpeed::network_filter::size () const
+{
+	return count;
+}
+
+std::atomic<uint64_t> & xpeed::network_filter::slot (uint64_t digest_a)
+{
+	return items[digest_a % count];
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace xpeed
+{
+/**
+ * Remembers digests of recently received message payloads so rebroadcast copies can be dropped before they are parsed.
+ * Digests are kept in a fixed table of slots indexed by the digest itself, a newer digest overwrites whatever shared
+ * its slot. The filter is bounded, never reports a payload it hasn't seen (barring a 64-bit collision) and all methods
+ * are lock-free.
+ */
+class network_filter
+{
+public:
+	network_filter (size_t);
+	/** Insert the digest of \p buffer_a, returns true if it was already present. \p digest_a receives the digest */
+	bool apply (uint8_t const * buffer_a, size_t size_a, uint64_t seed_a, uint64_t & digest_a);
+	/** Forget \p digest_a so the same payload is accepted again */
+	void clear (uint64_t digest_a);
+	void clear ();
+	size_t size () const;
+
+private:
+	std::atomic<uint64_t> & slot (uint64_t);
+	std::unique_ptr<std::atomic<uint64_t>[]> items;
+	size_t count;
+};
+}
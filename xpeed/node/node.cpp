@@ -28,7 +28,11 @@ std::chrono::milliseconds constexpr xpeed::node::process_confirmed_interval;
 int constexpr xpeed::port_mapping::mapping_timeout;
 int constexpr xpeed::port_mapping::check_timeout;
 unsigned constexpr xpeed::active_transactions::request_interval_ms;
+size_t constexpr xpeed::active_transactions::shard_count;
+size_t constexpr xpeed::active_transactions::requests_per_tick;
 size_t constexpr xpeed::active_transactions::max_broadcast_queue;
+size_t constexpr xpeed::vote_processor::max_votes;
+uint8_t constexpr xpeed::vote_processor::tier_count;
 size_t constexpr xpeed::block_arrival::arrival_size_min;
 std::chrono::seconds constexpr xpeed::block_arrival::arrival_time_min;
 uint64_t constexpr xpeed::online_reps::weight_period;
@@ -42,11 +46,23 @@ extern size_t xpd_bootstrap_weights_size;
 
 xpeed::network::network (xpeed::node & node_a, uint16_t port) :
 buffer_container (node_a.stats, xpeed::network::buffer_size, 4096), // 2Mb receive buffer
-socket (node_a.io_ctx, xpeed::endpoint (boost::asio::ip::address_v6::any (), port)),
+socket (node_a.io_ctx),
+ingress (*this),
+egress (*this),
+publish_filter (publish_filter_size),
+limiter (node_a.config),
+propagation (node_a.peers),
+channels (node_a),
 resolver (node_a.io_ctx),
 node (node_a),
 on (true)
 {
+	socket.open (boost::asio::ip::udp::v6 ());
+	if (node.config.udp_ingress_sockets > 0 && xpeed::udp_ingress::supported ())
+	{
+		xpeed::udp_ingress::reuse_port (socket);
+	}
+	socket.bind (xpeed::endpoint (boost::asio::ip::address_v6::any (), port));
 	boost::thread::attributes attrs;
 	xpeed::thread_attributes::set (attrs);
 	for (size_t i = 0; i < node.config.network_threads; ++i)
@@ -95,10 +111,25 @@ xpeed::network::~network ()
 
 void xpeed::network::start ()
 {
-	for (size_t i = 0; i < node.config.io_threads; ++i)
+	// A transport delivers datagrams to buffer_container itself and takes them from send_buffer
+	if (transport == nullptr)
 	{
-		receive ();
+		auto receive_async (node.config.udp_ingress_sockets == 0);
+		if (!receive_async && ingress.start (socket, node.config.udp_ingress_sockets))
+		{
+			BOOST_LOG (node.log) << "UDP ingress sockets unavailable, falling back to asynchronous receive";
+			receive_async = true;
+		}
+		if (receive_async)
+		{
+			for (size_t i = 0; i < node.config.io_threads; ++i)
+			{
+				receive ();
+			}
+		}
+		egress.start (socket, node.config.network_threads);
 	}
+	channels.start ();
 }
 
 void xpeed::network::receive ()
@@ -137,29 +168,39 @@ void xpeed::network::receive ()
 void xpeed::network::process_packets ()
 {
 	auto local_endpoint (endpoint ());
+	std::array<xpeed::udp_data *, 64> batch;
 	while (on.load ())
 	{
-		auto data (buffer_container.dequeue ());
-		if (data == nullptr)
+		auto count (buffer_container.dequeue (batch.data (), batch.size ()));
+		if (count == 0)
 		{
 			break;
 		}
-		//std::cerr << data->endpoint.address ().to_string ();
-		receive_action (data, local_endpoint);
-		buffer_container.release (data);
+		for (size_t i (0); i < count; ++i)
+		{
+			//std::cerr << batch[i]->endpoint.address ().to_string ();
+			receive_action (batch[i], local_endpoint);
+			buffer_container.release (batch[i]);
+		}
+		// Nothing decoded from the batch is referenced once it's been processed
+		xpeed::message_arena::local ().reset ();
 	}
 }
 
 void xpeed::network::stop ()
 {
 	on = false;
+	channels.stop ();
+	// Wakes ingress threads waiting for a free buffer before they're joined
+	buffer_container.stop ();
+	ingress.stop ();
+	egress.stop ();
 	std::unique_lock<std::mutex> lock (socket_mutex);
 	if (socket.is_open ())
 	{
 		socket.close ();
 	}
 	resolver.cancel ();
-	buffer_container.stop ();
 }
 
 void xpeed::network::send_keepalive (xpeed::endpoint const & endpoint_a)
@@ -172,20 +213,7 @@ void xpeed::network::send_keepalive (xpeed::endpoint const & endpoint_a)
 	{
 		BOOST_LOG (node.log) << boost::str (boost::format ("Keepalive req sent to %1%") % endpoint_a);
 	}
-	std::weak_ptr<xpeed::node> node_w (node.shared ());
-	send_buffer (bytes->data (), bytes->size (), endpoint_a, [bytes, node_w, endpoint_a](boost::system::error_code const & ec, size_t) {
-		if (auto node_l = node_w.lock ())
-		{
-			if (ec && node_l->config.logging.network_keepalive_logging ())
-			{
-				BOOST_LOG (node_l->log) << boost::str (boost::format ("Error sending keepalive to %1%: %2%") % endpoint_a % ec.message ());
-			}
-			else
-			{
-				node_l->stats.inc (xpeed::stat::type::message, xpeed::stat::detail::keepalive, xpeed::stat::dir::out);
-			}
-		}
-	});
+	send (bytes, endpoint_a, xpeed::stat::detail::keepalive);
 }
 
 void xpeed::node::keepalive (std::string const & address_a, uint16_t port_a, bool preconfigured_peer_a)
@@ -226,17 +254,7 @@ void xpeed::network::send_node_id_handshake (xpeed::endpoint const & endpoint_a,
 	{
 		BOOST_LOG (node.log) << boost::str (boost::format ("Node ID handshake sent with node ID %1% to %2%: query %3%, respond_to %4% (signature %5%)") % node.node_id.pub.to_account () % endpoint_a % (query ? query->to_string () : std::string ("[none]")) % (respond_to ? respond_to->to_string () : std::string ("[none]")) % (response ? response->second.to_string () : std::string ("[none]")));
 	}
-	node.stats.inc (xpeed::stat::type::message, xpeed::stat::detail::node_id_handshake, xpeed::stat::dir::out);
-	std::weak_ptr<xpeed::node> node_w (node.shared ());
-	send_buffer (bytes->data (), bytes->size (), endpoint_a, [bytes, node_w, endpoint_a](boost::system::error_code const & ec, size_t) {
-		if (auto node_l = node_w.lock ())
-		{
-			if (ec && node_l->config.logging.network_node_id_handshake_logging ())
-			{
-				BOOST_LOG (node_l->log) << boost::str (boost::format ("Error sending node ID handshake to %1% %2%") % endpoint_a % ec.message ());
-			}
-		}
-	});
+	egress.send (bytes, endpoint_a, xpeed::stat::detail::node_id_handshake);
 }
 
 void xpeed::network::republish (xpeed::block_hash const & hash_a, std::shared_ptr<std::vector<uint8_t>> buffer_a, xpeed::endpoint endpoint_a)
@@ -245,20 +263,7 @@ void xpeed::network::republish (xpeed::block_hash const & hash_a, std::shared_pt
 	{
 		BOOST_LOG (node.log) << boost::str (boost::format ("Publishing %1% to %2%") % hash_a.to_string () % endpoint_a);
 	}
-	std::weak_ptr<xpeed::node> node_w (node.shared ());
-	send_buffer (buffer_a->data (), buffer_a->size (), endpoint_a, [node_w, endpoint_a](boost::system::error_code const & ec, size_t size) {
-		if (auto node_l = node_w.lock ())
-		{
-			if (ec && node_l->config.logging.network_logging ())
-			{
-				BOOST_LOG (node_l->log) << boost::str (boost::format ("Error sending publish to %1%: %2%") % endpoint_a % ec.message ());
-			}
-			else
-			{
-				node_l->stats.inc (xpeed::stat::type::message, xpeed::stat::detail::publish, xpeed::stat::dir::out);
-			}
-		}
-	});
+	send (buffer_a, endpoint_a, xpeed::stat::detail::publish);
 }
 
 template <typename T>
@@ -358,7 +363,7 @@ bool xpeed::network::send_votes_cache (xpeed::block_hash const & hash_a, xpeed::
 void xpeed::network::republish_block (std::shared_ptr<xpeed::block> block)
 {
 	auto hash (block->hash ());
-	auto list (node.peers.list_fanout ());
+	auto list (propagation.targets (hash));
 	xpeed::publish message (block);
 	auto bytes = message.to_bytes ();
 	for (auto i (list.begin ()), n (list.end ()); i != n; ++i)
@@ -381,6 +386,7 @@ void xpeed::network::republish_block (std::shared_ptr<xpeed::block> block, xpeed
 		message.serialize (stream);
 	}
 	republish (hash, std::make_shared<std::vector<uint8_t>> (bytes), peer_a);
+	propagation.seen (hash, peer_a);
 	if (node.config.logging.network_logging ())
 	{
 		BOOST_LOG (node.log) << boost::str (boost::format ("Block %1% was republished to peer") % hash.to_string ());
@@ -415,7 +421,7 @@ void xpeed::network::republish_vote (std::shared_ptr<xpeed::vote> vote_a)
 {
 	xpeed::confirm_ack confirm (vote_a);
 	auto bytes = confirm.to_bytes ();
-	auto list (node.peers.list_fanout ());
+	auto list (propagation.targets (vote_a->full_hash ()));
 	for (auto j (list.begin ()), m (list.end ()); j != m; ++j)
 	{
 		node.network.confirm_send (confirm, bytes, *j);
@@ -489,8 +495,9 @@ void xpeed::network::broadcast_confirm_req_batch (std::unordered_map<xpeed::endp
 		auto j (request_bundle_a.begin ());
 		count++;
 		std::vector<std::pair<xpeed::block_hash, xpeed::block_hash>> roots_hashes;
-		// Limit max request size hash + root to 6 pairs
-		while (roots_hashes.size () <= confirm_req_hashes_max && !j->second.empty ())
+		// Limit max request size hash + root to what fits in a datagram, a realtime channel takes as many as the encoding allows
+		auto limit (channels.connected (j->first) ? confirm_req_hashes_tcp_max : confirm_req_hashes_max + 1);
+		while (roots_hashes.size () < limit && !j->second.empty ())
 		{
 			roots_hashes.push_back (j->second.back ());
 			j->second.pop_back ();
@@ -546,42 +553,35 @@ void xpeed::network::send_confirm_req (xpeed::endpoint const & endpoint_a, std::
 	{
 		BOOST_LOG (node.log) << boost::str (boost::format ("Sending confirm req to %1%") % endpoint_a);
 	}
-	std::weak_ptr<xpeed::node> node_w (node.shared ());
-	node.stats.inc (xpeed::stat::type::message, xpeed::stat::detail::confirm_req, xpeed::stat::dir::out);
-	send_buffer (bytes->data (), bytes->size (), endpoint_a, [bytes, node_w](boost::system::error_code const & ec, size_t size) {
-		if (auto node_l = node_w.lock ())
-		{
-			if (ec && node_l->config.logging.network_logging ())
-			{
-				BOOST_LOG (node_l->log) << boost::str (boost::format ("Error sending confirm request: %1%") % ec.message ());
-			}
-		}
-	});
+	send (bytes, endpoint_a, xpeed::stat::detail::confirm_req);
 }
 
 void xpeed::network::send_confirm_req_hashes (xpeed::endpoint const & endpoint_a, std::vector<std::pair<xpeed::block_hash, xpeed::block_hash>> const & roots_hashes_a)
 {
 	xpeed::confirm_req message (roots_hashes_a);
-	std::vector<uint8_t> bytes;
-	{
-		xpeed::vectorstream stream (bytes);
-		message.serialize (stream);
-	}
+	auto bytes (message.to_bytes ());
 	if (node.config.logging.network_message_logging ())
 	{
 		BOOST_LOG (node.log) << boost::str (boost::format ("Sending confirm req hashes to %1%") % endpoint_a);
 	}
-	std::weak_ptr<xpeed::node> node_w (node.shared ());
-	node.stats.inc (xpeed::stat::type::message, xpeed::stat::detail::confirm_req, xpeed::stat::dir::out);
-	send_buffer (bytes.data (), bytes.size (), endpoint_a, [node_w](boost::system::error_code const & ec, size_t size) {
-		if (auto node_l = node_w.lock ())
+	if (channels.send (bytes, endpoint_a, xpeed::stat::detail::confirm_req))
+	{
+		if (roots_hashes_a.size () <= confirm_req_hashes_max + 1)
+		{
+			egress.send (bytes, endpoint_a, xpeed::stat::detail::confirm_req);
+		}
+		else
 		{
-			if (ec && node_l->config.logging.network_logging ())
+			// A batch sized for a realtime channel is larger than receivers accept in a datagram, split it back up
+			for (auto i (roots_hashes_a.begin ()), n (roots_hashes_a.end ()); i != n;)
 			{
-				BOOST_LOG (node_l->log) << boost::str (boost::format ("Error sending confirm request: %1%") % ec.message ());
+				auto end (i + std::min<size_t> (confirm_req_hashes_max, n - i));
+				xpeed::confirm_req chunk (std::vector<std::pair<xpeed::block_hash, xpeed::block_hash>> (i, end));
+				egress.send (chunk.to_bytes (), endpoint_a, xpeed::stat::detail::confirm_req);
+				i = end;
 			}
 		}
-	});
+	}
 }
 
 template <typename T>
@@ -619,7 +619,8 @@ class network_message_visitor : public xpeed::message_visitor
 public:
 	network_message_visitor (xpeed::node & node_a, xpeed::endpoint const & sender_a) :
 	node (node_a),
-	sender (sender_a)
+	sender (sender_a),
+	parser (nullptr)
 	{
 	}
 	virtual ~network_message_visitor () = default;
@@ -649,10 +650,15 @@ public:
 		}
 		node.stats.inc (xpeed::stat::type::message, xpeed::stat::detail::publish, xpeed::stat::dir::in);
 		node.peers.contacted (sender, message_a.header.version_using);
+		node.network.propagation.seen (message_a.block->hash (), sender, digest ());
 		if (!node.block_processor.full ())
 		{
 			node.process_active (message_a.block);
 		}
+		else
+		{
+			dropped ();
+		}
 		node.active.publish (message_a.block);
 	}
 	void confirm_req (xpeed::confirm_req const & message_a) override
@@ -737,6 +743,7 @@ public:
 		}
 		node.stats.inc (xpeed::stat::type::message, xpeed::stat::detail::confirm_ack, xpeed::stat::dir::in);
 		node.peers.contacted (sender, message_a.header.version_using);
+		node.network.propagation.seen (message_a.vote->full_hash (), sender, digest ());
 		for (auto & vote_block : message_a.vote->blocks)
 		{
 			if (!vote_block.which ())
@@ -746,6 +753,10 @@ public:
 				{
 					node.process_active (block);
 				}
+				else
+				{
+					dropped ();
+				}
 				node.active.publish (block);
 			}
 		}
@@ -806,8 +817,22 @@ public:
 		}
 		node.stats.inc (xpeed::stat::type::message, xpeed::stat::detail::node_id_handshake, xpeed::stat::dir::in);
 	}
+	uint64_t digest () const
+	{
+		return parser != nullptr ? parser->digest : 0;
+	}
+	// Let a later copy of a payload which couldn't be processed through the duplicate filter
+	void dropped ()
+	{
+		if (digest () != 0)
+		{
+			node.network.publish_filter.clear (digest ());
+		}
+	}
 	xpeed::node & node;
 	xpeed::endpoint sender;
+	// Set when messages come from a parser, its digest lets later duplicates of a payload be attributed without parsing them
+	xpeed::message_parser const * parser;
 };
 }
 
@@ -828,10 +853,74 @@ void xpeed::network::receive_action (xpeed::udp_data * data_a, xpeed::endpoint c
 	}
 	if (allowed_sender)
 	{
-		network_message_visitor visitor (node, data_a->endpoint);
-		xpeed::message_parser parser (node.block_uniquer, node.vote_uniquer, visitor, node.work);
-		parser.deserialize_buffer (data_a->buffer, data_a->size);
-		if (parser.status != xpeed::message_parser::parse_status::success)
+		process_message (data_a->buffer, data_a->size, data_a->endpoint);
+	}
+	else
+	{
+		if (node.config.logging.network_logging ())
+		{
+			BOOST_LOG (node.log) << boost::str (boost::format ("Reserved sender %1%") % data_a->endpoint.address ().to_string ());
+		}
+
+		node.stats.inc_detail_only (xpeed::stat::type::error, xpeed::stat::detail::bad_sender);
+	}
+}
+
+void xpeed::network::process_message (uint8_t const * buffer_a, size_t size_a, xpeed::endpoint const & endpoint_a, size_t max_size_a)
+{
+	// Rate limits are applied to the message type before paying for the rest of the message
+	auto error (false);
+	xpeed::bufferstream header_stream (buffer_a, size_a);
+	xpeed::message_header header (error, header_stream);
+	auto type (error ? xpeed::message_type::invalid : header.type);
+	if (limiter.limit (endpoint_a, type, size_a))
+	{
+		auto detail (xpeed::stat::detail::all);
+		switch (type)
+		{
+			case xpeed::message_type::keepalive:
+				detail = xpeed::stat::detail::keepalive;
+				break;
+			case xpeed::message_type::publish:
+				detail = xpeed::stat::detail::publish;
+				break;
+			case xpeed::message_type::confirm_req:
+				detail = xpeed::stat::detail::confirm_req;
+				break;
+			case xpeed::message_type::confirm_ack:
+				detail = xpeed::stat::detail::confirm_ack;
+				break;
+			case xpeed::message_type::node_id_handshake:
+				detail = xpeed::stat::detail::node_id_handshake;
+				break;
+			default:
+				break;
+		}
+		node.stats.inc (xpeed::stat::type::rate_limit, detail);
+	}
+	else
+	{
+		network_message_visitor visitor (node, endpoint_a);
+		xpeed::message_parser parser (node.block_uniquer, node.vote_uniquer, visitor, node.work, publish_filter);
+		visitor.parser = &parser;
+		parser.max_message_size = max_size_a;
+		parser.deserialize_buffer (buffer_a, size_a);
+		if (parser.arena_objects > 0)
+		{
+			node.stats.add (xpeed::stat::type::decode, xpeed::stat::detail::arena, xpeed::stat::dir::in, parser.arena_objects);
+			node.stats.add (xpeed::stat::type::decode, xpeed::stat::detail::promote, xpeed::stat::dir::in, parser.promoted);
+		}
+		if (parser.status == xpeed::message_parser::parse_status::duplicate_publish_message)
+		{
+			propagation.seen (parser.digest, endpoint_a);
+			node.stats.inc (xpeed::stat::type::filter, xpeed::stat::detail::publish);
+		}
+		else if (parser.status == xpeed::message_parser::parse_status::duplicate_confirm_ack_message)
+		{
+			propagation.seen (parser.digest, endpoint_a);
+			node.stats.inc (xpeed::stat::type::filter, xpeed::stat::detail::confirm_ack);
+		}
+		else if (parser.status != xpeed::message_parser::parse_status::success)
 		{
 			node.stats.inc (xpeed::stat::type::error);
 
@@ -872,6 +961,8 @@ void xpeed::network::receive_action (xpeed::udp_data * data_a, xpeed::endpoint c
 					node.stats.inc (xpeed::stat::type::udp, xpeed::stat::detail::outdated_version);
 					break;
 				case xpeed::message_parser::parse_status::success:
+				case xpeed::message_parser::parse_status::duplicate_publish_message:
+				case xpeed::message_parser::parse_status::duplicate_confirm_ack_message:
 					/* Already checked, unreachable */
 					break;
 			}
@@ -883,17 +974,8 @@ void xpeed::network::receive_action (xpeed::udp_data * data_a, xpeed::endpoint c
 		}
 		else
 		{
-			node.stats.add (xpeed::stat::type::traffic, xpeed::stat::dir::in, data_a->size);
-		}
-	}
-	else
-	{
-		if (node.config.logging.network_logging ())
-		{
-			BOOST_LOG (node.log) << boost::str (boost::format ("Reserved sender %1%") % data_a->endpoint.address ().to_string ());
+			node.stats.add (xpeed::stat::type::traffic, xpeed::stat::dir::in, size_a);
 		}
-
-		node.stats.inc_detail_only (xpeed::stat::type::error, xpeed::stat::detail::bad_sender);
 	}
 }
 
@@ -1001,6 +1083,7 @@ bool xpeed::node_init::error ()
 
 xpeed::vote_processor::vote_processor (xpeed::node & node_a) :
 node (node_a),
+arrival (0),
 started (false),
 stopped (false),
 active (false),
@@ -1035,8 +1118,16 @@ void xpeed::vote_processor::process_loop ()
 	{
 		if (!votes.empty ())
 		{
+			// Take the highest priority votes, as many as a signature check batch spreads across the checker threads
 			std::deque<std::pair<std::shared_ptr<xpeed::vote>, xpeed::endpoint>> votes_l;
-			votes_l.swap (votes);
+			auto batch_size (256 * (node.config.signature_checker_threads + 1));
+			auto & by_priority (votes.get<0> ());
+			while (!by_priority.empty () && votes_l.size () < batch_size)
+			{
+				auto front (by_priority.begin ());
+				votes_l.push_back (std::make_pair (front->vote, front->endpoint));
+				by_priority.erase (front);
+			}
 
 			log_this_iteration = false;
 			if (node.config.logging.network_logging () && votes_l.size () > 50)
@@ -1052,19 +1143,10 @@ void xpeed::vote_processor::process_loop ()
 			lock.unlock ();
 			verify_votes (votes_l);
 			{
-				std::unique_lock<std::mutex> active_single_lock (node.active.mutex);
 				auto transaction (node.store.tx_begin_read ());
-				uint64_t count (1);
 				for (auto & i : votes_l)
 				{
 					vote_blocking (transaction, i.first, i.second, true);
-					// Free active_transactions mutex each 100 processed votes
-					if (count % 100 == 0)
-					{
-						active_single_lock.unlock ();
-						active_single_lock.lock ();
-					}
-					count++;
 				}
 			}
 			lock.lock ();
@@ -1102,60 +1184,79 @@ void xpeed::vote_processor::process_loop ()
 void xpeed::vote_processor::vote (std::shared_ptr<xpeed::vote> vote_a, xpeed::endpoint endpoint_a)
 {
 	assert (endpoint_a.address ().is_v6 ());
+	xpeed::uint256_union key;
+	blake2b_state hash;
+	blake2b_init (&hash, sizeof (key.bytes));
+	blake2b_update (&hash, vote_a->account.bytes.data (), sizeof (vote_a->account.bytes));
+	for (auto block_hash : *vote_a)
+	{
+		blake2b_update (&hash, block_hash.bytes.data (), sizeof (block_hash.bytes));
+	}
+	blake2b_update (&hash, &vote_a->sequence, sizeof (vote_a->sequence));
+	blake2b_update (&hash, vote_a->signature.bytes.data (), sizeof (vote_a->signature.bytes));
+	blake2b_final (&hash, key.bytes.data (), sizeof (key.bytes));
 	std::unique_lock<std::mutex> lock (mutex);
 	if (!stopped)
 	{
-		bool process (false);
-		/* Random early delection levels
-		Always process votes for test network (process = true)
-		Stop processing with max 144 * 1024 votes */
-		if (!xpeed::is_test_network)
+		auto & by_key (votes.get<1> ());
+		auto existing (by_key.find (key));
+		if (existing != by_key.end ())
 		{
-			// Level 0 (< 0.1%)
-			if (votes.size () < 96 * 1024)
-			{
-				process = true;
-			}
-			// Level 1 (0.1-1%)
-			else if (votes.size () < 112 * 1024)
-			{
-				process = (representatives_1.find (vote_a->account) != representatives_1.end ());
-			}
-			// Level 2 (1-5%)
-			else if (votes.size () < 128 * 1024)
-			{
-				process = (representatives_2.find (vote_a->account) != representatives_2.end ());
-			}
-			// Level 3 (> 5%)
-			else if (votes.size () < 144 * 1024)
-			{
-				process = (representatives_3.find (vote_a->account) != representatives_3.end ());
-			}
-		}
-		else
-		{
-			// Process for test network
-			process = true;
-		}
-		if (process)
-		{
-			votes.push_back (std::make_pair (vote_a, endpoint_a));
-
-			lock.unlock ();
-			condition.notify_all ();
-			lock.lock ();
+			// Only an identical copy is dropped, signatures aren't checked yet so any other vote could be a forgery displacing the genuine one
+			node.stats.inc (xpeed::stat::type::vote, xpeed::stat::detail::vote_duplicate);
 		}
 		else
 		{
-			node.stats.inc (xpeed::stat::type::vote, xpeed::stat::detail::vote_overflow);
-			if (node.config.logging.vote_logging ())
+			auto tier_l (tier (vote_a->account));
+			auto process (true);
+			// Always process votes for test network
+			if (!xpeed::is_test_network && votes.size () >= max_votes)
+			{
+				// Make room by dropping the newest vote of the lowest queued tier if it ranks below this voter
+				auto & by_priority (votes.get<0> ());
+				auto lowest (std::prev (by_priority.end ()));
+				if (lowest->tier < tier_l)
+				{
+					overflow (lowest->tier);
+					by_priority.erase (lowest);
+				}
+				else
+				{
+					overflow (tier_l);
+					process = false;
+				}
+			}
+			if (process)
 			{
-				BOOST_LOG (node.log) << "Votes overflow";
+				uint64_t priority ((static_cast<uint64_t> (tier_count - 1 - tier_l) << 56) | arrival++);
+				votes.insert (xpeed::queued_vote{ vote_a, endpoint_a, key, tier_l, priority });
+
+				lock.unlock ();
+				condition.notify_all ();
+				lock.lock ();
 			}
 		}
 	}
 }
 
+uint8_t xpeed::vote_processor::tier (xpeed::account const & account_a)
+{
+	assert (!mutex.try_lock ());
+	auto existing (representative_tiers.find (account_a));
+	return existing != representative_tiers.end () ? existing->second : 0;
+}
+
+void xpeed::vote_processor::overflow (uint8_t tier_a)
+{
+	static std::array<xpeed::stat::detail, tier_count> const details{ xpeed::stat::detail::vote_overflow_tier_0, xpeed::stat::detail::vote_overflow_tier_1, xpeed::stat::detail::vote_overflow_tier_2, xpeed::stat::detail::vote_overflow_tier_3 };
+	node.stats.inc (xpeed::stat::type::vote, xpeed::stat::detail::vote_overflow);
+	node.stats.inc (xpeed::stat::type::vote, details[tier_a]);
+	if (node.config.logging.vote_logging ())
+	{
+		BOOST_LOG (node.log) << "Votes overflow";
+	}
+}
+
 void xpeed::vote_processor::verify_votes (std::deque<std::pair<std::shared_ptr<xpeed::vote>, xpeed::endpoint>> & votes_a)
 {
 	auto size (votes_a.size ());
@@ -1193,17 +1294,15 @@ void xpeed::vote_processor::verify_votes (std::deque<std::pair<std::shared_ptr<x
 	votes_a.swap (result);
 }
 
-// node.active.mutex lock required
 xpeed::vote_code xpeed::vote_processor::vote_blocking (xpeed::transaction const & transaction_a, std::shared_ptr<xpeed::vote> vote_a, xpeed::endpoint endpoint_a, bool validated)
 {
 	assert (endpoint_a.address ().is_v6 ());
-	assert (!node.active.mutex.try_lock ());
 	auto result (xpeed::vote_code::invalid);
 	if (validated || !vote_a->validate ())
 	{
 		auto max_vote (node.store.vote_max (transaction_a, vote_a));
 		result = xpeed::vote_code::replay;
-		if (!node.active.vote (vote_a, true))
+		if (!node.active.vote (vote_a))
 		{
 			result = xpeed::vote_code::vote;
 		}
@@ -1273,32 +1372,30 @@ void xpeed::vote_processor::flush ()
 
 void xpeed::vote_processor::calculate_weights ()
 {
-	std::unique_lock<std::mutex> lock (mutex);
-	if (!stopped)
+	std::unordered_map<xpeed::account, uint8_t> representative_tiers_l;
 	{
-		representatives_1.clear ();
-		representatives_2.clear ();
-		representatives_3.clear ();
 		auto supply (node.online_reps.online_stake ());
 		auto transaction (node.store.tx_begin_read ());
 		for (auto i (node.store.representation_begin (transaction)), n (node.store.representation_end ()); i != n; ++i)
 		{
 			xpeed::account representative (i->first);
 			auto weight (node.ledger.weight (transaction, representative));
-			if (weight > supply / 1000) // 0.1% or above (level 1)
+			if (weight > supply / 20) // 5% or above
 			{
-				representatives_1.insert (representative);
-				if (weight > supply / 100) // 1% or above (level 2)
-				{
-					representatives_2.insert (representative);
-					if (weight > supply / 20) // 5% or above (level 3)
-					{
-						representatives_3.insert (representative);
-					}
-				}
+				representative_tiers_l[representative] = 3;
+			}
+			else if (weight > supply / 100) // 1% or above
+			{
+				representative_tiers_l[representative] = 2;
+			}
+			else if (weight > supply / 1000) // 0.1% or above
+			{
+				representative_tiers_l[representative] = 1;
 			}
 		}
 	}
+	std::lock_guard<std::mutex> lock (mutex);
+	representative_tiers.swap (representative_tiers_l);
 }
 
 namespace xpeed
@@ -1318,23 +1415,17 @@ std::unique_ptr<seq_con_info_component> collect_seq_con_info (node_observers & n
 std::unique_ptr<seq_con_info_component> collect_seq_con_info (vote_processor & vote_processor, const std::string & name)
 {
 	size_t votes_count = 0;
-	size_t representatives_1_count = 0;
-	size_t representatives_2_count = 0;
-	size_t representatives_3_count = 0;
+	size_t representative_tiers_count = 0;
 
 	{
-		std::lock_guard<std::mutex> (vote_processor.mutex);
+		std::lock_guard<std::mutex> guard (vote_processor.mutex);
 		votes_count = vote_processor.votes.size ();
-		representatives_1_count = vote_processor.representatives_1.size ();
-		representatives_2_count = vote_processor.representatives_2.size ();
-		representatives_3_count = vote_processor.representatives_3.size ();
+		representative_tiers_count = vote_processor.representative_tiers.size ();
 	}
 
 	auto composite = std::make_unique<seq_con_info_composite> (name);
 	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "votes", votes_count, sizeof (decltype (vote_processor.votes)::value_type) }));
-	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "representatives_1", representatives_1_count, sizeof (decltype (vote_processor.representatives_1)::value_type) }));
-	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "representatives_2", representatives_2_count, sizeof (decltype (vote_processor.representatives_2)::value_type) }));
-	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "representatives_3", representatives_3_count, sizeof (decltype (vote_processor.representatives_3)::value_type) }));
+	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "representative_tiers", representative_tiers_count, sizeof (decltype (vote_processor.representative_tiers)::value_type) }));
 	return composite;
 }
 }
@@ -1425,6 +1516,7 @@ active (*this),
 network (*this, config.peering_port),
 bootstrap_initiator (*this),
 bootstrap (io_ctx_a, config.peering_port, *this),
+serving (*this),
 peers (network.endpoint ()),
 application_path (application_path_a),
 wallets (init_a.wallet_init, *this),
@@ -1440,6 +1532,7 @@ block_processor_thread ([this]() {
 online_reps (ledger, config.online_weight_minimum.number ()),
 stats (config.stat_config),
 vote_uniquer (block_uniquer),
+confirmation_height_processor (*this),
 startup_time (std::chrono::steady_clock::now ())
 {
 	wallets.observer = [this](bool active) {
@@ -1527,7 +1620,7 @@ startup_time (std::chrono::steady_clock::now ())
 				{
 					BOOST_LOG (log) << boost::str (boost::format ("Found a representative at %1%") % endpoint_a);
 					// Rebroadcasting all active votes to new representative
-					auto blocks (this->active.list_blocks (true));
+					auto blocks (this->active.list_blocks ());
 					for (auto i (blocks.begin ()), n (blocks.end ()); i != n; ++i)
 					{
 						if (*i != nullptr)
@@ -1567,6 +1660,11 @@ startup_time (std::chrono::steady_clock::now ())
 			BOOST_LOG (log) << "Genesis block not found. Make sure the node network ID is correct.";
 			std::exit (1);
 		}
+		if (store.confirmation_height_get (transaction, xpeed::genesis_account) == 0)
+		{
+			// Ledgers created before confirmation heights were tracked start with only the genesis block cemented
+			store.confirmation_height_put (transaction, xpeed::genesis_account, 1);
+		}
 
 		node_id = xpeed::keypair (store.get_node_id (transaction));
 		BOOST_LOG (log) << "Node ID: " << node_id.pub.to_account ();
@@ -1700,14 +1798,15 @@ void xpeed::node::process_fork (xpeed::transaction const & transaction_a, std::s
 	if (!store.block_exists (transaction_a, block_a->type (), block_a->hash ()) && store.root_exists (transaction_a, block_a->root ()))
 	{
 		std::shared_ptr<xpeed::block> ledger_block (ledger.forked_block (transaction_a, *block_a));
-		if (ledger_block)
+		// A cemented block can't lose a fork, so there is nothing to elect
+		if (ledger_block && !ledger.block_confirmed (transaction_a, ledger_block->hash ()))
 		{
 			std::weak_ptr<xpeed::node> this_w (shared_from_this ());
 			if (!active.start (ledger_block, [this_w, root](std::shared_ptr<xpeed::block>) {
 				    if (auto this_l = this_w.lock ())
 				    {
 					    auto attempt (this_l->bootstrap_initiator.current_attempt ());
-					    if (attempt && attempt->mode == xpeed::bootstrap_mode::legacy)
+					    if (attempt && attempt->pulls_chains ())
 					    {
 						    auto transaction (this_l->store.tx_begin_read ());
 						    auto account (this_l->ledger.store.frontier_get (transaction, root));
@@ -1742,7 +1841,11 @@ std::unique_ptr<seq_con_info_component> collect_seq_con_info (node & node, const
 	composite->add_component (collect_seq_con_info (node.active, "active"));
 	composite->add_component (collect_seq_con_info (node.bootstrap_initiator, "bootstrap_initiator"));
 	composite->add_component (collect_seq_con_info (node.bootstrap, "bootstrap"));
+	composite->add_component (collect_seq_con_info (node.serving, "serving_scheduler"));
 	composite->add_component (collect_seq_con_info (node.peers, "peers"));
+	composite->add_component (collect_seq_con_info (node.network.limiter, "peer_limiter"));
+	composite->add_component (collect_seq_con_info (node.network.propagation, "propagation"));
+	composite->add_component (collect_seq_con_info (node.network.channels, "tcp_channels"));
 	composite->add_component (collect_seq_con_info (node.observers, "observers"));
 	composite->add_component (collect_seq_con_info (node.wallets, "wallets"));
 	composite->add_component (collect_seq_con_info (node.vote_processor, "vote_processor"));
@@ -1753,6 +1856,7 @@ std::unique_ptr<seq_con_info_component> collect_seq_con_info (node & node, const
 	composite->add_component (collect_seq_con_info (node.votes_cache, "votes_cache"));
 	composite->add_component (collect_seq_con_info (node.block_uniquer, "block_uniquer"));
 	composite->add_component (collect_seq_con_info (node.vote_uniquer, "vote_uniquer"));
+	composite->add_component (collect_seq_con_info (node.confirmation_height_processor, "confirmation_height_processor"));
 	return composite;
 }
 }
@@ -1870,20 +1974,7 @@ void xpeed::network::confirm_send (xpeed::confirm_ack const & confirm_a, std::sh
 	{
 		BOOST_LOG (node.log) << boost::str (boost::format ("Sending confirm_ack for block(s) %1%to %2% sequence %3%") % confirm_a.vote->hashes_string () % endpoint_a % std::to_string (confirm_a.vote->sequence));
 	}
-	std::weak_ptr<xpeed::node> node_w (node.shared ());
-	node.network.send_buffer (bytes_a->data (), bytes_a->size (), endpoint_a, [bytes_a, node_w, endpoint_a](boost::system::error_code const & ec, size_t size_a) {
-		if (auto node_l = node_w.lock ())
-		{
-			if (ec && node_l->config.logging.network_logging ())
-			{
-				BOOST_LOG (node_l->log) << boost::str (boost::format ("Error broadcasting confirm_ack to %1%: %2%") % endpoint_a % ec.message ());
-			}
-			else
-			{
-				node_l->stats.inc (xpeed::stat::type::message, xpeed::stat::detail::confirm_ack, xpeed::stat::dir::out);
-			}
-		}
-	});
+	send (bytes_a, endpoint_a, xpeed::stat::detail::confirm_ack);
 }
 
 void xpeed::node::process_active (std::shared_ptr<xpeed::block> incoming)
@@ -1948,9 +2039,11 @@ void xpeed::node::stop ()
 	}
 	vote_processor.stop ();
 	active.stop ();
+	confirmation_height_processor.stop ();
 	network.stop ();
 	bootstrap_initiator.stop ();
 	bootstrap.stop ();
+	serving.stop ();
 	port_mapping.stop ();
 	checker.stop ();
 	wallets.stop ();
@@ -2013,6 +2106,8 @@ void xpeed::node::ongoing_keepalive ()
 {
 	keepalive_preconfigured (config.preconfigured_peers);
 	auto peers_l (peers.purge_list (std::chrono::steady_clock::now () - cutoff));
+	network.limiter.purge (std::chrono::steady_clock::now () - cutoff);
+	serving.purge (std::chrono::steady_clock::now () - cutoff);
 	for (auto i (peers_l.begin ()), j (peers_l.end ()); i != j && std::chrono::steady_clock::now () - i->last_attempt > period; ++i)
 	{
 		network.send_keepalive (i->endpoint);
@@ -2561,12 +2656,25 @@ void xpeed::node::add_initial_peers ()
 
 void xpeed::node::block_confirm (std::shared_ptr<xpeed::block> block_a)
 {
-	active.start (block_a);
-	network.broadcast_confirm_req (block_a);
-	// Calculate votes for local representatives
-	if (config.enable_voting && active.active (*block_a))
+	auto confirmed (false);
 	{
-		block_processor.generator.add (block_a->hash ());
+		auto transaction (store.tx_begin_read ());
+		confirmed = ledger.block_confirmed (transaction, block_a->hash ());
+	}
+	if (confirmed)
+	{
+		// Already cemented, report it without holding another election
+		process_confirmed (block_a);
+	}
+	else
+	{
+		active.start (block_a);
+		network.broadcast_confirm_req (block_a);
+		// Calculate votes for local representatives
+		if (config.enable_voting && active.active (*block_a))
+		{
+			block_processor.generator.add (block_a->hash ());
+		}
 	}
 }
 
@@ -2669,6 +2777,7 @@ void xpeed::node::process_confirmed (std::shared_ptr<xpeed::block> block_a, uint
 	if (ledger.block_exists (block_a->type (), hash))
 	{
 		auto transaction (store.tx_begin_read ());
+		confirmation_height_processor.add (hash);
 		confirmed_visitor visitor (transaction, *this, block_a, hash);
 		block_a->visit (visitor);
 		auto account (ledger.account (transaction, hash));
@@ -2978,7 +3087,14 @@ void xpeed::network::send_buffer (uint8_t const * data_a, size_t size_a, xpeed::
 	{
 		BOOST_LOG (node.log) << "Sending packet";
 	}
-	if (on.load ())
+	if (on.load () && transport != nullptr)
+	{
+		lock.unlock ();
+		transport->send (std::make_shared<std::vector<uint8_t>> (data_a, data_a + size_a), endpoint (), endpoint_a);
+		node.stats.add (xpeed::stat::type::traffic, xpeed::stat::dir::out, size_a);
+		callback_a (boost::system::error_code (), size_a);
+	}
+	else if (on.load ())
 	{
 		socket.async_send_to (boost::asio::buffer (data_a, size_a), endpoint_a, [this, callback_a](boost::system::error_code const & ec, size_t size_a) {
 			callback_a (ec, size_a);
@@ -2995,6 +3111,14 @@ void xpeed::network::send_buffer (uint8_t const * data_a, size_t size_a, xpeed::
 	}
 }
 
+void xpeed::network::send (std::shared_ptr<std::vector<uint8_t>> const & bytes_a, xpeed::endpoint const & endpoint_a, xpeed::stat::detail detail_a)
+{
+	if (channels.send (bytes_a, endpoint_a, detail_a))
+	{
+		egress.send (bytes_a, endpoint_a, detail_a);
+	}
+}
+
 std::shared_ptr<xpeed::node> xpeed::node::shared ()
 {
 	return shared_from_this ();
@@ -3015,10 +3139,12 @@ xpeed::election_vote_result::election_vote_result (bool replay_a, bool processed
 xpeed::election::election (xpeed::node & node_a, std::shared_ptr<xpeed::block> block_a, std::function<void(std::shared_ptr<xpeed::block>)> const & confirmation_action_a) :
 confirmation_action (confirmation_action_a),
 node (node_a),
+root (block_a->previous (), block_a->root ()),
 election_start (std::chrono::steady_clock::now ()),
 status ({ block_a, 0 }),
 confirmed (false),
 stopped (false),
+erased (false),
 announcements (0)
 {
 	last_votes.insert (std::make_pair (xpeed::not_an_account (), xpeed::vote_info{ std::chrono::steady_clock::now (), 0, block_a->hash () }));
@@ -3036,7 +3162,7 @@ void xpeed::election::compute_rep_votes (xpeed::transaction const & transaction_
 	}
 }
 
-void xpeed::election::confirm_once (xpeed::transaction const & transaction_a, bool confirmed_back)
+void xpeed::election::confirm_once (bool confirmed_back)
 {
 	if (!confirmed.exchange (true))
 	{
@@ -3045,36 +3171,15 @@ void xpeed::election::confirm_once (xpeed::transaction const & transaction_a, bo
 		auto winner_l (status.winner);
 		auto node_l (node.shared ());
 		auto confirmation_action_l (confirmation_action);
-		node.background ([node_l, winner_l, confirmation_action_l]() {
+		// Dependent elections live in other shards, confirm them once this shard's lock is released
+		node.background ([node_l, winner_l, confirmation_action_l, confirmed_back]() {
+			if (!confirmed_back)
+			{
+				node_l->active.confirm_back (winner_l);
+			}
 			node_l->process_confirmed (winner_l);
 			confirmation_action_l (winner_l);
 		});
-		if (!confirmed_back)
-		{
-			confirm_back (transaction_a);
-		}
-	}
-}
-
-void xpeed::election::confirm_back (xpeed::transaction const & transaction_a)
-{
-	std::deque<xpeed::block_hash> hashes = { status.winner->previous (), status.winner->source (), status.winner->link () };
-	while (!hashes.empty ())
-	{
-		auto hash (hashes.front ());
-		hashes.pop_front ();
-		if (!hash.is_zero () && !node.ledger.is_epoch_link (hash))
-		{
-			auto existing (node.active.blocks.find (hash));
-			if (existing != node.active.blocks.end () && !existing->second->confirmed && !existing->second->stopped && existing->second->blocks.size () == 1)
-			{
-				release_assert (existing->second->status.winner->hash () == hash);
-				existing->second->confirm_once (transaction_a, true); // Avoid recursive actions
-				hashes.push_back (existing->second->status.winner->previous ());
-				hashes.push_back (existing->second->status.winner->source ());
-				hashes.push_back (existing->second->status.winner->link ());
-			}
-		}
 	}
 }
 
@@ -3100,14 +3205,13 @@ bool xpeed::election::have_quorum (xpeed::tally_t const & tally_a, xpeed::uint12
 
 xpeed::tally_t xpeed::election::tally (xpeed::transaction const & transaction_a)
 {
-	std::unordered_map<xpeed::block_hash, xpeed::uint128_t> block_weights;
-	for (auto vote_info : last_votes)
+	last_tally.clear ();
+	for (auto & vote_info : last_votes)
 	{
-		block_weights[vote_info.second.hash] += node.ledger.weight (transaction_a, vote_info.first);
+		last_tally[vote_info.second.hash] += node.ledger.weight (transaction_a, vote_info.first);
 	}
-	last_tally = block_weights;
 	xpeed::tally_t result;
-	for (auto item : block_weights)
+	for (auto & item : last_tally)
 	{
 		auto block (blocks.find (item.first));
 		if (block != blocks.end ())
@@ -3142,7 +3246,7 @@ void xpeed::election::confirm_if_quorum (xpeed::transaction const & transaction_
 		{
 			log_votes (tally_l);
 		}
-		confirm_once (transaction_a);
+		confirm_once ();
 	}
 }
 
@@ -3292,198 +3396,214 @@ bool xpeed::election::publish (std::shared_ptr<xpeed::block> block_a)
 	return result;
 }
 
+size_t xpeed::election::memory_size () const
+{
+	return sizeof (*this) + last_votes.heap_size () + blocks.heap_size () + last_tally.heap_size ();
+}
+
 size_t xpeed::election::last_votes_size ()
 {
-	std::lock_guard<std::mutex> lock (node.active.mutex);
+	auto lock (node.active.lock_shard (node.active.root_shard (root)));
 	return last_votes.size ();
 }
 
-void xpeed::active_transactions::request_confirm (std::unique_lock<std::mutex> & lock_a)
+size_t xpeed::active_transactions::request_confirm (xpeed::active_shard & shard_a)
 {
-	std::unordered_set<xpeed::uint512_union> inactive;
+	std::vector<xpeed::uint512_union> inactive;
+	std::vector<xpeed::election_status> confirmed_l;
+	// Escalated elections may belong to any shard and are started once this shard is unlocked
+	std::vector<std::shared_ptr<xpeed::block>> escalate;
+	auto roots_size (size ());
 	auto transaction (node.store.tx_begin_read ());
 	unsigned unconfirmed_count (0);
 	unsigned unconfirmed_announcements (0);
+	size_t handled (0);
 	std::unordered_map<xpeed::endpoint, std::vector<std::pair<xpeed::block_hash, xpeed::block_hash>>> requests_bundle;
 	std::deque<std::shared_ptr<xpeed::block>> rebroadcast_bundle;
 	std::deque<std::pair<std::shared_ptr<xpeed::block>, std::shared_ptr<std::vector<xpeed::peer_information>>>> confirm_req_bundle;
 
-	auto roots_size (roots.size ());
-	for (auto i (roots.get<1> ().begin ()), n (roots.get<1> ().end ()); i != n; ++i)
 	{
-		auto root (i->root);
-		auto election_l (i->election);
-		if ((election_l->confirmed || election_l->stopped) && election_l->announcements >= announcement_min - 1)
-		{
-			if (election_l->confirmed)
-			{
-				confirmed.push_back (election_l->status);
-				if (confirmed.size () > election_history_size)
-				{
-					confirmed.pop_front ();
-				}
-			}
-			inactive.insert (root);
-		}
-		else
+		auto lock (lock_shard (shard_a));
+		auto now (std::chrono::steady_clock::now ());
+		auto & roots_by_difficulty (shard_a.roots.get<1> ());
+		for (auto i (roots_by_difficulty.begin ()), n (roots_by_difficulty.end ()); i != n && handled < requests_per_tick; ++i)
 		{
-			if (election_l->announcements > announcement_long)
+			if (i->next_request <= now)
 			{
-				++unconfirmed_count;
-				unconfirmed_announcements += election_l->announcements;
-				// Log votes for very long unconfirmed elections
-				if (election_l->announcements % 50 == 1)
+				++handled;
+				roots_by_difficulty.modify (i, [now](xpeed::conflict_info & info_a) {
+					info_a.next_request = now + std::chrono::milliseconds (request_interval_ms);
+				});
+				auto root (i->root);
+				auto election_l (i->election);
+				if ((election_l->confirmed || election_l->stopped) && election_l->announcements >= announcement_min - 1)
 				{
-					auto tally_l (election_l->tally (transaction));
-					election_l->log_votes (tally_l);
+					if (election_l->confirmed)
+					{
+						confirmed_l.push_back (election_l->status);
+					}
+					inactive.push_back (root);
 				}
-				/* Escalation for long unconfirmed elections
-				Start new elections for previous block & source
-				if there are less than 100 active elections */
-				if (election_l->announcements % announcement_long == 1 && roots_size < 100 && !xpeed::is_test_network)
+				else
 				{
-					std::shared_ptr<xpeed::block> previous;
-					auto previous_hash (election_l->status.winner->previous ());
-					if (!previous_hash.is_zero ())
+					if (election_l->announcements > announcement_long)
 					{
-						previous = node.store.block_get (transaction, previous_hash);
-						if (previous != nullptr)
+						++unconfirmed_count;
+						unconfirmed_announcements += election_l->announcements;
+						// Log votes for very long unconfirmed elections
+						if (election_l->announcements % 50 == 1)
 						{
-							add (std::move (previous));
+							auto tally_l (election_l->tally (transaction));
+							election_l->log_votes (tally_l);
 						}
-					}
-					/* If previous block not existing/not commited yet, block_source can cause segfault for state blocks
-					So source check can be done only if previous != nullptr or previous is 0 (open account) */
-					if (previous_hash.is_zero () || previous != nullptr)
-					{
-						auto source_hash (node.ledger.block_source (transaction, *election_l->status.winner));
-						if (!source_hash.is_zero ())
+						/* Escalation for long unconfirmed elections
+						Start new elections for previous block & source
+						if there are less than 100 active elections */
+						if (election_l->announcements % announcement_long == 1 && roots_size < 100 && !xpeed::is_test_network)
 						{
-							auto source (node.store.block_get (transaction, source_hash));
-							if (source != nullptr)
+							std::shared_ptr<xpeed::block> previous;
+							auto previous_hash (election_l->status.winner->previous ());
+							if (!previous_hash.is_zero ())
 							{
-								add (std::move (source));
+								previous = node.store.block_get (transaction, previous_hash);
+								if (previous != nullptr)
+								{
+									escalate.push_back (previous);
+								}
+							}
+							/* If previous block not existing/not commited yet, block_source can cause segfault for state blocks
+							So source check can be done only if previous != nullptr or previous is 0 (open account) */
+							if (previous_hash.is_zero () || previous != nullptr)
+							{
+								auto source_hash (node.ledger.block_source (transaction, *election_l->status.winner));
+								if (!source_hash.is_zero ())
+								{
+									auto source (node.store.block_get (transaction, source_hash));
+									if (source != nullptr)
+									{
+										escalate.push_back (source);
+									}
+								}
 							}
 						}
 					}
-				}
-			}
-			if (election_l->announcements < announcement_long || election_l->announcements % announcement_long == 1)
-			{
-				if (node.ledger.could_fit (transaction, *election_l->status.winner))
-				{
-					// Broadcast winner
-					if (rebroadcast_bundle.size () < max_broadcast_queue)
-					{
-						rebroadcast_bundle.push_back (election_l->status.winner);
-					}
-				}
-				else
-				{
-					if (election_l->announcements != 0)
-					{
-						election_l->stop ();
-					}
-				}
-			}
-			if (election_l->announcements % 4 == 1)
-			{
-				auto reps (std::make_shared<std::vector<xpeed::peer_information>> (node.peers.representatives (std::numeric_limits<size_t>::max ())));
-				std::unordered_set<xpeed::account> probable_reps;
-				xpeed::uint128_t total_weight (0);
-				for (auto j (reps->begin ()), m (reps->end ()); j != m;)
-				{
-					auto & rep_votes (election_l->last_votes);
-					auto rep_acct (j->probable_rep_account);
-					// Calculate if representative isn't recorded for several IP addresses
-					if (probable_reps.find (rep_acct) == probable_reps.end ())
-					{
-						total_weight = total_weight + j->rep_weight.number ();
-						probable_reps.insert (rep_acct);
-					}
-					if (rep_votes.find (rep_acct) != rep_votes.end ())
+					if (election_l->announcements < announcement_long || election_l->announcements % announcement_long == 1)
 					{
-						if (j + 1 == reps->end ())
+						if (node.ledger.could_fit (transaction, *election_l->status.winner))
 						{
-							reps->pop_back ();
-							break;
+							// Broadcast winner
+							if (rebroadcast_bundle.size () < max_broadcast_queue)
+							{
+								rebroadcast_bundle.push_back (election_l->status.winner);
+							}
 						}
-
-						std::swap (*j, reps->back ());
-						reps->pop_back ();
-						m = reps->end ();
-					}
-					else
-					{
-						++j;
-						if (node.config.logging.vote_logging ())
+						else
 						{
-							BOOST_LOG (node.log) << "Representative did not respond to confirm_req, retrying: " << rep_acct.to_account ();
+							if (election_l->announcements != 0)
+							{
+								election_l->stop ();
+							}
 						}
 					}
-				}
-				if ((!reps->empty () && total_weight > node.config.online_weight_minimum.number ()) || roots_size > 5)
-				{
-					// broadcast_confirm_req_base modifies reps, so we clone it once to avoid aliasing
-					if (!xpeed::is_test_network)
+					if (election_l->announcements % 4 == 1)
 					{
-						if (confirm_req_bundle.size () < max_broadcast_queue)
+						auto reps (std::make_shared<std::vector<xpeed::peer_information>> (node.peers.representatives (std::numeric_limits<size_t>::max ())));
+						std::unordered_set<xpeed::account> probable_reps;
+						xpeed::uint128_t total_weight (0);
+						for (auto j (reps->begin ()), m (reps->end ()); j != m;)
 						{
-							confirm_req_bundle.push_back (std::make_pair (election_l->status.winner, reps));
-						}
-					}
-					else
-					{
-						for (auto & rep : *reps)
+							auto & rep_votes (election_l->last_votes);
+							auto rep_acct (j->probable_rep_account);
+							// Calculate if representative isn't recorded for several IP addresses
+							if (probable_reps.find (rep_acct) == probable_reps.end ())
+							{
+								total_weight = total_weight + j->rep_weight.number ();
+								probable_reps.insert (rep_acct);
+							}
+							if (rep_votes.find (rep_acct) != rep_votes.end ())
+							{
+								if (j + 1 == reps->end ())
+								{
+									reps->pop_back ();
+									break;
+								}
+
+								std::swap (*j, reps->back ());
+								reps->pop_back ();
+								m = reps->end ();
+							}
+							else
+							{
+								++j;
+								if (node.config.logging.vote_logging ())
+								{
+									BOOST_LOG (node.log) << "Representative did not respond to confirm_req, retrying: " << rep_acct.to_account ();
+								}
+							}
+						}
+						if ((!reps->empty () && total_weight > node.config.online_weight_minimum.number ()) || roots_size > 5)
 						{
-							auto rep_request (requests_bundle.find (rep.endpoint));
-							auto block (election_l->status.winner);
-							auto root_hash (std::make_pair (block->hash (), block->root ()));
-							if (rep_request == requests_bundle.end ())
+							// broadcast_confirm_req_base modifies reps, so we clone it once to avoid aliasing
+							if (!xpeed::is_test_network)
 							{
-								if (requests_bundle.size () < max_broadcast_queue)
+								if (confirm_req_bundle.size () < max_broadcast_queue)
 								{
-									std::vector<std::pair<xpeed::block_hash, xpeed::block_hash>> insert_vector = { root_hash };
-									requests_bundle.insert (std::make_pair (rep.endpoint, insert_vector));
+									confirm_req_bundle.push_back (std::make_pair (election_l->status.winner, reps));
 								}
 							}
-							else if (rep_request->second.size () < max_broadcast_queue * xpeed::network::confirm_req_hashes_max)
+							else
 							{
-								rep_request->second.push_back (root_hash);
+								for (auto & rep : *reps)
+								{
+									auto rep_request (requests_bundle.find (rep.endpoint));
+									auto block (election_l->status.winner);
+									auto root_hash (std::make_pair (block->hash (), block->root ()));
+									if (rep_request == requests_bundle.end ())
+									{
+										if (requests_bundle.size () < max_broadcast_queue)
+										{
+											std::vector<std::pair<xpeed::block_hash, xpeed::block_hash>> insert_vector = { root_hash };
+											requests_bundle.insert (std::make_pair (rep.endpoint, insert_vector));
+										}
+									}
+									else if (rep_request->second.size () < max_broadcast_queue * xpeed::network::confirm_req_hashes_max)
+									{
+										rep_request->second.push_back (root_hash);
+									}
+								}
 							}
 						}
-					}
-				}
-				else
-				{
-					if (!xpeed::is_test_network)
-					{
-						confirm_req_bundle.push_back (std::make_pair (election_l->status.winner, std::make_shared<std::vector<xpeed::peer_information>> (node.peers.list_vector (100))));
-					}
-					else
-					{
-						for (auto & rep : *reps)
+						else
 						{
-							auto rep_request (requests_bundle.find (rep.endpoint));
-							auto block (election_l->status.winner);
-							auto root_hash (std::make_pair (block->hash (), block->root ()));
-							if (rep_request == requests_bundle.end ())
+							if (!xpeed::is_test_network)
 							{
-								std::vector<std::pair<xpeed::block_hash, xpeed::block_hash>> insert_vector = { root_hash };
-								requests_bundle.insert (std::make_pair (rep.endpoint, insert_vector));
+								confirm_req_bundle.push_back (std::make_pair (election_l->status.winner, std::make_shared<std::vector<xpeed::peer_information>> (node.peers.list_vector (100))));
 							}
 							else
 							{
-								rep_request->second.push_back (root_hash);
+								for (auto & rep : *reps)
+								{
+									auto rep_request (requests_bundle.find (rep.endpoint));
+									auto block (election_l->status.winner);
+									auto root_hash (std::make_pair (block->hash (), block->root ()));
+									if (rep_request == requests_bundle.end ())
+									{
+										std::vector<std::pair<xpeed::block_hash, xpeed::block_hash>> insert_vector = { root_hash };
+										requests_bundle.insert (std::make_pair (rep.endpoint, insert_vector));
+									}
+									else
+									{
+										rep_request->second.push_back (root_hash);
+									}
+								}
 							}
 						}
 					}
 				}
+				++election_l->announcements;
 			}
 		}
-		++election_l->announcements;
 	}
-	lock_a.unlock ();
 	// Rebroadcast unconfirmed blocks
 	if (!rebroadcast_bundle.empty ())
 	{
@@ -3499,23 +3619,48 @@ void xpeed::active_transactions::request_confirm (std::unique_lock<std::mutex> &
 	{
 		node.network.broadcast_confirm_req_batch (confirm_req_bundle);
 	}
-	lock_a.lock ();
-	for (auto i (inactive.begin ()), n (inactive.end ()); i != n; ++i)
+	for (auto & block : escalate)
 	{
-		auto root_it (roots.find (*i));
-		assert (root_it != roots.end ());
-		for (auto & block : root_it->election->blocks)
+		add (std::move (block));
+	}
+	if (!confirmed_l.empty ())
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		for (auto & status : confirmed_l)
 		{
-			auto erased (blocks.erase (block.first));
-			(void)erased;
-			assert (erased == 1);
+			confirmed.push_back (status);
+			if (confirmed.size () > election_history_size)
+			{
+				confirmed.pop_front ();
+			}
 		}
-		roots.erase (*i);
+	}
+	for (auto & root : inactive)
+	{
+		std::shared_ptr<xpeed::election> election_l;
+		std::vector<xpeed::block_hash> hashes;
+		{
+			auto lock (lock_shard (shard_a));
+			auto existing (shard_a.roots.find (root));
+			assert (existing != shard_a.roots.end ());
+			election_l = existing->election;
+			hashes = erase_root (shard_a, root);
+		}
+		erase_blocks (election_l, hashes);
 	}
 	if (unconfirmed_count > 0)
 	{
 		BOOST_LOG (node.log) << boost::str (boost::format ("%1% blocks have been unconfirmed averaging %2% announcements") % unconfirmed_count % (unconfirmed_announcements / unconfirmed_count));
 	}
+	if (handled > 0)
+	{
+		node.stats.add (xpeed::stat::type::active, xpeed::stat::detail::election_request, xpeed::stat::dir::out, handled);
+	}
+	if (handled == requests_per_tick)
+	{
+		node.stats.inc (xpeed::stat::type::active, xpeed::stat::detail::request_slice_full, xpeed::stat::dir::out);
+	}
+	return handled;
 }
 
 void xpeed::active_transactions::request_loop ()
@@ -3529,9 +3674,13 @@ void xpeed::active_transactions::request_loop ()
 
 	while (!stopped)
 	{
-		request_confirm (lock);
-		const auto extra_delay (std::min (roots.size (), max_broadcast_queue) * node.network.broadcast_interval_ms * 2);
-		condition.wait_for (lock, std::chrono::milliseconds (request_interval_ms + extra_delay));
+		// Each tick advances the wheel by one shard, every shard is visited once per request interval
+		lock.unlock ();
+		auto handled (request_confirm (shards[next_shard]));
+		next_shard = (next_shard + 1) % shard_count;
+		lock.lock ();
+		const auto extra_delay (std::min (handled, max_broadcast_queue) * node.network.broadcast_interval_ms * 2);
+		condition.wait_for (lock, std::chrono::milliseconds (std::max<size_t> (request_interval_ms / shard_count, 1) + extra_delay));
 	}
 }
 
@@ -3549,13 +3698,39 @@ void xpeed::active_transactions::stop ()
 	{
 		thread.join ();
 	}
-	lock.lock ();
-	roots.clear ();
+	for (auto & shard : shards)
+	{
+		std::lock_guard<std::mutex> shard_lock (shard.mutex);
+		shard.roots.clear ();
+		shard.blocks.clear ();
+	}
 }
 
-bool xpeed::active_transactions::start (std::shared_ptr<xpeed::block> block_a, std::function<void(std::shared_ptr<xpeed::block>)> const & confirmation_action_a)
+void * xpeed::election_pool::allocate (size_t size_a)
 {
 	std::lock_guard<std::mutex> lock (mutex);
+	if (pool == nullptr)
+	{
+		pool = std::make_unique<boost::pool<>> (size_a);
+	}
+	assert (pool->get_requested_size () == size_a);
+	auto result (pool->malloc ());
+	if (result == nullptr)
+	{
+		throw std::bad_alloc ();
+	}
+	return result;
+}
+
+void xpeed::election_pool::deallocate (void * pointer_a, size_t size_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	assert (pool != nullptr && pool->get_requested_size () == size_a);
+	pool->free (pointer_a);
+}
+
+bool xpeed::active_transactions::start (std::shared_ptr<xpeed::block> block_a, std::function<void(std::shared_ptr<xpeed::block>)> const & confirmation_action_a)
+{
 	return add (block_a, confirmation_action_a);
 }
 
@@ -3565,57 +3740,167 @@ bool xpeed::active_transactions::add (std::shared_ptr<xpeed::block> block_a, std
 	if (!stopped)
 	{
 		auto root (xpeed::uint512_union (block_a->previous (), block_a->root ()));
-		auto existing (roots.find (root));
-		if (existing == roots.end ())
+		std::shared_ptr<xpeed::election> election;
+		{
+			auto & shard (root_shard (root));
+			auto lock (lock_shard (shard));
+			auto existing (shard.roots.find (root));
+			if (existing == shard.roots.end ())
+			{
+				election = std::allocate_shared<xpeed::election> (xpeed::election_allocator<xpeed::election> (shard.pool), node, block_a, confirmation_action_a);
+				uint64_t difficulty (0);
+				auto error (xpeed::work_validate (*block_a, &difficulty));
+				release_assert (!error);
+				shard.roots.insert (xpeed::conflict_info{ root, difficulty, election, std::chrono::steady_clock::now () });
+			}
+		}
+		if (election != nullptr)
 		{
-			auto election (std::make_shared<xpeed::election> (node, block_a, confirmation_action_a));
-			uint64_t difficulty (0);
-			auto error (xpeed::work_validate (*block_a, &difficulty));
-			release_assert (!error);
-			roots.insert (xpeed::conflict_info{ root, difficulty, election });
-			blocks.insert (std::make_pair (block_a->hash (), election));
+			index_block (block_a->hash (), election);
 		}
-		error = existing != roots.end ();
+		error = election == nullptr;
 	}
 	return error;
 }
 
-// Validate a vote and apply it to the current election if one exists
-bool xpeed::active_transactions::vote (std::shared_ptr<xpeed::vote> vote_a, bool single_lock)
+void xpeed::active_transactions::index_block (xpeed::block_hash const & hash_a, std::shared_ptr<xpeed::election> election_a)
 {
-	std::shared_ptr<xpeed::election> election;
-	bool replay (false);
-	bool processed (false);
+	auto & shard (block_shard (hash_a));
+	auto lock (lock_shard (shard));
+	shard.blocks[hash_a] = election_a;
+	// The election may have been erased after it published this block, don't leave a stale entry behind
+	if (election_a->erased)
+	{
+		shard.blocks.erase (hash_a);
+	}
+}
+
+std::vector<xpeed::block_hash> xpeed::active_transactions::erase_root (xpeed::active_shard & shard_a, xpeed::uint512_union const & root_a)
+{
+	std::vector<xpeed::block_hash> result;
+	auto existing (shard_a.roots.find (root_a));
+	if (existing != shard_a.roots.end ())
 	{
-		std::unique_lock<std::mutex> lock;
-		if (!single_lock)
+		existing->election->erased = true;
+		for (auto & block : existing->election->blocks)
 		{
-			lock = std::unique_lock<std::mutex> (mutex);
+			result.push_back (block.first);
 		}
-		for (auto vote_block : vote_a->blocks)
+		shard_a.roots.erase (existing);
+	}
+	return result;
+}
+
+void xpeed::active_transactions::erase_blocks (std::shared_ptr<xpeed::election> election_a, std::vector<xpeed::block_hash> const & hashes_a)
+{
+	for (auto & hash : hashes_a)
+	{
+		auto & shard (block_shard (hash));
+		auto lock (lock_shard (shard));
+		auto existing (shard.blocks.find (hash));
+		if (existing != shard.blocks.end () && existing->second == election_a)
 		{
-			xpeed::election_vote_result result;
-			if (vote_block.which ())
+			shard.blocks.erase (existing);
+		}
+	}
+}
+
+xpeed::active_shard & xpeed::active_transactions::root_shard (xpeed::uint512_union const & root_a)
+{
+	// Mix previous and root, open blocks all have a zero previous
+	return shards[(root_a.qwords[0] ^ root_a.qwords[4]) % shard_count];
+}
+
+xpeed::active_shard & xpeed::active_transactions::block_shard (xpeed::block_hash const & hash_a)
+{
+	return shards[hash_a.qwords[0] % shard_count];
+}
+
+std::unique_lock<std::mutex> xpeed::active_transactions::lock_shard (xpeed::active_shard & shard_a)
+{
+	std::unique_lock<std::mutex> result (shard_a.mutex, std::try_to_lock);
+	if (!result.owns_lock ())
+	{
+		node.stats.inc (xpeed::stat::type::active, xpeed::stat::detail::shard_contention);
+		result.lock ();
+	}
+	return result;
+}
+
+std::shared_ptr<xpeed::election> xpeed::active_transactions::election (xpeed::block_hash const & hash_a)
+{
+	std::shared_ptr<xpeed::election> result;
+	auto & shard (block_shard (hash_a));
+	auto lock (lock_shard (shard));
+	auto existing (shard.blocks.find (hash_a));
+	if (existing != shard.blocks.end ())
+	{
+		result = existing->second;
+	}
+	return result;
+}
+
+void xpeed::active_transactions::confirm_back (std::shared_ptr<xpeed::block> winner_a)
+{
+	std::deque<xpeed::block_hash> hashes = { winner_a->previous (), winner_a->source (), winner_a->link () };
+	while (!hashes.empty ())
+	{
+		auto hash (hashes.front ());
+		hashes.pop_front ();
+		if (!hash.is_zero () && !node.ledger.is_epoch_link (hash))
+		{
+			auto existing (election (hash));
+			if (existing != nullptr)
 			{
-				auto block_hash (boost::get<xpeed::block_hash> (vote_block));
-				auto existing (blocks.find (block_hash));
-				if (existing != blocks.end ())
+				auto lock (lock_shard (root_shard (existing->root)));
+				if (!existing->erased && !existing->confirmed && !existing->stopped && existing->blocks.size () == 1)
 				{
-					result = existing->second->vote (vote_a->account, vote_a->sequence, block_hash);
+					release_assert (existing->status.winner->hash () == hash);
+					existing->confirm_once (true); // Avoid recursive actions
+					hashes.push_back (existing->status.winner->previous ());
+					hashes.push_back (existing->status.winner->source ());
+					hashes.push_back (existing->status.winner->link ());
 				}
 			}
-			else
+		}
+	}
+}
+
+// Validate a vote and apply it to the current election if one exists
+bool xpeed::active_transactions::vote (std::shared_ptr<xpeed::vote> vote_a)
+{
+	bool replay (false);
+	bool processed (false);
+	for (auto vote_block : vote_a->blocks)
+	{
+		xpeed::election_vote_result result;
+		if (vote_block.which ())
+		{
+			auto block_hash (boost::get<xpeed::block_hash> (vote_block));
+			auto existing (election (block_hash));
+			if (existing != nullptr)
 			{
-				auto block (boost::get<std::shared_ptr<xpeed::block>> (vote_block));
-				auto existing (roots.find (xpeed::uint512_union (block->previous (), block->root ())));
-				if (existing != roots.end ())
+				auto lock (lock_shard (root_shard (existing->root)));
+				if (!existing->erased)
 				{
-					result = existing->election->vote (vote_a->account, vote_a->sequence, block->hash ());
+					result = existing->vote (vote_a->account, vote_a->sequence, block_hash);
 				}
 			}
-			replay = replay || result.replay;
-			processed = processed || result.processed;
 		}
+		else
+		{
+			auto block (boost::get<std::shared_ptr<xpeed::block>> (vote_block));
+			auto root (xpeed::uint512_union (block->previous (), block->root ()));
+			auto & shard (root_shard (root));
+			auto lock (lock_shard (shard));
+			auto existing (shard.roots.find (root));
+			if (existing != shard.roots.end ())
+			{
+				result = existing->election->vote (vote_a->account, vote_a->sequence, block->hash ());
+			}
+		}
+		replay = replay || result.replay;
+		processed = processed || result.processed;
 	}
 	if (processed)
 	{
@@ -3626,37 +3911,40 @@ bool xpeed::active_transactions::vote (std::shared_ptr<xpeed::vote> vote_a, bool
 
 bool xpeed::active_transactions::active (xpeed::block const & block_a)
 {
-	std::lock_guard<std::mutex> lock (mutex);
-	return roots.find (xpeed::uint512_union (block_a.previous (), block_a.root ())) != roots.end ();
+	auto root (xpeed::uint512_union (block_a.previous (), block_a.root ()));
+	auto & shard (root_shard (root));
+	auto lock (lock_shard (shard));
+	return shard.roots.find (root) != shard.roots.end ();
 }
 
 void xpeed::active_transactions::update_difficulty (xpeed::block const & block_a)
 {
-	std::lock_guard<std::mutex> lock (mutex);
-	auto existing (roots.find (xpeed::uint512_union (block_a.previous (), block_a.root ())));
-	if (existing != roots.end ())
+	auto root (xpeed::uint512_union (block_a.previous (), block_a.root ()));
+	auto & shard (root_shard (root));
+	auto lock (lock_shard (shard));
+	auto existing (shard.roots.find (root));
+	if (existing != shard.roots.end ())
 	{
 		uint64_t difficulty;
 		auto error (xpeed::work_validate (block_a, &difficulty));
 		assert (!error);
-		roots.modify (existing, [difficulty](xpeed::conflict_info & info_a) {
+		shard.roots.modify (existing, [difficulty](xpeed::conflict_info & info_a) {
 			info_a.difficulty = difficulty;
 		});
 	}
 }
 
 // List of active blocks in elections
-std::deque<std::shared_ptr<xpeed::block>> xpeed::active_transactions::list_blocks (bool single_lock)
+std::deque<std::shared_ptr<xpeed::block>> xpeed::active_transactions::list_blocks ()
 {
 	std::deque<std::shared_ptr<xpeed::block>> result;
-	std::unique_lock<std::mutex> lock;
-	if (!single_lock)
+	for (auto & shard : shards)
 	{
-		lock = std::unique_lock<std::mutex> (mutex);
-	}
-	for (auto i (roots.begin ()), n (roots.end ()); i != n; ++i)
-	{
-		result.push_back (i->election->status.winner);
+		auto lock (lock_shard (shard));
+		for (auto i (shard.roots.begin ()), n (shard.roots.end ()); i != n; ++i)
+		{
+			result.push_back (i->election->status.winner);
+		}
 	}
 	return result;
 }
@@ -3669,30 +3957,47 @@ std::deque<xpeed::election_status> xpeed::active_transactions::list_confirmed ()
 
 void xpeed::active_transactions::erase (xpeed::block const & block_a)
 {
-	std::lock_guard<std::mutex> lock (mutex);
-	if (roots.find (xpeed::uint512_union (block_a.previous (), block_a.root ())) != roots.end ())
+	auto root (xpeed::uint512_union (block_a.previous (), block_a.root ()));
+	auto & shard (root_shard (root));
+	std::shared_ptr<xpeed::election> election_l;
+	std::vector<xpeed::block_hash> hashes;
+	{
+		auto lock (lock_shard (shard));
+		auto existing (shard.roots.find (root));
+		if (existing != shard.roots.end ())
+		{
+			election_l = existing->election;
+			hashes = erase_root (shard, root);
+		}
+	}
+	if (election_l != nullptr)
 	{
-		roots.erase (xpeed::uint512_union (block_a.previous (), block_a.root ()));
+		erase_blocks (election_l, hashes);
 		BOOST_LOG (node.log) << boost::str (boost::format ("Election erased for block block %1% root %2%") % block_a.hash ().to_string () % block_a.root ().to_string ());
 	}
 }
 
 bool xpeed::active_transactions::empty ()
 {
-	std::lock_guard<std::mutex> lock (mutex);
-	return roots.empty ();
+	return size () == 0;
 }
 
 size_t xpeed::active_transactions::size ()
 {
-	std::lock_guard<std::mutex> lock (mutex);
-	return roots.size ();
+	size_t result (0);
+	for (auto & shard : shards)
+	{
+		auto lock (lock_shard (shard));
+		result += shard.roots.size ();
+	}
+	return result;
 }
 
 xpeed::active_transactions::active_transactions (xpeed::node & node_a) :
 node (node_a),
 started (false),
 stopped (false),
+next_shard (0),
 thread ([this]() {
 	xpeed::thread_role::set (xpeed::thread_role::name::request_loop);
 	request_loop ();
@@ -3712,17 +4017,26 @@ xpeed::active_transactions::~active_transactions ()
 
 bool xpeed::active_transactions::publish (std::shared_ptr<xpeed::block> block_a)
 {
-	std::lock_guard<std::mutex> lock (mutex);
-	auto existing (roots.find (xpeed::uint512_union (block_a->previous (), block_a->root ())));
+	auto root (xpeed::uint512_union (block_a->previous (), block_a->root ()));
+	auto & shard (root_shard (root));
+	std::shared_ptr<xpeed::election> election_l;
 	auto result (true);
-	if (existing != roots.end ())
 	{
-		result = existing->election->publish (block_a);
-		if (!result)
+		auto lock (lock_shard (shard));
+		auto existing (shard.roots.find (root));
+		if (existing != shard.roots.end ())
 		{
-			blocks.insert (std::make_pair (block_a->hash (), existing->election));
+			result = existing->election->publish (block_a);
+			if (!result)
+			{
+				election_l = existing->election;
+			}
 		}
 	}
+	if (election_l != nullptr)
+	{
+		index_block (block_a->hash (), election_l);
+	}
 	return result;
 }
 
@@ -3733,18 +4047,29 @@ std::unique_ptr<seq_con_info_component> collect_seq_con_info (active_transaction
 	size_t roots_count = 0;
 	size_t blocks_count = 0;
 	size_t confirmed_count = 0;
+	size_t election_bytes = 0;
 
+	for (auto & shard : active_transactions.shards)
+	{
+		std::lock_guard<std::mutex> guard (shard.mutex);
+		roots_count += shard.roots.size ();
+		blocks_count += shard.blocks.size ();
+		for (auto & info : shard.roots)
+		{
+			election_bytes += info.election->memory_size ();
+		}
+	}
 	{
 		std::lock_guard<std::mutex> guard (active_transactions.mutex);
-		roots_count = active_transactions.roots.size ();
-		blocks_count = active_transactions.blocks.size ();
 		confirmed_count = active_transactions.confirmed.size ();
 	}
 
 	auto composite = std::make_unique<seq_con_info_composite> (name);
-	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "roots", roots_count, sizeof (decltype (active_transactions.roots)::value_type) }));
-	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "blocks", blocks_count, sizeof (decltype (active_transactions.blocks)::value_type) }));
+	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "roots", roots_count, sizeof (decltype (active_transactions.shards[0].roots)::value_type) }));
+	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "blocks", blocks_count, sizeof (decltype (active_transactions.shards[0].blocks)::value_type) }));
 	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "confirmed", confirmed_count, sizeof (decltype (active_transactions.confirmed)::value_type) }));
+	// Reported per election so "size" is the total held by elections and their vote tables
+	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "elections", roots_count, roots_count > 0 ? election_bytes / roots_count : sizeof (xpeed::election) }));
 	return composite;
 }
 }
@@ -3821,6 +4146,126 @@ xpeed::inactive_node::~inactive_node ()
 	node->stop ();
 }
 
+xpeed::udp_buffer::ring::ring (size_t count_a)
+{
+	// Round up to a power of two so positions can be masked instead of divided
+	size_t size (1);
+	while (size < count_a)
+	{
+		size <<= 1;
+	}
+	cells = std::make_unique<cell[]> (size);
+	mask = size - 1;
+	for (size_t i (0); i < size; ++i)
+	{
+		cells[i].sequence.store (i, std::memory_order_relaxed);
+		cells[i].data = nullptr;
+	}
+	head.store (0, std::memory_order_relaxed);
+	tail.store (0, std::memory_order_relaxed);
+}
+bool xpeed::udp_buffer::ring::push (xpeed::udp_data * data_a)
+{
+	auto result (false);
+	auto position (tail.load (std::memory_order_relaxed));
+	auto done (false);
+	while (!done)
+	{
+		auto & cell (cells[position & mask]);
+		auto sequence (cell.sequence.load (std::memory_order_acquire));
+		auto difference (static_cast<intptr_t> (sequence) - static_cast<intptr_t> (position));
+		if (difference == 0)
+		{
+			if (tail.compare_exchange_weak (position, position + 1, std::memory_order_relaxed))
+			{
+				cell.data = data_a;
+				cell.sequence.store (position + 1, std::memory_order_release);
+				result = true;
+				done = true;
+			}
+		}
+		else if (difference < 0)
+		{
+			// Full
+			done = true;
+		}
+		else
+		{
+			position = tail.load (std::memory_order_relaxed);
+		}
+	}
+	return result;
+}
+xpeed::udp_data * xpeed::udp_buffer::ring::pop ()
+{
+	xpeed::udp_data * result (nullptr);
+	auto position (head.load (std::memory_order_relaxed));
+	auto done (false);
+	while (!done)
+	{
+		auto & cell (cells[position & mask]);
+		auto sequence (cell.sequence.load (std::memory_order_acquire));
+		auto difference (static_cast<intptr_t> (sequence) - static_cast<intptr_t> (position + 1));
+		if (difference == 0)
+		{
+			if (head.compare_exchange_weak (position, position + 1, std::memory_order_relaxed))
+			{
+				result = cell.data;
+				cell.sequence.store (position + mask + 1, std::memory_order_release);
+				done = true;
+			}
+		}
+		else if (difference < 0)
+		{
+			// Empty
+			done = true;
+		}
+		else
+		{
+			position = head.load (std::memory_order_relaxed);
+		}
+	}
+	return result;
+}
+xpeed::udp_buffer::event::event () :
+epoch (0),
+waiters (0)
+{
+}
+uint32_t xpeed::udp_buffer::event::prepare_wait ()
+{
+	waiters.fetch_add (1);
+	// Order the registration before the caller rechecks its ring, pairs with the fence in notify
+	std::atomic_thread_fence (std::memory_order_seq_cst);
+	return epoch.load ();
+}
+void xpeed::udp_buffer::event::cancel_wait ()
+{
+	waiters.fetch_sub (1);
+}
+void xpeed::udp_buffer::event::wait (uint32_t epoch_a)
+{
+	{
+		std::unique_lock<std::mutex> lock (mutex);
+		while (epoch.load () == epoch_a)
+		{
+			condition.wait (lock);
+		}
+	}
+	waiters.fetch_sub (1);
+}
+void xpeed::udp_buffer::event::notify (bool force_a)
+{
+	std::atomic_thread_fence (std::memory_order_seq_cst);
+	if (force_a || waiters.load () > 0)
+	{
+		{
+			std::lock_guard<std::mutex> lock (mutex);
+			epoch.fetch_add (1);
+		}
+		condition.notify_all ();
+	}
+}
 xpeed::udp_buffer::udp_buffer (xpeed::stat & stats, size_t size, size_t count) :
 stats (stats),
 free (count),
@@ -3836,69 +4281,108 @@ stopped (false)
 	for (auto i (0); i < count; ++i, ++entry_data)
 	{
 		*entry_data = { slab_data + i * size, 0, xpeed::endpoint () };
-		free.push_back (entry_data);
+		auto pushed (free.push (entry_data));
+		assert (pushed);
 	}
 }
 xpeed::udp_data * xpeed::udp_buffer::allocate ()
 {
-	std::unique_lock<std::mutex> lock (mutex);
-	while (!stopped && free.empty () && full.empty ())
-	{
-		stats.inc (xpeed::stat::type::udp, xpeed::stat::detail::blocking, xpeed::stat::dir::in);
-		condition.wait (lock);
-	}
 	xpeed::udp_data * result (nullptr);
-	if (!free.empty ())
+	while (!stopped && result == nullptr)
 	{
-		result = free.front ();
-		free.pop_front ();
+		result = try_allocate ();
+		if (result == nullptr)
+		{
+			// Every buffer is being filled or serviced, wait for one to be released
+			auto epoch (free_event.prepare_wait ());
+			result = free.pop ();
+			if (result == nullptr && !stopped)
+			{
+				stats.inc (xpeed::stat::type::udp, xpeed::stat::detail::blocking, xpeed::stat::dir::in);
+				free_event.wait (epoch);
+			}
+			else
+			{
+				free_event.cancel_wait ();
+			}
+		}
 	}
-	if (result == nullptr)
+	return result;
+}
+
+xpeed::udp_data * xpeed::udp_buffer::try_allocate ()
+{
+	xpeed::udp_data * result (nullptr);
+	if (!stopped)
 	{
-		result = full.front ();
-		full.pop_front ();
-		stats.inc (xpeed::stat::type::udp, xpeed::stat::detail::overflow, xpeed::stat::dir::in);
+		result = free.pop ();
+		if (result == nullptr)
+		{
+			// Drop the oldest unserviced datagram rather than stall the receiver
+			result = full.pop ();
+			if (result != nullptr)
+			{
+				stats.inc (xpeed::stat::type::udp, xpeed::stat::detail::overflow, xpeed::stat::dir::in);
+			}
+		}
 	}
 	return result;
 }
 void xpeed::udp_buffer::enqueue (xpeed::udp_data * data_a)
 {
 	assert (data_a != nullptr);
-	{
-		std::lock_guard<std::mutex> lock (mutex);
-		full.push_back (data_a);
-	}
-	condition.notify_all ();
+	auto pushed (full.push (data_a));
+	assert (pushed);
+	(void)pushed;
+	full_event.notify ();
 }
 xpeed::udp_data * xpeed::udp_buffer::dequeue ()
 {
-	std::unique_lock<std::mutex> lock (mutex);
-	while (!stopped && full.empty ())
-	{
-		condition.wait (lock);
-	}
 	xpeed::udp_data * result (nullptr);
-	if (!full.empty ())
+	dequeue (&result, 1);
+	return result;
+}
+size_t xpeed::udp_buffer::dequeue (xpeed::udp_data ** data_a, size_t max_a)
+{
+	size_t result (0);
+	while (!stopped && result == 0)
 	{
-		result = full.front ();
-		full.pop_front ();
+		for (xpeed::udp_data * data (nullptr); result < max_a && (data = full.pop ()) != nullptr;)
+		{
+			data_a[result++] = data;
+		}
+		if (result == 0)
+		{
+			auto epoch (full_event.prepare_wait ());
+			auto data (full.pop ());
+			if (data != nullptr)
+			{
+				full_event.cancel_wait ();
+				data_a[result++] = data;
+			}
+			else if (!stopped)
+			{
+				full_event.wait (epoch);
+			}
+			else
+			{
+				full_event.cancel_wait ();
+			}
+		}
 	}
 	return result;
 }
 void xpeed::udp_buffer::release (xpeed::udp_data * data_a)
 {
 	assert (data_a != nullptr);
-	{
-		std::lock_guard<std::mutex> lock (mutex);
-		free.push_back (data_a);
-	}
-	condition.notify_all ();
+	auto pushed (free.push (data_a));
+	assert (pushed);
+	(void)pushed;
+	free_event.notify ();
 }
 void xpeed::udp_buffer::stop ()
 {
-	{
-		std::lock_guard<std::mutex> lock (mutex);
-		stopped = true;
-	}
-	condition.notify_all ();
+	stopped = true;
+	free_event.notify (true);
+	full_event.notify (true);
 }
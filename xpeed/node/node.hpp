@@ -3,12 +3,21 @@
 #include <xpeed/lib/work.hpp>
 #include <xpeed/node/blockprocessor.hpp>
 #include <xpeed/node/bootstrap.hpp>
+#include <xpeed/node/confirmation_height_processor.hpp>
 #include <xpeed/node/logging.hpp>
 #include <xpeed/node/nodeconfig.hpp>
+#include <xpeed/node/peer_limiter.hpp>
 #include <xpeed/node/peers.hpp>
 #include <xpeed/node/portmapping.hpp>
+#include <xpeed/node/propagation.hpp>
+#include <xpeed/node/serving_scheduler.hpp>
 #include <xpeed/node/signatures.hpp>
+#include <xpeed/node/small_map.hpp>
 #include <xpeed/node/stats.hpp>
+#include <xpeed/node/tcp_channels.hpp>
+#include <xpeed/node/transport.hpp>
+#include <xpeed/node/udp_egress.hpp>
+#include <xpeed/node/udp_ingress.hpp>
 #include <xpeed/node/wallet.hpp>
 #include <xpeed/secure/ledger.hpp>
 
@@ -24,6 +33,7 @@
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index/random_access_index.hpp>
 #include <boost/multi_index_container.hpp>
+#include <boost/pool/pool.hpp>
 #include <boost/thread/thread.hpp>
 
 #define xstr(a) ver_str (a)
@@ -64,8 +74,7 @@ public:
 class election : public std::enable_shared_from_this<xpeed::election>
 {
 	std::function<void(std::shared_ptr<xpeed::block>)> confirmation_action;
-	void confirm_once (xpeed::transaction const &, bool = false);
-	void confirm_back (xpeed::transaction const &);
+	void confirm_once (bool = false);
 
 public:
 	election (xpeed::node &, std::shared_ptr<xpeed::block>, std::function<void(std::shared_ptr<xpeed::block>)> const &);
@@ -80,16 +89,25 @@ public:
 	void log_votes (xpeed::tally_t const &);
 	bool publish (std::shared_ptr<xpeed::block> block_a);
 	size_t last_votes_size ();
+	// Bytes held by this election including vote tables spilled to the heap
+	size_t memory_size () const;
 	void stop ();
 	xpeed::node & node;
-	std::unordered_map<xpeed::account, xpeed::vote_info> last_votes;
-	std::unordered_map<xpeed::block_hash, std::shared_ptr<xpeed::block>> blocks;
+	// Conflict root, never changes and determines which active_transactions shard guards this election
+	xpeed::uint512_union const root;
+	// Most elections see one block and votes from a few principal representatives, these tables stay inline until they outgrow that
+	xpeed::small_map<xpeed::account, xpeed::vote_info, 8> last_votes;
+	xpeed::small_map<xpeed::block_hash, std::shared_ptr<xpeed::block>, 2> blocks;
 	std::chrono::steady_clock::time_point election_start;
 	xpeed::election_status status;
 	std::atomic<bool> confirmed;
-	bool stopped;
-	std::unordered_map<xpeed::block_hash, xpeed::uint128_t> last_tally;
+	std::atomic<bool> stopped;
+	// Set once the election is removed from its shard, blocks index entries added afterwards are stale
+	std::atomic<bool> erased;
+	xpeed::small_map<xpeed::block_hash, xpeed::uint128_t, 2> last_tally;
 	unsigned announcements;
+
+	friend class active_transactions;
 };
 class conflict_info
 {
@@ -97,9 +115,86 @@ public:
 	xpeed::uint512_union root;
 	uint64_t difficulty;
 	std::shared_ptr<xpeed::election> election;
+	// Earliest time the request loop will rebroadcast and request confirmation for this election
+	std::chrono::steady_clock::time_point next_request;
+};
+/**
+ * Fixed size chunks for the elections of one shard. allocate_shared places an election, its inline vote tables and its
+ * control block in a single chunk, the chunk size is set by the first allocation.
+ */
+class election_pool
+{
+public:
+	void * allocate (size_t);
+	void deallocate (void *, size_t);
+
+private:
+	// Elections are created under their shard lock but may be freed from any thread, so the pool has a lock of its own
+	std::mutex mutex;
+	std::unique_ptr<boost::pool<>> pool;
+};
+/** Draws from a shard's election_pool, each allocation holds the pool so it outlives the shard if an election does */
+template <typename T>
+class election_allocator
+{
+public:
+	using value_type = T;
+	election_allocator (std::shared_ptr<xpeed::election_pool> const & pool_a) :
+	pool (pool_a)
+	{
+	}
+	template <typename U>
+	election_allocator (xpeed::election_allocator<U> const & other_a) :
+	pool (other_a.pool)
+	{
+	}
+	T * allocate (size_t count_a)
+	{
+		assert (count_a == 1);
+		return static_cast<T *> (pool->allocate (sizeof (T)));
+	}
+	void deallocate (T * pointer_a, size_t count_a)
+	{
+		assert (count_a == 1);
+		pool->deallocate (pointer_a, sizeof (T));
+	}
+	template <typename U>
+	bool operator== (xpeed::election_allocator<U> const & other_a) const
+	{
+		return pool == other_a.pool;
+	}
+	template <typename U>
+	bool operator!= (xpeed::election_allocator<U> const & other_a) const
+	{
+		return pool != other_a.pool;
+	}
+	std::shared_ptr<xpeed::election_pool> pool;
+};
+/**
+ * Subset of active elections guarded by its own mutex.
+ * Roots are assigned to a shard by conflict root, blocks by block hash, so a fork block
+ * and the election it belongs to may be held by different shards.
+ */
+class active_shard
+{
+public:
+	boost::multi_index_container<
+	xpeed::conflict_info,
+	boost::multi_index::indexed_by<
+	boost::multi_index::hashed_unique<
+	boost::multi_index::member<xpeed::conflict_info, xpeed::uint512_union, &xpeed::conflict_info::root>>,
+	boost::multi_index::ordered_non_unique<
+	boost::multi_index::member<xpeed::conflict_info, uint64_t, &xpeed::conflict_info::difficulty>,
+	std::greater<uint64_t>>>>
+	roots;
+	std::unordered_map<xpeed::block_hash, std::shared_ptr<xpeed::election>> blocks;
+	std::mutex mutex;
+	// Each shard allocates its elections from its own pool so allocations don't contend across shards
+	std::shared_ptr<xpeed::election_pool> pool = std::make_shared<xpeed::election_pool> ();
 };
 // Core class for determining consensus
 // Holds all active blocks i.e. recently added blocks that need confirmation
+// Elections are sharded by root with one mutex per shard, no code path holds more than one shard lock at a time
 class active_transactions
 {
 public:
@@ -112,30 +207,31 @@ public:
 	// clang-format on
 	// If this returns true, the vote is a replay
 	// If this returns false, the vote may or may not be a replay
-	bool vote (std::shared_ptr<xpeed::vote>, bool = false);
+	bool vote (std::shared_ptr<xpeed::vote>);
 	// Is the root of this block in the roots container
 	bool active (xpeed::block const &);
 	void update_difficulty (xpeed::block const &);
-	std::deque<std::shared_ptr<xpeed::block>> list_blocks (bool = false);
+	std::deque<std::shared_ptr<xpeed::block>> list_blocks ();
 	void erase (xpeed::block const &);
 	bool empty ();
 	size_t size ();
 	void stop ();
 	bool publish (std::shared_ptr<xpeed::block> block_a);
-	boost::multi_index_container<
-	xpeed::conflict_info,
-	boost::multi_index::indexed_by<
-	boost::multi_index::hashed_unique<
-	boost::multi_index::member<xpeed::conflict_info, xpeed::uint512_union, &xpeed::conflict_info::root>>,
-	boost::multi_index::ordered_non_unique<
-	boost::multi_index::member<xpeed::conflict_info, uint64_t, &xpeed::conflict_info::difficulty>,
-	std::greater<uint64_t>>>>
-	roots;
-	std::unordered_map<xpeed::block_hash, std::shared_ptr<xpeed::election>> blocks;
+	// Election containing block \p hash_a, or nullptr. Election state must be accessed with its root shard locked
+	std::shared_ptr<xpeed::election> election (xpeed::block_hash const & hash_a);
+	// Confirm dependent elections of a confirmed winner which have no competing forks
+	void confirm_back (std::shared_ptr<xpeed::block>);
+	xpeed::active_shard & root_shard (xpeed::uint512_union const &);
+	xpeed::active_shard & block_shard (xpeed::block_hash const &);
+	// Lock a shard, recording a stat if another thread was holding it
+	std::unique_lock<std::mutex> lock_shard (xpeed::active_shard &);
 	std::deque<xpeed::election_status> list_confirmed ();
 	std::deque<xpeed::election_status> confirmed;
 	xpeed::node & node;
+	// Guards confirmed and the request loop state, elections are guarded by their shard
 	std::mutex mutex;
+	static size_t constexpr shard_count = 16;
+	std::array<xpeed::active_shard, shard_count> shards;
 	// Maximum number of conflicts to vote on per interval, lowest root hash first
 	static unsigned constexpr announcements_per_interval = 32;
 	// Minimum number of block announcements
@@ -143,6 +239,8 @@ public:
 	// Threshold to start logging blocks haven't yet been confirmed
 	static unsigned constexpr announcement_long = 20;
 	static unsigned constexpr request_interval_ms = xpeed::is_test_network ? 10 : 16000;
+	// Maximum number of elections one request tick handles, remaining due elections wait for the next turn of the wheel
+	static size_t constexpr requests_per_tick = 256;
 	static size_t constexpr election_history_size = 2048;
 	static size_t constexpr max_broadcast_queue = 1000;
 
@@ -151,11 +249,17 @@ private:
 	// clang-format off
 	bool add (std::shared_ptr<xpeed::block>, std::function<void(std::shared_ptr<xpeed::block>)> const & = [](std::shared_ptr<xpeed::block>) {});
 	// clang-format on
+	// Removes root \p root_a from its locked shard and returns the hashes of its blocks for removal from the blocks index
+	std::vector<xpeed::block_hash> erase_root (xpeed::active_shard &, xpeed::uint512_union const & root_a);
+	void erase_blocks (std::shared_ptr<xpeed::election>, std::vector<xpeed::block_hash> const &);
+	void index_block (xpeed::block_hash const &, std::shared_ptr<xpeed::election>);
 	void request_loop ();
-	void request_confirm (std::unique_lock<std::mutex> &);
+	// Handles the due elections of a single shard, returns the number of elections handled
+	size_t request_confirm (xpeed::active_shard &);
 	std::condition_variable condition;
 	bool started;
-	bool stopped;
+	std::atomic<bool> stopped;
+	size_t next_shard;
 	boost::thread thread;
 };
 
@@ -284,6 +388,7 @@ public:
   * A circular buffer for servicing UDP datagrams. This container follows a producer/consumer model where the operating system is producing data in to buffers which are serviced by internal threads.
   * If buffers are not serviced fast enough they're internally dropped.
   * This container has a maximum space to hold N buffers of M size and will allocate them in round-robin order.
+  * Free and filled buffers are passed through lock-free rings, threads only park when there is nothing to take.
   * All public methods are thread-safe
 */
 class udp_buffer
@@ -299,26 +404,73 @@ public:
 	// Function will block if there are no free or unserviced buffers
 	// Return nullptr if the container has stopped
 	xpeed::udp_data * allocate ();
+	// Like allocate but return nullptr instead of blocking when every buffer is being filled or serviced
+	xpeed::udp_data * try_allocate ();
 	// Queue a buffer that has been filled with UDP data and notify servicing threads
 	void enqueue (xpeed::udp_data *);
 	// Return a buffer that has been filled with UDP data
 	// Function will block until a buffer has been added
 	// Return nullptr if the container has stopped
 	xpeed::udp_data * dequeue ();
+	// Place up to max_a filled buffers in to data_a and return how many were taken
+	// Function will block until at least one buffer has been added
+	// Return 0 if the container has stopped
+	size_t dequeue (xpeed::udp_data ** data_a, size_t max_a);
 	// Return a buffer to the freelist after is has been serviced
 	void release (xpeed::udp_data *);
 	// Stop container and notify waiting threads
 	void stop ();
 
 private:
+	/**
+	 * Bounded multi-producer multi-consumer queue of buffer pointers, each cell carries a sequence number
+	 * which tells producers and consumers whether it is theirs to fill or empty.
+	 */
+	class ring
+	{
+	public:
+		ring (size_t);
+		bool push (xpeed::udp_data *);
+		xpeed::udp_data * pop ();
+
+	private:
+		class cell
+		{
+		public:
+			std::atomic<size_t> sequence;
+			xpeed::udp_data * data;
+		};
+		std::unique_ptr<cell[]> cells;
+		size_t mask;
+		alignas (64) std::atomic<size_t> head;
+		alignas (64) std::atomic<size_t> tail;
+	};
+	/**
+	 * Parks threads waiting on a ring. Notifying is a single atomic load unless somebody is actually waiting.
+	 */
+	class event
+	{
+	public:
+		event ();
+		uint32_t prepare_wait ();
+		void cancel_wait ();
+		void wait (uint32_t);
+		void notify (bool = false);
+
+	private:
+		std::atomic<uint32_t> epoch;
+		std::atomic<uint32_t> waiters;
+		std::mutex mutex;
+		std::condition_variable condition;
+	};
 	xpeed::stat & stats;
-	std::mutex mutex;
-	std::condition_variable condition;
-	boost::circular_buffer<xpeed::udp_data *> free;
-	boost::circular_buffer<xpeed::udp_data *> full;
+	xpeed::udp_buffer::ring free;
+	xpeed::udp_buffer::ring full;
+	xpeed::udp_buffer::event free_event;
+	xpeed::udp_buffer::event full_event;
 	std::vector<uint8_t> slab;
 	std::vector<xpeed::udp_data> entries;
-	bool stopped;
+	std::atomic<bool> stopped;
 };
 class network
 {
@@ -330,6 +482,8 @@ public:
 	void start ();
 	void stop ();
 	void receive_action (xpeed::udp_data *, xpeed::endpoint const &);
+	/** Rate limit, parse and act on a message from \p endpoint_a received by datagram or over a realtime channel */
+	void process_message (uint8_t const *, size_t, xpeed::endpoint const & endpoint_a, size_t = xpeed::message_parser::max_safe_udp_message_size);
 	void rpc_action (boost::system::error_code const &, size_t);
 	void republish_vote (std::shared_ptr<xpeed::vote>);
 	void republish_block (std::shared_ptr<xpeed::block>);
@@ -350,10 +504,21 @@ public:
 	void confirm_hashes (xpeed::transaction const &, xpeed::endpoint const &, std::vector<xpeed::block_hash>);
 	bool send_votes_cache (xpeed::block_hash const &, xpeed::endpoint const &);
 	void send_buffer (uint8_t const *, size_t, xpeed::endpoint const &, std::function<void(boost::system::error_code const &, size_t)>);
+	/** Send over the realtime channel to \p endpoint_a if there is one, otherwise by datagram */
+	void send (std::shared_ptr<std::vector<uint8_t>> const &, xpeed::endpoint const & endpoint_a, xpeed::stat::detail);
 	xpeed::endpoint endpoint ();
 	xpeed::udp_buffer buffer_container;
 	boost::asio::ip::udp::socket socket;
 	std::mutex socket_mutex;
+	xpeed::udp_ingress ingress;
+	xpeed::udp_egress egress;
+	/** Digests of recently received publish and confirm_ack payloads */
+	xpeed::network_filter publish_filter;
+	xpeed::peer_limiter limiter;
+	xpeed::propagation propagation;
+	xpeed::tcp_channels channels;
+	/** Replaces the socket for peering datagrams when set before start, used to simulate networks */
+	std::shared_ptr<xpeed::transport> transport;
 	boost::asio::ip::udp::resolver resolver;
 	std::vector<boost::thread> packet_processing_threads;
 	xpeed::node & node;
@@ -361,6 +526,9 @@ public:
 	static uint16_t const node_port = xpeed::is_live_network ? 7077 : 54000;
 	static size_t const buffer_size = 512;
 	static size_t const confirm_req_hashes_max = 6;
+	/** Limit of the confirm_req encoding, used for representatives reachable over a realtime channel */
+	static size_t const confirm_req_hashes_tcp_max = 32;
+	static size_t const publish_filter_size = 256 * 1024;
 };
 
 class node_init
@@ -385,26 +553,44 @@ public:
 
 std::unique_ptr<seq_con_info_component> collect_seq_con_info (node_observers & node_observers, const std::string & name);
 
+class queued_vote
+{
+public:
+	std::shared_ptr<xpeed::vote> vote;
+	xpeed::endpoint endpoint;
+	// Digest of the whole signed vote, only identical copies share it
+	xpeed::uint256_union key;
+	uint8_t tier;
+	// Tier in the top byte, inverted so heavier voters sort first, followed by arrival order
+	uint64_t priority;
+};
 class vote_processor
 {
 public:
 	vote_processor (xpeed::node &);
 	void vote (std::shared_ptr<xpeed::vote>, xpeed::endpoint);
-	// node.active.mutex lock required
 	xpeed::vote_code vote_blocking (xpeed::transaction const &, std::shared_ptr<xpeed::vote>, xpeed::endpoint, bool = false);
 	void verify_votes (std::deque<std::pair<std::shared_ptr<xpeed::vote>, xpeed::endpoint>> &);
 	void flush ();
 	void calculate_weights ();
 	xpeed::node & node;
 	void stop ();
+	static size_t constexpr max_votes = 144 * 1024;
+	static uint8_t constexpr tier_count = 4;
 
 private:
 	void process_loop ();
-	std::deque<std::pair<std::shared_ptr<xpeed::vote>, xpeed::endpoint>> votes;
-	// Representatives levels for random early detection
-	std::unordered_set<xpeed::account> representatives_1;
-	std::unordered_set<xpeed::account> representatives_2;
-	std::unordered_set<xpeed::account> representatives_3;
+	uint8_t tier (xpeed::account const &);
+	void overflow (uint8_t);
+	boost::multi_index_container<
+	xpeed::queued_vote,
+	boost::multi_index::indexed_by<
+	boost::multi_index::ordered_unique<boost::multi_index::member<xpeed::queued_vote, uint64_t, &xpeed::queued_vote::priority>>,
+	boost::multi_index::hashed_unique<boost::multi_index::member<xpeed::queued_vote, xpeed::uint256_union, &xpeed::queued_vote::key>>>>
+	votes;
+	uint64_t arrival;
+	// Voting weight tier of representatives above 0.1% of online stake, anyone else is tier 0
+	std::unordered_map<xpeed::account, uint8_t> representative_tiers;
 	std::condition_variable condition;
 	std::mutex mutex;
 	bool started;
@@ -500,6 +686,7 @@ public:
 	xpeed::network network;
 	xpeed::bootstrap_initiator bootstrap_initiator;
 	xpeed::bootstrap_listener bootstrap;
+	xpeed::serving_scheduler serving;
 	xpeed::peer_container peers;
 	boost::filesystem::path application_path;
 	xpeed::node_observers observers;
@@ -518,6 +705,7 @@ public:
 	xpeed::keypair node_id;
 	xpeed::block_uniquer block_uniquer;
 	xpeed::vote_uniquer vote_uniquer;
+	xpeed::confirmation_height_processor confirmation_height_processor;
 	const std::chrono::steady_clock::time_point startup_time;
 	static double constexpr price_max = 16.0;
 	static double constexpr free_cutoff = 1024.0;
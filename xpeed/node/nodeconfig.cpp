@@ -28,11 +28,20 @@ online_weight_quorum (50),
 password_fanout (1024),
 io_threads (std::max<unsigned> (4, boost::thread::hardware_concurrency ())),
 network_threads (std::max<unsigned> (4, boost::thread::hardware_concurrency ())),
+udp_ingress_sockets (0),
+peer_keepalive_rate (xpeed::is_test_network ? 0 : 10),
+peer_publish_rate (xpeed::is_test_network ? 0 : 500),
+peer_confirm_req_rate (xpeed::is_test_network ? 0 : 200),
+peer_confirm_ack_rate (xpeed::is_test_network ? 0 : 2000),
+tcp_realtime_channels (0),
 work_threads (std::max<unsigned> (4, boost::thread::hardware_concurrency ())),
 signature_checker_threads ((boost::thread::hardware_concurrency () != 0) ? boost::thread::hardware_concurrency () - 1 : 0), /* The calling thread does checks as well so remove it from the number of threads used */
 enable_voting (false),
 bootstrap_connections (4),
 bootstrap_connections_max (64),
+bootstrap_lazy_memory (256),
+bootstrap_serving_rate (xpeed::is_test_network ? 0 : 32 * 1024),
+bootstrap_serving_peer_rate (xpeed::is_test_network ? 0 : 8 * 1024),
 callback_port (0),
 lmdb_max_dbs (128),
 allow_local_peers (false),
@@ -109,11 +118,20 @@ xpeed::error xpeed::node_config::serialize_json (xpeed::jsonconfig & json) const
 	json.put ("password_fanout", password_fanout);
 	json.put ("io_threads", io_threads);
 	json.put ("network_threads", network_threads);
+	json.put ("udp_ingress_sockets", udp_ingress_sockets);
+	json.put ("peer_keepalive_rate", peer_keepalive_rate);
+	json.put ("peer_publish_rate", peer_publish_rate);
+	json.put ("peer_confirm_req_rate", peer_confirm_req_rate);
+	json.put ("peer_confirm_ack_rate", peer_confirm_ack_rate);
+	json.put ("tcp_realtime_channels", tcp_realtime_channels);
 	json.put ("work_threads", work_threads);
 	json.put (signature_checker_threads_key, signature_checker_threads);
 	json.put ("enable_voting", enable_voting);
 	json.put ("bootstrap_connections", bootstrap_connections);
 	json.put ("bootstrap_connections_max", bootstrap_connections_max);
+	json.put ("bootstrap_lazy_memory", bootstrap_lazy_memory);
+	json.put ("bootstrap_serving_rate", bootstrap_serving_rate);
+	json.put ("bootstrap_serving_peer_rate", bootstrap_serving_peer_rate);
 	json.put ("callback_address", callback_address);
 	json.put ("callback_port", callback_port);
 	json.put ("callback_target", callback_target);
@@ -246,6 +264,17 @@ bool xpeed::node_config::upgrade_json (unsigned version_a, xpeed::jsonconfig & j
 			upgraded = true;
 		}
 		case 16:
+			json.put ("udp_ingress_sockets", udp_ingress_sockets);
+			json.put ("peer_keepalive_rate", peer_keepalive_rate);
+			json.put ("peer_publish_rate", peer_publish_rate);
+			json.put ("peer_confirm_req_rate", peer_confirm_req_rate);
+			json.put ("peer_confirm_ack_rate", peer_confirm_ack_rate);
+			json.put ("tcp_realtime_channels", tcp_realtime_channels);
+			json.put ("bootstrap_lazy_memory", bootstrap_lazy_memory);
+			json.put ("bootstrap_serving_rate", bootstrap_serving_rate);
+			json.put ("bootstrap_serving_peer_rate", bootstrap_serving_peer_rate);
+			upgraded = true;
+		case 17:
 			break;
 		default:
 			throw std::runtime_error ("Unknown node_config version");
@@ -358,8 +387,17 @@ xpeed::error xpeed::node_config::deserialize_json (bool & upgraded_a, xpeed::jso
 		json.get<unsigned> ("io_threads", io_threads);
 		json.get<unsigned> ("work_threads", work_threads);
 		json.get<unsigned> ("network_threads", network_threads);
+		json.get<unsigned> ("udp_ingress_sockets", udp_ingress_sockets);
+		json.get<unsigned> ("peer_keepalive_rate", peer_keepalive_rate);
+		json.get<unsigned> ("peer_publish_rate", peer_publish_rate);
+		json.get<unsigned> ("peer_confirm_req_rate", peer_confirm_req_rate);
+		json.get<unsigned> ("peer_confirm_ack_rate", peer_confirm_ack_rate);
+		json.get<unsigned> ("tcp_realtime_channels", tcp_realtime_channels);
 		json.get<unsigned> ("bootstrap_connections", bootstrap_connections);
 		json.get<unsigned> ("bootstrap_connections_max", bootstrap_connections_max);
+		json.get<unsigned> ("bootstrap_lazy_memory", bootstrap_lazy_memory);
+		json.get<unsigned> ("bootstrap_serving_rate", bootstrap_serving_rate);
+		json.get<unsigned> ("bootstrap_serving_peer_rate", bootstrap_serving_peer_rate);
 		json.get<std::string> ("callback_address", callback_address);
 		json.get<uint16_t> ("callback_port", callback_port);
 		json.get<std::string> ("callback_target", callback_target);
@@ -382,6 +420,15 @@ xpeed::error xpeed::node_config::deserialize_json (bool & upgraded_a, xpeed::jso
 		{
 			json.get_error ().set ("io_threads must be non-zero");
 		}
+		// Each ingress thread holds a batch of udp_buffer entries while it reads, they must leave most of the 4096 entries free
+		if (udp_ingress_sockets > 16)
+		{
+			json.get_error ().set ("udp_ingress_sockets must be a number between 0 and 16");
+		}
+		if (tcp_realtime_channels > 1024)
+		{
+			json.get_error ().set ("tcp_realtime_channels must be a number between 0 and 1024");
+		}
 	}
 	catch (std::runtime_error const & ex)
 	{
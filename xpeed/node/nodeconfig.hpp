@@ -36,11 +36,25 @@ public:
 	unsigned password_fanout;
 	unsigned io_threads;
 	unsigned network_threads;
+	/** Number of SO_REUSEPORT sockets drained with recvmmsg, 0 keeps a single asynchronously read socket */
+	unsigned udp_ingress_sockets;
+	/** Messages per second accepted from a single endpoint for each message class, 0 disables the limit */
+	unsigned peer_keepalive_rate;
+	unsigned peer_publish_rate;
+	unsigned peer_confirm_req_rate;
+	unsigned peer_confirm_ack_rate;
+	/** Realtime channels opened to peers over their bootstrap port and accepted from them, 0 keeps all live traffic on UDP */
+	unsigned tcp_realtime_channels;
 	unsigned work_threads;
 	unsigned signature_checker_threads;
 	bool enable_voting;
 	unsigned bootstrap_connections;
 	unsigned bootstrap_connections_max;
+	/** Megabytes of lazy bootstrap state kept in memory before the rest is moved to a temporary database, 0 keeps all of it in memory */
+	unsigned bootstrap_lazy_memory;
+	/** Kilobytes per second of bootstrap responses served to all peers and to a single peer address, 0 disables the limit */
+	unsigned bootstrap_serving_rate;
+	unsigned bootstrap_serving_peer_rate;
 	std::string callback_address;
 	uint16_t callback_port;
 	std::string callback_target;
@@ -57,7 +71,7 @@ public:
 	static std::chrono::minutes constexpr wallet_backup_interval = std::chrono::minutes (5);
 	static int json_version ()
 	{
-		return 16;
+		return 17;
 	}
 };
 
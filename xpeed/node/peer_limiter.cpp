@@ -0,0 +1,169 @@
+#include <xpeed/node/peer_limiter.hpp>
+
+#include <xpeed/node/nodeconfig.hpp>
+#include <xpeed/node/peers.hpp>
+
+size_t constexpr xpeed::peer_limiter::max_endpoints;
+
+xpeed::peer_limiter::peer_limiter (xpeed::node_config const & config_a)
+{
+	rates[static_cast<size_t> (message_class::keepalive)] = config_a.peer_keepalive_rate;
+	rates[static_cast<size_t> (message_class::publish)] = config_a.peer_publish_rate;
+	rates[static_cast<size_t> (message_class::confirm_req)] = config_a.peer_confirm_req_rate;
+	rates[static_cast<size_t> (message_class::confirm_ack)] = config_a.peer_confirm_ack_rate;
+}
+
+xpeed::peer_limiter::message_class xpeed::peer_limiter::classify (xpeed::message_type type_a)
+{
+	auto result (message_class::keepalive);
+	switch (type_a)
+	{
+		case xpeed::message_type::publish:
+			result = message_class::publish;
+			break;
+		case xpeed::message_type::confirm_req:
+			result = message_class::confirm_req;
+			break;
+		case xpeed::message_type::confirm_ack:
+			result = message_class::confirm_ack;
+			break;
+		default:
+			// Keepalives, handshakes and anything unparseable share the smallest allowance
+			break;
+	}
+	return result;
+}
+
+bool xpeed::peer_limiter::token_bucket::consume (double rate_a, std::chrono::steady_clock::time_point const & now_a)
+{
+	auto capacity (rate_a * 2);
+	if (tokens < 0)
+	{
+		tokens = capacity;
+	}
+	else
+	{
+		tokens = std::min (capacity, tokens + rate_a * std::chrono::duration<double> (now_a - last).count ());
+	}
+	last = now_a;
+	auto result (tokens < 1.0);
+	if (!result)
+	{
+		tokens -= 1.0;
+	}
+	return result;
+}
+
+xpeed::peer_limiter::shard & xpeed::peer_limiter::shard_for (xpeed::endpoint const & endpoint_a)
+{
+	// Shard by address so an endpoint and its address are always guarded by the same mutex
+	return shards[std::hash<boost::asio::ip::address> () (endpoint_a.address ()) % shards.size ()];
+}
+
+bool xpeed::peer_limiter::limit (xpeed::endpoint const & endpoint_a, xpeed::message_type type_a, size_t size_a)
+{
+	auto result (false);
+	auto class_l (static_cast<size_t> (classify (type_a)));
+	auto rate (rates[class_l]);
+	auto now (std::chrono::steady_clock::now ());
+	auto & shard (shard_for (endpoint_a));
+	std::lock_guard<std::mutex> lock (shard.mutex);
+	// Once a table is full everything it can't track shares the shard's overflow entry, a flood of new sources is limited as one
+	auto endpoint_l (&shard.overflow);
+	auto existing (shard.endpoints.find (endpoint_a));
+	if (existing == shard.endpoints.end () && shard.endpoints.size () < max_endpoints / shards.size ())
+	{
+		existing = shard.endpoints.emplace (endpoint_a, entry ()).first;
+	}
+	if (existing != shard.endpoints.end ())
+	{
+		endpoint_l = &existing->second;
+	}
+	auto address_l (&shard.overflow);
+	auto address (shard.addresses.find (endpoint_a.address ()));
+	if (address == shard.addresses.end () && shard.addresses.size () < max_endpoints / shards.size ())
+	{
+		address = shard.addresses.emplace (endpoint_a.address (), entry ()).first;
+	}
+	if (address != shard.addresses.end ())
+	{
+		address_l = &address->second;
+	}
+	endpoint_l->last = now;
+	address_l->last = now;
+	if (rate > 0)
+	{
+		auto shared_rate (rate * xpeed::peer_container::max_peers_per_ip);
+		// The endpoint's own bucket goes first so a noisy port is dropped without spending its siblings' shared allowance
+		result = endpoint_l->buckets[class_l].consume (endpoint_l == &shard.overflow ? shared_rate : rate, now);
+		if (!result && address_l != endpoint_l)
+		{
+			result = address_l->buckets[class_l].consume (shared_rate, now);
+		}
+	}
+	auto & traffic (endpoint_l->traffic);
+	traffic.bytes += size_a;
+	++traffic.messages;
+	traffic.drops += result ? 1 : 0;
+	return result;
+}
+
+void xpeed::peer_limiter::purge (std::chrono::steady_clock::time_point const & cutoff_a)
+{
+	for (auto & shard : shards)
+	{
+		std::lock_guard<std::mutex> lock (shard.mutex);
+		for (auto i (shard.endpoints.begin ()); i != shard.endpoints.end ();)
+		{
+			i = i->second.last < cutoff_a ? shard.endpoints.erase (i) : std::next (i);
+		}
+		for (auto i (shard.addresses.begin ()); i != shard.addresses.end ();)
+		{
+			i = i->second.last < cutoff_a ? shard.addresses.erase (i) : std::next (i);
+		}
+	}
+}
+
+bool xpeed::peer_limiter::traffic (xpeed::endpoint const & endpoint_a, xpeed::peer_traffic & traffic_a)
+{
+	auto & shard (shard_for (endpoint_a));
+	std::lock_guard<std::mutex> lock (shard.mutex);
+	auto existing (shard.endpoints.find (endpoint_a));
+	auto result (existing == shard.endpoints.end ());
+	if (!result)
+	{
+		traffic_a = existing->second.traffic;
+	}
+	return result;
+}
+
+size_t xpeed::peer_limiter::size ()
+{
+	size_t result (0);
+	for (auto & shard : shards)
+	{
+		std::lock_guard<std::mutex> lock (shard.mutex);
+		result += shard.endpoints.size () + shard.addresses.size ();
+	}
+	return result;
+}
+
+namespace xpeed
+{
+std::unique_ptr<seq_con_info_component> collect_seq_con_info (peer_limiter & peer_limiter, const std::string & name)
+{
+	size_t endpoints_count (0);
+	size_t addresses_count (0);
+	for (auto & shard : peer_limiter.shards)
+	{
+		std::lock_guard<std::mutex> guard (shard.mutex);
+		endpoints_count += shard.endpoints.size ();
+		addresses_count += shard.addresses.size ();
+	}
+	auto sizeof_element = sizeof (xpeed::endpoint) + sizeof (peer_limiter::entry);
+	auto composite = std::make_unique<seq_con_info_composite> (name);
+	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "endpoints", endpoints_count, sizeof_element }));
+	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "addresses", addresses_count, sizeof (boost::asio::ip::address) + sizeof (peer_limiter::entry) }));
+	return composite;
+}
+}
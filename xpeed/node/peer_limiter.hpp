@@ -0,0 +1,82 @@
+#pragma once
+
+#include <xpeed/lib/utility.hpp>
+#include <xpeed/node/common.hpp>
+
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+
+namespace xpeed
+{
+class node_config;
+/** Traffic received from a single endpoint */
+class peer_traffic
+{
+public:
+	uint64_t bytes{ 0 };
+	uint64_t messages{ 0 };
+	uint64_t drops{ 0 };
+};
+/**
+ * Token buckets limiting the rate of each message class received from a single endpoint and from all endpoints
+ * sharing an IP address. The per address allowance is the per endpoint one times peer_container::max_peers_per_ip.
+ * Buckets hold two seconds worth of tokens so short bursts pass, sustained floods are dropped. Sources beyond
+ * max_endpoints share one allowance per shard.
+ */
+class peer_limiter
+{
+public:
+	peer_limiter (xpeed::node_config const &);
+	/** Account a message of \p size_a bytes from \p endpoint_a, returns true if it should be dropped */
+	bool limit (xpeed::endpoint const & endpoint_a, xpeed::message_type type_a, size_t size_a);
+	/** Forget endpoints and addresses which haven't sent anything since \p cutoff_a */
+	void purge (std::chrono::steady_clock::time_point const & cutoff_a);
+	/** Traffic counters for \p endpoint_a, returns true if the endpoint isn't tracked */
+	bool traffic (xpeed::endpoint const & endpoint_a, xpeed::peer_traffic & traffic_a);
+	size_t size ();
+	static size_t constexpr max_endpoints = 64 * 1024;
+
+private:
+	enum class message_class : uint8_t
+	{
+		keepalive,
+		publish,
+		confirm_req,
+		confirm_ack,
+		count
+	};
+	static message_class classify (xpeed::message_type);
+	class token_bucket
+	{
+	public:
+		bool consume (double rate_a, std::chrono::steady_clock::time_point const & now_a);
+		double tokens{ -1.0 };
+		std::chrono::steady_clock::time_point last;
+	};
+	class entry
+	{
+	public:
+		std::array<token_bucket, static_cast<size_t> (message_class::count)> buckets;
+		xpeed::peer_traffic traffic;
+		std::chrono::steady_clock::time_point last;
+	};
+	class shard
+	{
+	public:
+		std::mutex mutex;
+		std::unordered_map<xpeed::endpoint, entry> endpoints;
+		std::unordered_map<boost::asio::ip::address, entry> addresses;
+		// Buckets shared by the endpoints and addresses which didn't fit in the tables
+		entry overflow;
+	};
+	shard & shard_for (xpeed::endpoint const &);
+	std::array<double, static_cast<size_t> (message_class::count)> rates;
+	std::array<shard, 16> shards;
+
+	friend std::unique_ptr<seq_con_info_component> collect_seq_con_info (peer_limiter &, const std::string &);
+};
+
+std::unique_ptr<seq_con_info_component> collect_seq_con_info (peer_limiter &, const std::string &);
+}
@@ -33,8 +33,17 @@ bool xpeed::peer_information::operator< (xpeed::peer_information const & peer_in
 	return endpoint < peer_information_a.endpoint;
 }
 
+xpeed::peer_information xpeed::peer_snapshot::info (size_t index_a) const
+{
+	xpeed::peer_information result (endpoints[index_a], versions[index_a], node_ids[index_a]);
+	result.rep_weight = weights[index_a];
+	result.probable_rep_account = rep_accounts[index_a];
+	return result;
+}
+
 xpeed::peer_container::peer_container (xpeed::endpoint const & self_a) :
 self (self_a),
+current_snapshot (std::make_shared<xpeed::peer_snapshot> ()),
 peer_observer ([](xpeed::endpoint const &) {}),
 disconnect_observer ([]() {})
 {
@@ -78,6 +87,18 @@ bool xpeed::peer_container::known_peer (xpeed::endpoint const & endpoint_a)
 	return existing != peers.end ();
 }
 
+boost::optional<xpeed::account> xpeed::peer_container::node_id (xpeed::endpoint const & endpoint_a)
+{
+	boost::optional<xpeed::account> result;
+	std::lock_guard<std::mutex> lock (mutex);
+	auto existing (peers.find (endpoint_a));
+	if (existing != peers.end ())
+	{
+		result = existing->node_id;
+	}
+	return result;
+}
+
 // Simulating with sqrt_broadcast_simulate shows we only need to broadcast to sqrt(total_peers) random peers in order to successfully publish to everyone with high probability
 std::deque<xpeed::endpoint> xpeed::peer_container::list_fanout ()
 {
@@ -92,12 +113,8 @@ std::deque<xpeed::endpoint> xpeed::peer_container::list_fanout ()
 
 std::deque<xpeed::endpoint> xpeed::peer_container::list ()
 {
-	std::deque<xpeed::endpoint> result;
-	std::lock_guard<std::mutex> lock (mutex);
-	for (auto i (peers.begin ()), j (peers.end ()); i != j; ++i)
-	{
-		result.push_back (i->endpoint);
-	}
+	auto snapshot_l (snapshot ());
+	std::deque<xpeed::endpoint> result (snapshot_l->endpoints.begin (), snapshot_l->endpoints.end ());
 	xpeed::random_pool::shuffle (result.begin (), result.end ());
 	return result;
 }
@@ -105,10 +122,11 @@ std::deque<xpeed::endpoint> xpeed::peer_container::list ()
 std::vector<xpeed::peer_information> xpeed::peer_container::list_vector (size_t count_a)
 {
 	std::vector<peer_information> result;
-	std::lock_guard<std::mutex> lock (mutex);
-	for (auto i (peers.begin ()), j (peers.end ()); i != j; ++i)
+	auto snapshot_l (snapshot ());
+	result.reserve (snapshot_l->endpoints.size ());
+	for (size_t i (0), n (snapshot_l->endpoints.size ()); i < n; ++i)
 	{
-		result.push_back (*i);
+		result.push_back (snapshot_l->info (i));
 	}
 	random_pool::shuffle (result.begin (), result.end ());
 	if (result.size () > count_a)
@@ -191,24 +209,25 @@ std::unordered_set<xpeed::endpoint> xpeed::peer_container::random_set (size_t co
 {
 	std::unordered_set<xpeed::endpoint> result;
 	result.reserve (count_a);
-	std::lock_guard<std::mutex> lock (mutex);
+	auto snapshot_l (snapshot ());
+	auto & endpoints_l (snapshot_l->endpoints);
 	// Stop trying to fill result with random samples after this many attempts
 	auto random_cutoff (count_a * 2);
-	auto peers_size (peers.size ());
+	auto peers_size (endpoints_l.size ());
 	// Usually count_a will be much smaller than peers.size()
 	// Otherwise make sure we have a cutoff on attempting to randomly fill
-	if (!peers.empty ())
+	if (!endpoints_l.empty ())
 	{
 		for (auto i (0); i < random_cutoff && result.size () < count_a; ++i)
 		{
 			auto index (xpeed::random_pool::generate_word32 (0, static_cast<CryptoPP::word32> (peers_size - 1)));
-			result.insert (peers.get<3> ()[index].endpoint);
+			result.insert (endpoints_l[index]);
 		}
 	}
 	// Fill the remainder with most recent contact
-	for (auto i (peers.get<1> ().begin ()), n (peers.get<1> ().end ()); i != n && result.size () < count_a; ++i)
+	for (auto i (snapshot_l->by_contact.begin ()), n (snapshot_l->by_contact.end ()); i != n && result.size () < count_a; ++i)
 	{
-		result.insert (i->endpoint);
+		result.insert (endpoints_l[*i]);
 	}
 	return result;
 }
@@ -234,13 +253,10 @@ std::vector<xpeed::peer_information> xpeed::peer_container::representatives (siz
 {
 	std::vector<peer_information> result;
 	result.reserve (std::min (count_a, size_t (16)));
-	std::lock_guard<std::mutex> lock (mutex);
-	for (auto i (peers.get<6> ().begin ()), n (peers.get<6> ().end ()); i != n && result.size () < count_a; ++i)
+	auto snapshot_l (snapshot ());
+	for (auto i (snapshot_l->by_weight.begin ()), n (snapshot_l->by_weight.end ()); i != n && result.size () < count_a; ++i)
 	{
-		if (!i->rep_weight.is_zero ())
-		{
-			result.push_back (*i);
-		}
+		result.push_back (snapshot_l->info (*i));
 	}
 	return result;
 }
@@ -285,6 +301,7 @@ std::vector<xpeed::peer_information> xpeed::peer_container::purge_list (std::chr
 		{
 			peers.modify (i, [](xpeed::peer_information & info) { info.last_attempt = std::chrono::steady_clock::now (); });
 		}
+		update_snapshot ();
 
 		// Remove keepalive attempt tracking for attempts older than cutoff
 		auto attempts_pivot (attempts.get<1> ().lower_bound (cutoff));
@@ -314,8 +331,7 @@ std::vector<xpeed::endpoint> xpeed::peer_container::rep_crawl ()
 
 size_t xpeed::peer_container::size ()
 {
-	std::lock_guard<std::mutex> lock (mutex);
-	return peers.size ();
+	return snapshot ()->endpoints.size ();
 }
 
 size_t xpeed::peer_container::size_sqrt ()
@@ -327,17 +343,13 @@ std::vector<xpeed::peer_information> xpeed::peer_container::list_probable_rep_we
 {
 	std::vector<xpeed::peer_information> result;
 	std::unordered_set<xpeed::account> probable_reps;
-	std::lock_guard<std::mutex> lock (mutex);
-	for (auto i (peers.get<6> ().begin ()), n (peers.get<6> ().end ()); i != n; ++i)
+	auto snapshot_l (snapshot ());
+	for (auto i : snapshot_l->by_weight)
 	{
 		// Calculate if representative isn't recorded for several IP addresses
-		if (probable_reps.find (i->probable_rep_account) == probable_reps.end ())
+		if (probable_reps.insert (snapshot_l->rep_accounts[i]).second)
 		{
-			if (!i->rep_weight.number ().is_zero ())
-			{
-				result.push_back (*i);
-			}
-			probable_reps.insert (i->probable_rep_account);
+			result.push_back (snapshot_l->info (i));
 		}
 	}
 	return result;
@@ -393,6 +405,10 @@ bool xpeed::peer_container::rep_response (xpeed::endpoint const & endpoint_a, xp
 				info.probable_rep_account = rep_account_a;
 			}
 		});
+		if (updated)
+		{
+			update_snapshot ();
+		}
 	}
 	return updated;
 }
@@ -439,6 +455,7 @@ bool xpeed::peer_container::insert (xpeed::endpoint const & endpoint_a, unsigned
 			auto existing (peers.find (endpoint_a));
 			if (existing != peers.end ())
 			{
+				auto node_id_changed (node_id_a.is_initialized () && existing->node_id != node_id_a);
 				peers.modify (existing, [node_id_a](xpeed::peer_information & info) {
 					info.last_contact = std::chrono::steady_clock::now ();
 					if (node_id_a.is_initialized ())
@@ -446,6 +463,11 @@ bool xpeed::peer_container::insert (xpeed::endpoint const & endpoint_a, unsigned
 						info.node_id = node_id_a;
 					}
 				});
+				if (node_id_changed)
+				{
+					// Snapshot readers see node ids too
+					update_snapshot ();
+				}
 				result = true;
 			}
 			else
@@ -462,6 +484,7 @@ bool xpeed::peer_container::insert (xpeed::endpoint const & endpoint_a, unsigned
 				if (!result)
 				{
 					peers.insert (xpeed::peer_information (endpoint_a, version_a, node_id_a));
+					update_snapshot ();
 				}
 			}
 		}
@@ -473,6 +496,43 @@ bool xpeed::peer_container::insert (xpeed::endpoint const & endpoint_a, unsigned
 	return result;
 }
 
+std::shared_ptr<xpeed::peer_snapshot const> xpeed::peer_container::snapshot ()
+{
+	return std::atomic_load (&current_snapshot);
+}
+
+void xpeed::peer_container::update_snapshot ()
+{
+	auto snapshot_l (std::make_shared<xpeed::peer_snapshot> ());
+	auto count (peers.size ());
+	snapshot_l->endpoints.reserve (count);
+	snapshot_l->versions.reserve (count);
+	snapshot_l->weights.reserve (count);
+	snapshot_l->rep_accounts.reserve (count);
+	snapshot_l->node_ids.reserve (count);
+	std::unordered_map<xpeed::endpoint, uint32_t> indices;
+	indices.reserve (count);
+	for (auto & peer : peers.get<3> ())
+	{
+		indices[peer.endpoint] = static_cast<uint32_t> (snapshot_l->endpoints.size ());
+		snapshot_l->endpoints.push_back (peer.endpoint);
+		snapshot_l->versions.push_back (peer.network_version);
+		snapshot_l->weights.push_back (peer.rep_weight);
+		snapshot_l->rep_accounts.push_back (peer.probable_rep_account);
+		snapshot_l->node_ids.push_back (peer.node_id);
+	}
+	snapshot_l->by_contact.reserve (count);
+	for (auto & peer : peers.get<1> ())
+	{
+		snapshot_l->by_contact.push_back (indices[peer.endpoint]);
+	}
+	for (auto i (peers.get<6> ().begin ()), n (peers.get<6> ().end ()); i != n && !i->rep_weight.is_zero (); ++i)
+	{
+		snapshot_l->by_weight.push_back (indices[i->endpoint]);
+	}
+	std::atomic_store (&current_snapshot, std::shared_ptr<xpeed::peer_snapshot const> (std::move (snapshot_l)));
+}
+
 namespace xpeed
 {
 std::unique_ptr<seq_con_info_component> collect_seq_con_info (peer_container & peer_container, const std::string & name)
@@ -9,6 +9,7 @@
 #include <boost/optional.hpp>
 #include <chrono>
 #include <deque>
+#include <memory>
 #include <mutex>
 #include <xpeed/lib/numbers.hpp>
 #include <xpeed/node/common.hpp>
@@ -60,6 +61,25 @@ public:
 	bool operator< (xpeed::peer_information const &) const;
 };
 
+/**
+ * Immutable copy of the peer set laid out as parallel arrays, shared with readers through an atomic shared_ptr swap
+ * so fanout and representative selection never wait on writers. Rebuilt whenever peers join, leave or change weight.
+ */
+class peer_snapshot
+{
+public:
+	peer_information info (size_t) const;
+	std::vector<xpeed::endpoint> endpoints;
+	std::vector<unsigned> versions;
+	std::vector<xpeed::amount> weights;
+	std::vector<xpeed::account> rep_accounts;
+	std::vector<boost::optional<xpeed::account>> node_ids;
+	/** Indices ordered by last contact when the snapshot was taken, oldest first */
+	std::vector<uint32_t> by_contact;
+	/** Indices of peers with a known representative weight, heaviest first */
+	std::vector<uint32_t> by_weight;
+};
+
 /** Manages a set of disovered peers */
 class peer_container
 {
@@ -72,6 +92,8 @@ public:
 	bool not_a_peer (xpeed::endpoint const &, bool);
 	// Returns true if peer was already known
 	bool known_peer (xpeed::endpoint const &);
+	// Node ID the peer proved in a handshake, if any
+	boost::optional<xpeed::account> node_id (xpeed::endpoint const &);
 	// Notify of peer we received from
 	bool insert (xpeed::endpoint const &, unsigned, bool = false, boost::optional<xpeed::account> = boost::none);
 	std::unordered_set<xpeed::endpoint> random_set (size_t);
@@ -103,6 +125,9 @@ public:
 	bool validate_syn_cookie (xpeed::endpoint const &, xpeed::account, xpeed::signature);
 	size_t size ();
 	size_t size_sqrt ();
+	std::shared_ptr<xpeed::peer_snapshot const> snapshot ();
+	// Replace the snapshot with the current peer set, mutex must be held
+	void update_snapshot ();
 	xpeed::uint128_t total_weight ();
 	xpeed::uint128_t online_weight_minimum;
 	bool empty ();
@@ -126,6 +151,7 @@ public:
 	boost::multi_index::hashed_unique<boost::multi_index::member<peer_attempt, xpeed::endpoint, &peer_attempt::endpoint>>,
 	boost::multi_index::ordered_non_unique<boost::multi_index::member<peer_attempt, std::chrono::steady_clock::time_point, &peer_attempt::last_attempt>>>>
 	attempts;
+	std::shared_ptr<xpeed::peer_snapshot const> current_snapshot;
 	std::mutex syn_cookie_mutex;
 	std::unordered_map<xpeed::endpoint, syn_cookie_info> syn_cookies;
 	std::unordered_map<boost::asio::ip::address, unsigned> syn_cookies_per_ip;
@@ -0,0 +1,129 @@
+#include <xpeed/node/propagation.hpp>
+
+#include <xpeed/node/peers.hpp>
+
+#include <algorithm>
+#include <unordered_set>
+
+size_t constexpr xpeed::propagation::representatives;
+size_t constexpr xpeed::propagation::max_items;
+size_t constexpr xpeed::propagation::max_endpoints_per_item;
+
+xpeed::propagation::propagation (xpeed::peer_container & peers_a) :
+peers (peers_a)
+{
+}
+
+xpeed::propagation::item const & xpeed::propagation::get (xpeed::uint256_union const & item_a)
+{
+	auto & index (items.get<1> ());
+	auto existing (index.find (item_a));
+	if (existing == index.end ())
+	{
+		items.push_back (item{ item_a, std::vector<xpeed::endpoint> () });
+		if (items.size () > max_items)
+		{
+			items.pop_front ();
+		}
+		existing = index.find (item_a);
+	}
+	else
+	{
+		// Most recently used items are kept longest
+		items.relocate (items.end (), items.project<0> (existing));
+	}
+	return *existing;
+}
+
+void xpeed::propagation::insert (item const & item_a, xpeed::endpoint const & endpoint_a)
+{
+	if (item_a.endpoints.size () < max_endpoints_per_item && std::find (item_a.endpoints.begin (), item_a.endpoints.end (), endpoint_a) == item_a.endpoints.end ())
+	{
+		item_a.endpoints.push_back (endpoint_a);
+	}
+}
+
+std::vector<xpeed::endpoint> xpeed::propagation::targets (xpeed::uint256_union const & item_a)
+{
+	std::vector<xpeed::endpoint> result;
+	auto snapshot (peers.snapshot ());
+	auto & endpoints (snapshot->endpoints);
+	std::lock_guard<std::mutex> lock (mutex);
+	auto & item_l (get (item_a));
+	std::unordered_set<xpeed::endpoint> excluded (item_l.endpoints.begin (), item_l.endpoints.end ());
+	// One endpoint per representative, heaviest first
+	std::unordered_set<xpeed::account> reps;
+	for (auto i (snapshot->by_weight.begin ()), n (snapshot->by_weight.end ()); i != n && reps.size () < representatives; ++i)
+	{
+		if (reps.insert (snapshot->rep_accounts[*i]).second && excluded.insert (endpoints[*i]).second)
+		{
+			result.push_back (endpoints[*i]);
+		}
+	}
+	// Random remainder for diffusion, sampling stops after a bounded number of attempts like peer_container::random_set
+	auto random_count (static_cast<size_t> (std::ceil (std::sqrt (endpoints.size ()))));
+	size_t added (0);
+	for (size_t attempt (0); !endpoints.empty () && attempt < random_count * 2 && added < random_count; ++attempt)
+	{
+		auto index (xpeed::random_pool::generate_word32 (0, static_cast<CryptoPP::word32> (endpoints.size () - 1)));
+		if (excluded.insert (endpoints[index]).second)
+		{
+			result.push_back (endpoints[index]);
+			++added;
+		}
+	}
+	for (auto & endpoint : result)
+	{
+		insert (item_l, endpoint);
+	}
+	return result;
+}
+
+void xpeed::propagation::seen (xpeed::uint256_union const & item_a, xpeed::endpoint const & endpoint_a, uint64_t digest_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	insert (get (item_a), endpoint_a);
+	if (digest_a != 0 && aliases.get<1> ().find (digest_a) == aliases.get<1> ().end ())
+	{
+		aliases.push_back (alias{ digest_a, item_a });
+		if (aliases.size () > max_items)
+		{
+			aliases.pop_front ();
+		}
+	}
+}
+
+void xpeed::propagation::seen (uint64_t digest_a, xpeed::endpoint const & endpoint_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	auto & index (aliases.get<1> ());
+	auto existing (index.find (digest_a));
+	if (existing != index.end ())
+	{
+		insert (get (existing->hash), endpoint_a);
+	}
+}
+
+size_t xpeed::propagation::size ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	return items.size ();
+}
+
+namespace xpeed
+{
+std::unique_ptr<seq_con_info_component> collect_seq_con_info (propagation & propagation, const std::string & name)
+{
+	size_t items_count;
+	size_t aliases_count;
+	{
+		std::lock_guard<std::mutex> guard (propagation.mutex);
+		items_count = propagation.items.size ();
+		aliases_count = propagation.aliases.size ();
+	}
+	auto composite = std::make_unique<seq_con_info_composite> (name);
+	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "items", items_count, sizeof (decltype (propagation.items)::value_type) }));
+	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "aliases", aliases_count, sizeof (decltype (propagation.aliases)::value_type) }));
+	return composite;
+}
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <xpeed/lib/numbers.hpp>
+#include <xpeed/lib/utility.hpp>
+#include <xpeed/node/common.hpp>
+
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
+#include <boost/multi_index_container.hpp>
+
+#include <cmath>
+#include <mutex>
+#include <vector>
+
+namespace xpeed
+{
+class peer_container;
+/**
+ * Chooses who a block or vote is republished to. The heaviest known representatives always come first, followed by
+ * sqrt(peers) random peers for diffusion. Endpoints an item was sent to or received from are remembered for the most
+ * recent items so repeated republishing only reaches peers which haven't seen it.
+ */
+class propagation
+{
+public:
+	propagation (xpeed::peer_container &);
+	/** Select peers which should receive \p item_a and remember them as having it */
+	std::vector<xpeed::endpoint> targets (xpeed::uint256_union const & item_a);
+	/** Note that \p endpoint_a already has \p item_a, received in a payload with filter digest \p digest_a unless it's zero */
+	void seen (xpeed::uint256_union const & item_a, xpeed::endpoint const & endpoint_a, uint64_t digest_a = 0);
+	/** Note that \p endpoint_a sent a duplicate payload with filter digest \p digest_a, which isn't parsed again */
+	void seen (uint64_t digest_a, xpeed::endpoint const & endpoint_a);
+	size_t size ();
+	/** Representatives included ahead of the random remainder */
+	static size_t constexpr representatives = 16;
+	static size_t constexpr max_items = 16 * 1024;
+	static size_t constexpr max_endpoints_per_item = 64;
+
+private:
+	class item
+	{
+	public:
+		xpeed::uint256_union hash;
+		// Not part of any index key
+		mutable std::vector<xpeed::endpoint> endpoints;
+	};
+	class alias
+	{
+	public:
+		uint64_t digest;
+		xpeed::uint256_union hash;
+	};
+	void insert (item const &, xpeed::endpoint const &);
+	item const & get (xpeed::uint256_union const &);
+	xpeed::peer_container & peers;
+	std::mutex mutex;
+	boost::multi_index_container<
+	item,
+	boost::multi_index::indexed_by<
+	boost::multi_index::sequenced<>,
+	boost::multi_index::hashed_unique<boost::multi_index::member<item, xpeed::uint256_union, &item::hash>>>>
+	items;
+	// Item hashes by digest of the payloads they arrived in, a block or vote may arrive in several encodings
+	boost::multi_index_container<
+	alias,
+	boost::multi_index::indexed_by<
+	boost::multi_index::sequenced<>,
+	boost::multi_index::hashed_unique<boost::multi_index::member<alias, uint64_t, &alias::digest>>>>
+	aliases;
+
+	friend std::unique_ptr<seq_con_info_component> collect_seq_con_info (propagation &, const std::string &);
+};
+
+std::unique_ptr<seq_con_info_component> collect_seq_con_info (propagation &, const std::string &);
+}
@@ -51,7 +51,8 @@ enable_control (enable_control_a),
 frontier_request_limit (16384),
 chain_request_limit (16384),
 max_json_depth (20),
-enable_sign_hash (false)
+enable_sign_hash (false),
+max_batch_size (64)
 {
 }
 
@@ -64,6 +65,7 @@ xpeed::error xpeed::rpc_config::serialize_json (xpeed::jsonconfig & json) const
 	json.put ("chain_request_limit", chain_request_limit);
 	json.put ("max_json_depth", max_json_depth);
 	json.put ("enable_sign_hash", enable_sign_hash);
+	json.put ("max_batch_size", max_batch_size);
 	return json.get_error ();
 }
 
@@ -82,6 +84,7 @@ xpeed::error xpeed::rpc_config::deserialize_json (xpeed::jsonconfig & json)
 	json.get_optional<uint64_t> ("chain_request_limit", chain_request_limit);
 	json.get_optional<uint8_t> ("max_json_depth", max_json_depth);
 	json.get_optional<bool> ("enable_sign_hash", enable_sign_hash);
+	json.get_optional<uint64_t> ("max_batch_size", max_batch_size);
 	return json.get_error ();
 }
 
@@ -414,6 +417,15 @@ uint64_t xpeed::rpc_handler::offset_optional_impl (uint64_t result)
 	return result;
 }
 
+xpeed::transaction const & xpeed::rpc_handler::tx_read_impl ()
+{
+	if (read_transaction == nullptr)
+	{
+		read_transaction = std::make_shared<xpeed::transaction> (node.store.tx_begin_read ());
+	}
+	return *read_transaction;
+}
+
 bool xpeed::rpc_handler::rpc_control_impl ()
 {
 	bool result (false);
@@ -448,7 +460,7 @@ void xpeed::rpc_handler::account_block_count ()
 	auto account (account_impl ());
 	if (!ec)
 	{
-		auto transaction (node.store.tx_begin_read ());
+		auto & transaction (tx_read_impl ());
 		xpeed::account_info info;
 		if (!node.store.account_get (transaction, account, info))
 		{
@@ -526,7 +538,7 @@ void xpeed::rpc_handler::account_info ()
 		const bool representative = request.get<bool> ("representative", false);
 		const bool weight = request.get<bool> ("weight", false);
 		const bool pending = request.get<bool> ("pending", false);
-		auto transaction (node.store.tx_begin_read ());
+		auto & transaction (tx_read_impl ());
 		xpeed::account_info info;
 		if (!node.store.account_get (transaction, account, info))
 		{
@@ -539,6 +551,7 @@ void xpeed::rpc_handler::account_info ()
 			response_l.put ("modified_timestamp", std::to_string (info.modified));
 			response_l.put ("block_count", std::to_string (info.block_count));
 			response_l.put ("account_version", info.epoch == xpeed::epoch::epoch_1 ? "1" : "0");
+			response_l.put ("confirmation_height", std::to_string (node.store.confirmation_height_get (transaction, account)));
 			if (representative)
 			{
 				auto block (node.store.block_get (transaction, info.rep_block));
@@ -655,7 +668,7 @@ void xpeed::rpc_handler::account_representative ()
 	auto account (account_impl ());
 	if (!ec)
 	{
-		auto transaction (node.store.tx_begin_read ());
+		auto & transaction (tx_read_impl ());
 		xpeed::account_info info;
 		if (!node.store.account_get (transaction, account, info))
 		{
@@ -873,13 +886,81 @@ void xpeed::rpc_handler::available_supply ()
 	response_errors ();
 }
 
+namespace
+{
+/** Read-only actions which may be grouped into a single "batch" request and share its read transaction */
+std::unordered_map<std::string, void (xpeed::rpc_handler::*) ()> const batch_actions = {
+	{ "account_block_count", &xpeed::rpc_handler::account_block_count },
+	{ "account_info", &xpeed::rpc_handler::account_info },
+	{ "account_key", &xpeed::rpc_handler::account_key },
+	{ "account_representative", &xpeed::rpc_handler::account_representative },
+	{ "block", &xpeed::rpc_handler::block_info },
+	{ "block_account", &xpeed::rpc_handler::block_account },
+	{ "block_count", &xpeed::rpc_handler::block_count },
+	{ "block_info", &xpeed::rpc_handler::block_info },
+	{ "blocks", &xpeed::rpc_handler::blocks },
+	{ "blocks_info", &xpeed::rpc_handler::blocks_info },
+	{ "pending_exists", &xpeed::rpc_handler::pending_exists },
+	{ "validate_account_number", &xpeed::rpc_handler::validate_account_number },
+	{ "work_validate", &xpeed::rpc_handler::work_validate }
+};
+}
+
+void xpeed::rpc_handler::batch ()
+{
+	auto & requests_l (request.get_child ("requests"));
+	if (requests_l.size () > rpc.config.max_batch_size)
+	{
+		ec = xpeed::error_rpc::batch_size_exceeded;
+	}
+	if (!ec)
+	{
+		boost::property_tree::ptree responses;
+		for (auto & item : requests_l)
+		{
+			boost::property_tree::ptree item_response;
+			auto handler (std::make_shared<xpeed::rpc_handler> (node, rpc, "", request_id, [&item_response](boost::property_tree::ptree const & response_a) {
+				item_response = response_a;
+			}));
+			// Sub-requests are answered synchronously, errors are reported per item and never abort the batch
+			try
+			{
+				handler->request = item.second;
+				auto existing (batch_actions.find (handler->request.get<std::string> ("action")));
+				if (existing != batch_actions.end ())
+				{
+					tx_read_impl ();
+					handler->read_transaction = read_transaction;
+					((*handler).*(existing->second)) ();
+				}
+				else
+				{
+					handler->ec = xpeed::error_rpc::batch_action_not_allowed;
+					handler->response_errors ();
+				}
+			}
+			catch (std::runtime_error const &)
+			{
+				error_response (handler->response, "Unable to parse JSON");
+			}
+			catch (...)
+			{
+				error_response (handler->response, "Internal server error in RPC");
+			}
+			responses.push_back (std::make_pair ("", item_response));
+		}
+		response_l.add_child ("responses", responses);
+	}
+	response_errors ();
+}
+
 void xpeed::rpc_handler::block_info ()
 {
 	auto hash (hash_impl ());
 	if (!ec)
 	{
 		xpeed::block_sideband sideband;
-		auto transaction (node.store.tx_begin_read ());
+		auto & transaction (tx_read_impl ());
 		auto block (node.store.block_get (transaction, hash, &sideband));
 		if (block != nullptr)
 		{
@@ -891,6 +972,7 @@ void xpeed::rpc_handler::block_info ()
 			response_l.put ("balance", balance.convert_to<std::string> ());
 			response_l.put ("height", std::to_string (sideband.height));
 			response_l.put ("local_timestamp", std::to_string (sideband.timestamp));
+			response_l.put ("confirmed", node.ledger.block_confirmed (transaction, hash) ? "1" : "0");
 			std::string contents;
 			block->serialize_json (contents);
 			response_l.put ("contents", contents);
@@ -927,7 +1009,7 @@ void xpeed::rpc_handler::blocks ()
 {
 	std::vector<std::string> hashes;
 	boost::property_tree::ptree blocks;
-	auto transaction (node.store.tx_begin_read ());
+	auto & transaction (tx_read_impl ());
 	for (boost::property_tree::ptree::value_type & hashes : request.get_child ("hashes"))
 	{
 		if (!ec)
@@ -964,7 +1046,7 @@ void xpeed::rpc_handler::blocks_info ()
 	const bool source = request.get<bool> ("source", false);
 	std::vector<std::string> hashes;
 	boost::property_tree::ptree blocks;
-	auto transaction (node.store.tx_begin_read ());
+	auto & transaction (tx_read_impl ());
 	for (boost::property_tree::ptree::value_type & hashes : request.get_child ("hashes"))
 	{
 		if (!ec)
@@ -986,6 +1068,7 @@ void xpeed::rpc_handler::blocks_info ()
 					entry.put ("balance", balance.convert_to<std::string> ());
 					entry.put ("height", std::to_string (sideband.height));
 					entry.put ("local_timestamp", std::to_string (sideband.timestamp));
+					entry.put ("confirmed", node.ledger.block_confirmed (transaction, hash) ? "1" : "0");
 					std::string contents;
 					block->serialize_json (contents);
 					entry.put ("contents", contents);
@@ -1035,7 +1118,7 @@ void xpeed::rpc_handler::block_account ()
 	auto hash (hash_impl ());
 	if (!ec)
 	{
-		auto transaction (node.store.tx_begin_read ());
+		auto & transaction (tx_read_impl ());
 		if (node.store.block_exists (transaction, hash))
 		{
 			auto account (node.ledger.account (transaction, hash));
@@ -1051,7 +1134,7 @@ void xpeed::rpc_handler::block_account ()
 
 void xpeed::rpc_handler::block_count ()
 {
-	auto transaction (node.store.tx_begin_read ());
+	auto & transaction (tx_read_impl ());
 	response_l.put ("count", std::to_string (node.store.block_count (transaction).sum ()));
 	response_l.put ("unchecked", std::to_string (node.store.unchecked_count (transaction)));
 	response_errors ();
@@ -1396,6 +1479,17 @@ void xpeed::rpc_handler::bootstrap_lazy ()
 	response_errors ();
 }
 
+void xpeed::rpc_handler::bootstrap_ascending ()
+{
+	rpc_control_impl ();
+	if (!ec)
+	{
+		node.bootstrap_initiator.bootstrap_ascending ();
+		response_l.put ("started", "1");
+	}
+	response_errors ();
+}
+
 /*
  * @warning This is an internal/diagnostic RPC, do not rely on its interface being stable
  */
@@ -1412,6 +1506,52 @@ void xpeed::rpc_handler::bootstrap_status ()
 		response_l.put ("target_connections", std::to_string (attempt->target_connections (attempt->pulls.size ())));
 		response_l.put ("total_blocks", std::to_string (attempt->total_blocks));
 		response_l.put ("runs_count", std::to_string (attempt->runs_count));
+		boost::property_tree::ptree connections_l;
+		{
+			std::lock_guard<std::mutex> lock (attempt->mutex);
+			for (auto & i : attempt->clients)
+			{
+				if (auto client = i.lock ())
+				{
+					boost::property_tree::ptree entry;
+					entry.put ("endpoint", boost::str (boost::format ("%1%") % client->endpoint));
+					entry.put ("blocks", std::to_string (client->block_count));
+					entry.put ("bytes", std::to_string (client->byte_count));
+					entry.put ("blocks_per_second", std::to_string (static_cast<uint64_t> (client->block_rate ())));
+					entry.put ("bytes_per_second", std::to_string (static_cast<uint64_t> (client->byte_rate ())));
+					entry.put ("score", boost::str (boost::format ("%1$.1f") % client->score));
+					entry.put ("lagging", client->lagging ? "1" : "0");
+					connections_l.push_back (std::make_pair ("", entry));
+				}
+			}
+		}
+		response_l.add_child ("connections_detail", connections_l);
+		boost::property_tree::ptree ranges_l;
+		{
+			std::lock_guard<std::mutex> lock (attempt->mutex);
+			for (auto & range : attempt->frontier_ranges)
+			{
+				boost::property_tree::ptree entry;
+				entry.put ("start", range->start.to_string ());
+				entry.put ("end", range->end.to_string ());
+				entry.put ("endpoint", boost::str (boost::format ("%1%") % range->endpoint));
+				entry.put ("frontiers", std::to_string (range->frontiers));
+				entry.put ("progress", boost::str (boost::format ("%1$.2f") % range->progress ()));
+				entry.put ("attempts", std::to_string (range->attempts));
+				entry.put ("done", range->done ? "1" : "0");
+				ranges_l.push_back (std::make_pair ("", entry));
+			}
+		}
+		response_l.add_child ("frontier_ranges", ranges_l);
+		boost::property_tree::ptree pull_times_l;
+		{
+			std::lock_guard<std::mutex> lock (attempt->mutex);
+			pull_times_l.put ("count", std::to_string (attempt->pull_times.size ()));
+			pull_times_l.put ("p50", std::to_string (static_cast<uint64_t> (attempt->pull_time_percentile (0.5))));
+			pull_times_l.put ("p90", std::to_string (static_cast<uint64_t> (attempt->pull_time_percentile (0.9))));
+			pull_times_l.put ("p99", std::to_string (static_cast<uint64_t> (attempt->pull_time_percentile (0.99))));
+		}
+		response_l.add_child ("pull_time_ms", pull_times_l);
 		std::string mode_text;
 		if (attempt->mode == xpeed::bootstrap_mode::legacy)
 		{
@@ -1425,11 +1565,25 @@ void xpeed::rpc_handler::bootstrap_status ()
 		{
 			mode_text = "wallet_lazy";
 		}
+		else if (attempt->mode == xpeed::bootstrap_mode::ascending)
+		{
+			mode_text = "ascending";
+		}
 		response_l.put ("mode", mode_text);
+		response_l.put ("ascending_probed", std::to_string (attempt->ascending_probed));
+		response_l.put ("ascending_differing", std::to_string (attempt->ascending_differing));
 		response_l.put ("lazy_blocks", std::to_string (attempt->lazy_blocks.size ()));
 		response_l.put ("lazy_state_unknown", std::to_string (attempt->lazy_state_unknown.size ()));
 		response_l.put ("lazy_balances", std::to_string (attempt->lazy_balances.size ()));
 		response_l.put ("lazy_pulls", std::to_string (attempt->lazy_pulls.size ()));
+		{
+			std::lock_guard<std::mutex> lazy_lock (attempt->lazy_mutex);
+			response_l.put ("lazy_blocks_spilled", std::to_string (attempt->lazy_blocks.spilled));
+			response_l.put ("lazy_state_unknown_spilled", std::to_string (attempt->lazy_state_unknown.spilled));
+			response_l.put ("lazy_balances_spilled", std::to_string (attempt->lazy_balances.spilled));
+			response_l.put ("lazy_pulls_spilled", std::to_string (attempt->lazy_pulls.spilled));
+			response_l.put ("lazy_memory", std::to_string (attempt->lazy_memory_bytes ()));
+		}
 		response_l.put ("lazy_stopped", std::to_string (attempt->lazy_stopped));
 		response_l.put ("lazy_keys", std::to_string (attempt->lazy_keys.size ()));
 		if (!attempt->lazy_keys.empty ())
@@ -1444,6 +1598,15 @@ void xpeed::rpc_handler::bootstrap_status ()
 	response_errors ();
 }
 
+/*
+ * @warning This is an internal/diagnostic RPC, do not rely on its interface being stable
+ */
+void xpeed::rpc_handler::bootstrap_serving ()
+{
+	node.serving.serialize (response_l);
+	response_errors ();
+}
+
 void xpeed::rpc_handler::chain (bool successors)
 {
 	successors = successors != request.get<bool> ("reverse", false);
@@ -1490,9 +1653,10 @@ void xpeed::rpc_handler::confirmation_active ()
 		announcements = strtoul (announcements_text.get ().c_str (), NULL, 10);
 	}
 	boost::property_tree::ptree elections;
+	for (auto & shard : node.active.shards)
 	{
-		std::lock_guard<std::mutex> lock (node.active.mutex);
-		for (auto i (node.active.roots.begin ()), n (node.active.roots.end ()); i != n; ++i)
+		auto lock (node.active.lock_shard (shard));
+		for (auto i (shard.roots.begin ()), n (shard.roots.end ()); i != n; ++i)
 		{
 			if (i->election->announcements >= announcements && !i->election->confirmed && !i->election->stopped)
 			{
@@ -1511,6 +1675,7 @@ void xpeed::rpc_handler::confirmation_history ()
 	boost::property_tree::ptree elections;
 	boost::property_tree::ptree confirmation_stats;
 	std::chrono::milliseconds running_total (0);
+	std::vector<std::chrono::milliseconds> durations;
 	xpeed::block_hash hash (0);
 	boost::optional<std::string> hash_text (request.get_optional<std::string> ("hash"));
 	if (hash_text.is_initialized ())
@@ -1532,6 +1697,7 @@ void xpeed::rpc_handler::confirmation_history ()
 				elections.push_back (std::make_pair ("", election));
 			}
 			running_total += i->election_duration;
+			durations.push_back (i->election_duration);
 		}
 	}
 	confirmation_stats.put ("count", elections.size ());
@@ -1539,6 +1705,13 @@ void xpeed::rpc_handler::confirmation_history ()
 	{
 		confirmation_stats.put ("average", (running_total.count ()) / elections.size ());
 	}
+	if (!durations.empty ())
+	{
+		// Time to quorum across all recent confirmations, including those filtered out by hash
+		auto median (durations.begin () + durations.size () / 2);
+		std::nth_element (durations.begin (), median, durations.end ());
+		confirmation_stats.put ("median", median->count ());
+	}
 	response_l.add_child ("confirmation_stats", confirmation_stats);
 	response_l.add_child ("confirmations", elections);
 	response_errors ();
@@ -1552,9 +1725,10 @@ void xpeed::rpc_handler::confirmation_info ()
 	xpeed::uint512_union root;
 	if (!root.decode_hex (root_text))
 	{
-		std::lock_guard<std::mutex> lock (node.active.mutex);
-		auto conflict_info (node.active.roots.find (root));
-		if (conflict_info != node.active.roots.end ())
+		auto & shard (node.active.root_shard (root));
+		auto lock (node.active.lock_shard (shard));
+		auto conflict_info (shard.roots.find (root));
+		if (conflict_info != shard.roots.end ())
 		{
 			response_l.put ("announcements", std::to_string (conflict_info->election->announcements));
 			auto election (conflict_info->election);
@@ -2245,6 +2419,14 @@ void xpeed::rpc_handler::peers ()
 			{
 				pending_tree.put ("node_id", "");
 			}
+			xpeed::peer_traffic traffic;
+			if (!node.network.limiter.traffic (i->endpoint, traffic))
+			{
+				pending_tree.put ("bytes_in", std::to_string (traffic.bytes));
+				pending_tree.put ("messages_in", std::to_string (traffic.messages));
+				pending_tree.put ("dropped", std::to_string (traffic.drops));
+			}
+			pending_tree.put ("channel", node.network.channels.connected (i->endpoint) ? "tcp" : "udp");
 			peers_l.push_back (boost::property_tree::ptree::value_type (text.str (), pending_tree));
 		}
 		else
@@ -2318,7 +2500,7 @@ void xpeed::rpc_handler::pending_exists ()
 	const bool include_active = request.get<bool> ("include_active", false);
 	if (!ec)
 	{
-		auto transaction (node.store.tx_begin_read ());
+		auto & transaction (tx_read_impl ());
 		auto block (node.store.block_get (transaction, hash));
 		if (block != nullptr)
 		{
@@ -3185,6 +3367,14 @@ void xpeed::rpc_handler::stats ()
 		node.stats.log_samples (*sink);
 		use_sink = true;
 	}
+	else if (type == "ingress")
+	{
+		node.network.ingress.serialize_stats (response_l);
+	}
+	else if (type == "tcp")
+	{
+		node.network.channels.serialize_stats (response_l);
+	}
 	else
 	{
 		ec = xpeed::error_rpc::invalid_missing_type;
@@ -4342,6 +4532,10 @@ void xpeed::rpc_handler::process_request ()
 			{
 				available_supply ();
 			}
+			else if (action == "batch")
+			{
+				batch ();
+			}
 			else if (action == "block")
 			{
 				block_info ();
@@ -4398,10 +4592,18 @@ void xpeed::rpc_handler::process_request ()
 			{
 				bootstrap_lazy ();
 			}
+			else if (action == "bootstrap_ascending")
+			{
+				bootstrap_ascending ();
+			}
 			else if (action == "bootstrap_status")
 			{
 				bootstrap_status ();
 			}
+			else if (action == "bootstrap_serving")
+			{
+				bootstrap_serving ();
+			}
 			else if (action == "chain")
 			{
 				chain ();
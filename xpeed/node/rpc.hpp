@@ -53,6 +53,8 @@ public:
 	rpc_secure_config secure;
 	uint8_t max_json_depth;
 	bool enable_sign_hash;
+	/** Maximum number of sub-requests accepted by a single "batch" action */
+	uint64_t max_batch_size;
 };
 enum class payment_status
 {
@@ -147,6 +149,7 @@ public:
 	void accounts_frontiers ();
 	void accounts_pending ();
 	void available_supply ();
+	void batch ();
 	void block_info ();
 	void block_confirm ();
 	void blocks ();
@@ -159,7 +162,9 @@ public:
 	void bootstrap ();
 	void bootstrap_any ();
 	void bootstrap_lazy ();
+	void bootstrap_ascending ();
 	void bootstrap_status ();
+	void bootstrap_serving ();
 	void chain (bool = false);
 	void confirmation_active ();
 	void confirmation_history ();
@@ -245,6 +250,9 @@ public:
 	void response_errors ();
 	std::error_code ec;
 	boost::property_tree::ptree response_l;
+	/** Read transaction shared by every read-only sub-request of a "batch" action */
+	std::shared_ptr<xpeed::transaction> read_transaction;
+	xpeed::transaction const & tx_read_impl ();
 	std::shared_ptr<xpeed::wallet> wallet_impl ();
 	bool wallet_locked_impl (xpeed::transaction const &, std::shared_ptr<xpeed::wallet>);
 	bool wallet_account_impl (xpeed::transaction const &, std::shared_ptr<xpeed::wallet>, xpeed::account const &);
@@ -0,0 +1,237 @@
+#include <xpeed/node/serving_scheduler.hpp>
+
+#include <xpeed/node/node.hpp>
+
+std::chrono::milliseconds constexpr xpeed::serving_scheduler::throttle_check_interval;
+
+xpeed::serving_scheduler::serving_scheduler (xpeed::node & node_a) :
+node (node_a),
+rate (node_a.config.bootstrap_serving_rate * 1024.0),
+peer_rate (node_a.config.bootstrap_serving_peer_rate * 1024.0),
+scheduled (false),
+throttle (false),
+stopped (false)
+{
+}
+
+void xpeed::serving_scheduler::budget::refill (double rate_a, std::chrono::steady_clock::time_point const & now_a)
+{
+	if (rate_a > 0)
+	{
+		if (last == std::chrono::steady_clock::time_point ())
+		{
+			bytes = rate_a;
+		}
+		else
+		{
+			bytes = std::min (rate_a, bytes + rate_a * std::chrono::duration<double> (now_a - last).count ());
+		}
+	}
+	last = now_a;
+}
+
+bool xpeed::serving_scheduler::budget::allows (double rate_a) const
+{
+	return rate_a <= 0 || bytes > 0;
+}
+
+void xpeed::serving_scheduler::budget::consume (double rate_a, size_t size_a)
+{
+	if (rate_a > 0)
+	{
+		bytes -= size_a;
+	}
+}
+
+void xpeed::serving_scheduler::send (xpeed::tcp_endpoint const & endpoint_a, size_t size_a, std::function<void()> const & action_a)
+{
+	std::vector<std::function<void()>> ready;
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		if (!stopped)
+		{
+			auto now (std::chrono::steady_clock::now ());
+			auto & peer (peers[endpoint_a.address ()]);
+			if (peer.queue.empty ())
+			{
+				turns.push_back (endpoint_a.address ());
+			}
+			peer.queue.push_back (write{ size_a, action_a, now });
+			dequeue (now, ready);
+		}
+	}
+	for (auto & action : ready)
+	{
+		action ();
+	}
+}
+
+void xpeed::serving_scheduler::drain ()
+{
+	std::vector<std::function<void()>> ready;
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		scheduled = false;
+		if (!stopped)
+		{
+			dequeue (std::chrono::steady_clock::now (), ready);
+		}
+	}
+	for (auto & action : ready)
+	{
+		action ();
+	}
+}
+
+void xpeed::serving_scheduler::dequeue (std::chrono::steady_clock::time_point const & now_a, std::vector<std::function<void()>> & ready_a)
+{
+	assert (!mutex.try_lock ());
+	auto rate_l (throttled (now_a) ? rate / 4 : rate);
+	global.refill (rate_l, now_a);
+	// Addresses in a row which are over their own budget, once all of them are the rest waits
+	size_t blocked (0);
+	while (!turns.empty () && blocked < turns.size () && global.allows (rate_l))
+	{
+		auto address (turns.front ());
+		turns.pop_front ();
+		auto & peer (peers[address]);
+		peer.budget.refill (peer_rate, now_a);
+		if (peer.budget.allows (peer_rate))
+		{
+			auto & write (peer.queue.front ());
+			global.consume (rate_l, write.size);
+			peer.budget.consume (peer_rate, write.size);
+			peer.traffic.bytes += write.size;
+			++peer.traffic.writes;
+			if (write.queued < now_a)
+			{
+				++peer.traffic.delayed;
+				peer.traffic.delay_ms += std::chrono::duration_cast<std::chrono::milliseconds> (now_a - write.queued).count ();
+				node.stats.inc (xpeed::stat::type::bootstrap, xpeed::stat::detail::serving_delayed, xpeed::stat::dir::out);
+			}
+			peer.last = now_a;
+			ready_a.push_back (std::move (write.action));
+			peer.queue.pop_front ();
+			blocked = 0;
+		}
+		else
+		{
+			++blocked;
+		}
+		if (!peer.queue.empty ())
+		{
+			turns.push_back (address);
+		}
+	}
+	if (!turns.empty () && !scheduled)
+	{
+		// Wait for the global budget if it's spent, otherwise for the first address which can go again
+		auto wait (0.0);
+		if (!global.allows (rate_l))
+		{
+			wait = -global.bytes / rate_l;
+		}
+		else
+		{
+			wait = std::numeric_limits<double>::max ();
+			for (auto & address : turns)
+			{
+				wait = std::min (wait, -peers[address].budget.bytes / peer_rate);
+			}
+		}
+		scheduled = true;
+		std::weak_ptr<xpeed::node> node_w (node.shared ());
+		node.alarm.add (now_a + std::max (std::chrono::milliseconds (1), std::chrono::milliseconds (static_cast<int64_t> (wait * 1000))), [node_w]() {
+			if (auto node_l = node_w.lock ())
+			{
+				node_l->serving.drain ();
+			}
+		});
+	}
+}
+
+bool xpeed::serving_scheduler::throttled (std::chrono::steady_clock::time_point const & now_a)
+{
+	if (now_a >= next_throttle_check)
+	{
+		next_throttle_check = now_a + throttle_check_interval;
+		auto throttle_l (node.block_processor.full () || node.active.size () > xpeed::active_transactions::max_broadcast_queue);
+		if (throttle_l && !throttle)
+		{
+			node.stats.inc (xpeed::stat::type::bootstrap, xpeed::stat::detail::serving_throttled, xpeed::stat::dir::out);
+			if (node.config.logging.bulk_pull_logging ())
+			{
+				BOOST_LOG (node.log) << "Throttling bootstrap serving while the node is backlogged";
+			}
+		}
+		throttle = throttle_l;
+	}
+	return throttle;
+}
+
+void xpeed::serving_scheduler::purge (std::chrono::steady_clock::time_point const & cutoff_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	for (auto i (peers.begin ()); i != peers.end ();)
+	{
+		i = i->second.queue.empty () && i->second.last < cutoff_a ? peers.erase (i) : std::next (i);
+	}
+}
+
+void xpeed::serving_scheduler::serialize (boost::property_tree::ptree & tree_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	tree_a.put ("rate", std::to_string (static_cast<uint64_t> (rate)));
+	tree_a.put ("peer_rate", std::to_string (static_cast<uint64_t> (peer_rate)));
+	tree_a.put ("throttled", throttle ? "1" : "0");
+	boost::property_tree::ptree peers_l;
+	for (auto & peer : peers)
+	{
+		boost::property_tree::ptree peer_l;
+		peer_l.put ("bytes", std::to_string (peer.second.traffic.bytes));
+		peer_l.put ("writes", std::to_string (peer.second.traffic.writes));
+		peer_l.put ("delayed", std::to_string (peer.second.traffic.delayed));
+		peer_l.put ("delay_ms", std::to_string (peer.second.traffic.delay_ms));
+		peer_l.put ("queued", std::to_string (peer.second.queue.size ()));
+		peers_l.push_back (std::make_pair (peer.first.to_string (), peer_l));
+	}
+	tree_a.add_child ("peers", peers_l);
+}
+
+void xpeed::serving_scheduler::stop ()
+{
+	decltype (peers) peers_l;
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		stopped = true;
+		turns.clear ();
+		peers.swap (peers_l);
+	}
+}
+
+size_t xpeed::serving_scheduler::size ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	return peers.size ();
+}
+
+namespace xpeed
+{
+std::unique_ptr<seq_con_info_component> collect_seq_con_info (serving_scheduler & serving_scheduler, const std::string & name)
+{
+	size_t peers_count (0);
+	size_t queued_count (0);
+	{
+		std::lock_guard<std::mutex> guard (serving_scheduler.mutex);
+		peers_count = serving_scheduler.peers.size ();
+		for (auto & peer : serving_scheduler.peers)
+		{
+			queued_count += peer.second.queue.size ();
+		}
+	}
+	auto composite = std::make_unique<seq_con_info_composite> (name);
+	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "peers", peers_count, sizeof (boost::asio::ip::address) + sizeof (serving_scheduler::peer) }));
+	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "queued", queued_count, sizeof (serving_scheduler::write) }));
+	return composite;
+}
+}
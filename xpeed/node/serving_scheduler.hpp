@@ -0,0 +1,97 @@
+#pragma once
+
+#include <xpeed/lib/utility.hpp>
+#include <xpeed/node/common.hpp>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace xpeed
+{
+class node;
+/** Bootstrap responses sent to a single address */
+class serving_traffic
+{
+public:
+	uint64_t bytes{ 0 };
+	uint64_t writes{ 0 };
+	/** Writes which had to wait for a budget and how long they waited altogether */
+	uint64_t delayed{ 0 };
+	uint64_t delay_ms{ 0 };
+};
+/**
+ * Paces the writes of bulk_pull, bulk_pull_account and frontier_req servers with byte rate budgets for all peers
+ * together and for each peer address. Writes over budget wait in a queue per address and the queues take turns, so
+ * a peer with many connections or large requests can't starve the others. The total budget is cut to a quarter
+ * while the block processor or the active elections are backlogged, serving bootstrap shouldn't slow down voting.
+ */
+class serving_scheduler
+{
+public:
+	serving_scheduler (xpeed::node &);
+	/** Run \p action_a, which writes \p size_a bytes to \p endpoint_a, once the budgets allow it */
+	void send (xpeed::tcp_endpoint const & endpoint_a, size_t size_a, std::function<void()> const & action_a);
+	/** Run the queued writes which fit in the budgets now */
+	void drain ();
+	/** Forget addresses with nothing queued which haven't been served since \p cutoff_a */
+	void purge (std::chrono::steady_clock::time_point const & cutoff_a);
+	void serialize (boost::property_tree::ptree &);
+	/** Drop every queued write, their connections are closed once nothing else holds them */
+	void stop ();
+	size_t size ();
+	static std::chrono::milliseconds constexpr throttle_check_interval = std::chrono::milliseconds (250);
+
+private:
+	/** Bytes which may be written, a write is let through while the budget is positive and may take it below zero */
+	class budget
+	{
+	public:
+		/** Add what \p rate_a bytes per second accrued since the last refill, holding at most one second worth */
+		void refill (double rate_a, std::chrono::steady_clock::time_point const & now_a);
+		bool allows (double rate_a) const;
+		void consume (double rate_a, size_t size_a);
+		double bytes{ 0.0 };
+		std::chrono::steady_clock::time_point last;
+	};
+	class write
+	{
+	public:
+		size_t size;
+		std::function<void()> action;
+		std::chrono::steady_clock::time_point queued;
+	};
+	class peer
+	{
+	public:
+		xpeed::serving_scheduler::budget budget;
+		std::deque<write> queue;
+		xpeed::serving_traffic traffic;
+		std::chrono::steady_clock::time_point last;
+	};
+	/** Move the writes the budgets allow to \p ready_a and schedule the next drain if any are left, mutex must be held */
+	void dequeue (std::chrono::steady_clock::time_point const & now_a, std::vector<std::function<void()>> & ready_a);
+	bool throttled (std::chrono::steady_clock::time_point const & now_a);
+	xpeed::node & node;
+	double rate;
+	double peer_rate;
+	std::mutex mutex;
+	std::unordered_map<boost::asio::ip::address, peer> peers;
+	// Addresses with queued writes in the order they take their next turn
+	std::deque<boost::asio::ip::address> turns;
+	xpeed::serving_scheduler::budget global;
+	bool scheduled;
+	bool throttle;
+	std::chrono::steady_clock::time_point next_throttle_check;
+	bool stopped;
+
+	friend std::unique_ptr<seq_con_info_component> collect_seq_con_info (serving_scheduler &, const std::string &);
+};
+
+std::unique_ptr<seq_con_info_component> collect_seq_con_info (serving_scheduler &, const std::string &);
+}
@@ -0,0 +1,165 @@
+#include <xpeed/node/simulator.hpp>
+
+#include <xpeed/node/node.hpp>
+
+#include <cstring>
+
+bool xpeed::simulated_transport::datagram::operator> (xpeed::simulated_transport::datagram const & other_a) const
+{
+	return due > other_a.due || (due == other_a.due && sequence > other_a.sequence);
+}
+
+xpeed::simulated_transport::simulated_transport (xpeed::link_properties const & properties_a) :
+default_properties (properties_a),
+random (std::random_device () ()),
+sequence (0),
+stopped (false),
+thread ([this]() {
+	xpeed::thread_role::set (xpeed::thread_role::name::network_simulator);
+	run ();
+})
+{
+}
+
+xpeed::simulated_transport::~simulated_transport ()
+{
+	stop ();
+}
+
+void xpeed::simulated_transport::attach (std::shared_ptr<xpeed::node> node_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	nodes[node_a->network.endpoint ()] = node_a;
+}
+
+void xpeed::simulated_transport::send (std::shared_ptr<std::vector<uint8_t>> const & payload_a, xpeed::endpoint const & source_a, xpeed::endpoint const & destination_a)
+{
+	++sent;
+	bytes += payload_a->size ();
+	auto notify (false);
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		auto & link (state (source_a, destination_a));
+		if (std::uniform_real_distribution<double> (0.0, 1.0) (random) >= link.properties.loss)
+		{
+			auto now (std::chrono::steady_clock::now ());
+			auto sent_at (now);
+			if (link.properties.bandwidth > 0)
+			{
+				// Serialization delay, a datagram can't start transmitting before the previous one on this link is done
+				link.busy_until = std::max (link.busy_until, now) + std::chrono::microseconds (payload_a->size () * 1000000 / link.properties.bandwidth);
+				sent_at = link.busy_until;
+			}
+			auto jitter (link.properties.jitter.count () > 0 ? std::chrono::microseconds (std::uniform_int_distribution<int64_t> (0, link.properties.jitter.count ()) (random)) : std::chrono::microseconds (0));
+			datagrams.push (datagram{ sent_at + link.properties.latency + jitter, sequence++, payload_a, source_a, destination_a });
+			notify = datagrams.top ().sequence == sequence - 1;
+		}
+		else
+		{
+			++lost;
+		}
+	}
+	if (notify)
+	{
+		condition.notify_all ();
+	}
+}
+
+void xpeed::simulated_transport::stop ()
+{
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		stopped = true;
+	}
+	condition.notify_all ();
+	if (thread.joinable ())
+	{
+		thread.join ();
+	}
+}
+
+void xpeed::simulated_transport::link (xpeed::endpoint const & source_a, xpeed::endpoint const & destination_a, xpeed::link_properties const & properties_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	state (source_a, destination_a).properties = properties_a;
+}
+
+void xpeed::simulated_transport::serialize_stats (boost::property_tree::ptree & tree_a)
+{
+	tree_a.put ("sent", sent.load ());
+	tree_a.put ("delivered", delivered.load ());
+	tree_a.put ("lost", lost.load ());
+	tree_a.put ("dropped", dropped.load ());
+	tree_a.put ("unreachable", unreachable.load ());
+	tree_a.put ("bytes", bytes.load ());
+	std::lock_guard<std::mutex> lock (mutex);
+	tree_a.put ("in_flight", datagrams.size ());
+}
+
+xpeed::simulated_transport::link_state & xpeed::simulated_transport::state (xpeed::endpoint const & source_a, xpeed::endpoint const & destination_a)
+{
+	auto existing (links.find (std::make_pair (source_a, destination_a)));
+	if (existing == links.end ())
+	{
+		existing = links.emplace (std::make_pair (source_a, destination_a), link_state{ default_properties, std::chrono::steady_clock::time_point () }).first;
+	}
+	return existing->second;
+}
+
+void xpeed::simulated_transport::run ()
+{
+	std::unique_lock<std::mutex> lock (mutex);
+	while (!stopped)
+	{
+		if (datagrams.empty ())
+		{
+			condition.wait (lock);
+		}
+		else if (datagrams.top ().due > std::chrono::steady_clock::now ())
+		{
+			condition.wait_until (lock, datagrams.top ().due);
+		}
+		else
+		{
+			auto datagram (datagrams.top ());
+			datagrams.pop ();
+			lock.unlock ();
+			deliver (datagram);
+			lock.lock ();
+		}
+	}
+}
+
+void xpeed::simulated_transport::deliver (xpeed::simulated_transport::datagram const & datagram_a)
+{
+	std::shared_ptr<xpeed::node> node;
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		auto existing (nodes.find (datagram_a.destination));
+		if (existing != nodes.end ())
+		{
+			node = existing->second.lock ();
+		}
+	}
+	if (node != nullptr && datagram_a.payload->size () <= xpeed::network::buffer_size)
+	{
+		// Like a socket receive buffer, a receiver with no buffer to spare drops the datagram instead of stalling every link
+		auto data (node->network.buffer_container.try_allocate ());
+		if (data != nullptr)
+		{
+			std::memcpy (data->buffer, datagram_a.payload->data (), datagram_a.payload->size ());
+			data->size = datagram_a.payload->size ();
+			data->endpoint = datagram_a.source;
+			node->network.buffer_container.enqueue (data);
+			++delivered;
+		}
+		else
+		{
+			++dropped;
+		}
+	}
+	else
+	{
+		++unreachable;
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <xpeed/node/transport.hpp>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <unordered_map>
+
+namespace xpeed
+{
+class link_properties
+{
+public:
+	/** One way delay added to every datagram */
+	std::chrono::microseconds latency{ 0 };
+	/** Upper bound of a uniformly distributed delay added on top of latency, datagrams may be reordered */
+	std::chrono::microseconds jitter{ 0 };
+	/** Probability a datagram is silently dropped */
+	double loss{ 0.0 };
+	/** Bytes per second a link can carry, datagrams queue behind each other once it's saturated. 0 is unlimited */
+	uint64_t bandwidth{ 0 };
+};
+/**
+ * In-memory transport between nodes of one process. Each directed link delays, drops and paces datagrams according to
+ * its link_properties, defaulting to those given at construction. A single thread delivers datagrams once they're due.
+ */
+class simulated_transport : public xpeed::transport
+{
+public:
+	simulated_transport (xpeed::link_properties const &);
+	~simulated_transport ();
+	void attach (std::shared_ptr<xpeed::node> node_a) override;
+	void send (std::shared_ptr<std::vector<uint8_t>> const & payload_a, xpeed::endpoint const & source_a, xpeed::endpoint const & destination_a) override;
+	void stop () override;
+	/** Override the properties of the link from \p source_a to \p destination_a */
+	void link (xpeed::endpoint const & source_a, xpeed::endpoint const & destination_a, xpeed::link_properties const &);
+	void serialize_stats (boost::property_tree::ptree &);
+	std::atomic<uint64_t> sent{ 0 };
+	std::atomic<uint64_t> delivered{ 0 };
+	std::atomic<uint64_t> lost{ 0 };
+	/** Delivered while the receiver had no free buffer */
+	std::atomic<uint64_t> dropped{ 0 };
+	std::atomic<uint64_t> unreachable{ 0 };
+	std::atomic<uint64_t> bytes{ 0 };
+
+private:
+	class datagram
+	{
+	public:
+		std::chrono::steady_clock::time_point due;
+		uint64_t sequence;
+		std::shared_ptr<std::vector<uint8_t>> payload;
+		xpeed::endpoint source;
+		xpeed::endpoint destination;
+		bool operator> (datagram const &) const;
+	};
+	class link_state
+	{
+	public:
+		xpeed::link_properties properties;
+		// When the last datagram queued on this link has finished transmitting
+		std::chrono::steady_clock::time_point busy_until;
+	};
+	void run ();
+	void deliver (datagram const &);
+	link_state & state (xpeed::endpoint const &, xpeed::endpoint const &);
+	xpeed::link_properties default_properties;
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::priority_queue<datagram, std::vector<datagram>, std::greater<datagram>> datagrams;
+	std::map<std::pair<xpeed::endpoint, xpeed::endpoint>, link_state> links;
+	std::unordered_map<xpeed::endpoint, std::weak_ptr<xpeed::node>> nodes;
+	std::mt19937_64 random;
+	uint64_t sequence;
+	bool stopped;
+	boost::thread thread;
+};
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <boost/container/small_vector.hpp>
+#include <boost/pool/pool_alloc.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+
+namespace xpeed
+{
+/**
+ * Associative container keeping up to \p inline_count entries inside the owning object, where they are
+ * searched linearly. Past that threshold the entries spill to the heap and a hash index over them is built,
+ * with index nodes drawn from a shared pool.
+ * Entries stay contiguous in insertion order and cannot be removed individually.
+ */
+template <typename Key, typename Value, size_t inline_count>
+class small_map
+{
+public:
+	using value_type = std::pair<Key, Value>;
+	using iterator = typename boost::container::small_vector<value_type, inline_count>::iterator;
+	using const_iterator = typename boost::container::small_vector<value_type, inline_count>::const_iterator;
+	iterator begin ()
+	{
+		return entries.begin ();
+	}
+	iterator end ()
+	{
+		return entries.end ();
+	}
+	const_iterator begin () const
+	{
+		return entries.begin ();
+	}
+	const_iterator end () const
+	{
+		return entries.end ();
+	}
+	size_t size () const
+	{
+		return entries.size ();
+	}
+	bool empty () const
+	{
+		return entries.empty ();
+	}
+	iterator find (Key const & key_a)
+	{
+		auto result (entries.end ());
+		if (index == nullptr)
+		{
+			result = std::find_if (entries.begin (), entries.end (), [&key_a](value_type const & item_a) {
+				return item_a.first == key_a;
+			});
+		}
+		else
+		{
+			auto existing (index->find (key_a));
+			if (existing != index->end ())
+			{
+				result = entries.begin () + existing->second;
+			}
+		}
+		return result;
+	}
+	std::pair<iterator, bool> insert (value_type const & value_a)
+	{
+		auto existing (find (value_a.first));
+		auto inserted (existing == entries.end ());
+		if (inserted)
+		{
+			entries.push_back (value_a);
+			if (index != nullptr)
+			{
+				index->insert (std::make_pair (value_a.first, static_cast<uint32_t> (entries.size () - 1)));
+			}
+			else if (entries.size () > inline_count)
+			{
+				build_index ();
+			}
+			existing = entries.end () - 1;
+		}
+		return std::make_pair (existing, inserted);
+	}
+	Value & operator[] (Key const & key_a)
+	{
+		return insert (value_type (key_a, Value ())).first->second;
+	}
+	void clear ()
+	{
+		entries.clear ();
+		index.reset ();
+	}
+	/** Approximate heap bytes used by spilled entries and the index, zero while all entries are inline */
+	size_t heap_size () const
+	{
+		size_t result (0);
+		if (entries.capacity () > inline_count)
+		{
+			result += entries.capacity () * sizeof (value_type);
+		}
+		if (index != nullptr)
+		{
+			result += sizeof (index_type) + index->size () * (sizeof (typename index_type::value_type) + sizeof (void *)) + index->bucket_count () * sizeof (void *);
+		}
+		return result;
+	}
+
+private:
+	using index_type = std::unordered_map<Key, uint32_t, std::hash<Key>, std::equal_to<Key>, boost::fast_pool_allocator<std::pair<Key const, uint32_t>>>;
+	void build_index ()
+	{
+		index = std::make_unique<index_type> ();
+		index->reserve (entries.size () * 2);
+		for (size_t i (0), n (entries.size ()); i < n; ++i)
+		{
+			index->insert (std::make_pair (entries[i].first, static_cast<uint32_t> (i)));
+		}
+	}
+	boost::container::small_vector<value_type, inline_count> entries;
+	std::unique_ptr<index_type> index;
+};
+}
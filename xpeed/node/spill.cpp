@@ -0,0 +1,180 @@
+#include <xpeed/node/spill.hpp>
+
+#include <boost/endian/conversion.hpp>
+
+size_t constexpr xpeed::spilling_queue::entry_size;
+size_t constexpr xpeed::spill_filter::bits_per_key;
+size_t constexpr xpeed::spill_filter::min_bits;
+
+xpeed::spill_store::spill_store (bool & error_a, boost::filesystem::path const & path_a) :
+path (path_a)
+{
+	boost::system::error_code ec;
+	boost::filesystem::remove (path, ec);
+	boost::filesystem::remove (path.string () + "-lock", ec);
+	env = std::make_unique<xpeed::mdb_env> (error_a, path, 8, 64ULL * 1024 * 1024 * 1024);
+	if (!error_a)
+	{
+		mdb_env_set_flags (*env, MDB_NOSYNC | MDB_NOMETASYNC, 1);
+	}
+}
+
+xpeed::spill_store::~spill_store ()
+{
+	env.reset ();
+	boost::system::error_code ec;
+	boost::filesystem::remove (path, ec);
+	boost::filesystem::remove (path.string () + "-lock", ec);
+}
+
+MDB_dbi xpeed::spill_store::table (std::string const & name_a)
+{
+	MDB_dbi result;
+	auto transaction (env->tx_begin (true));
+	auto status (mdb_dbi_open (env->tx (transaction), name_a.c_str (), MDB_CREATE, &result));
+	release_assert (status == MDB_SUCCESS);
+	mdb_drop (env->tx (transaction), result, 0);
+	return result;
+}
+
+void xpeed::spill_filter::insert (xpeed::block_hash const & hash_a)
+{
+	if (words.empty ())
+	{
+		reset (0);
+	}
+	auto mask (words.size () * 64 - 1);
+	for (auto i (0); i < 3; ++i)
+	{
+		auto bit (hash_a.qwords[i] & mask);
+		words[bit / 64] |= 1ULL << (bit % 64);
+	}
+	++count;
+}
+
+bool xpeed::spill_filter::maybe (xpeed::block_hash const & hash_a) const
+{
+	auto result (!words.empty ());
+	if (result)
+	{
+		auto mask (words.size () * 64 - 1);
+		for (auto i (0); i < 3 && result; ++i)
+		{
+			auto bit (hash_a.qwords[i] & mask);
+			result = (words[bit / 64] & (1ULL << (bit % 64))) != 0;
+		}
+	}
+	return result;
+}
+
+void xpeed::spill_filter::reset (size_t count_a)
+{
+	size_t bits (min_bits);
+	while (bits < count_a * bits_per_key)
+	{
+		bits *= 2;
+	}
+	words.assign (bits / 64, 0);
+	capacity = bits / bits_per_key;
+	count = 0;
+}
+
+bool xpeed::spill_filter::saturated () const
+{
+	return count > capacity;
+}
+
+xpeed::spilling_queue::spilling_queue (std::string const & name_a) :
+spilled (0),
+name (name_a),
+store (nullptr),
+table (0),
+sequence (0)
+{
+}
+
+void xpeed::spilling_queue::push_back (xpeed::block_hash const & hash_a)
+{
+	memory.push_back (hash_a);
+}
+
+void xpeed::spilling_queue::pop_front (std::vector<xpeed::block_hash> & result_a, size_t count_a)
+{
+	while (count_a > 0 && !memory.empty ())
+	{
+		result_a.push_back (memory.front ());
+		memory.pop_front ();
+		--count_a;
+	}
+	if (count_a > 0 && spilled > 0)
+	{
+		auto transaction (store->env->tx_begin (true));
+		MDB_cursor * cursor;
+		auto status (mdb_cursor_open (store->env->tx (transaction), table, &cursor));
+		release_assert (status == MDB_SUCCESS);
+		xpeed::mdb_val key;
+		xpeed::mdb_val value;
+		for (auto read (mdb_cursor_get (cursor, key, value, MDB_FIRST)); read == MDB_SUCCESS && count_a > 0; read = mdb_cursor_get (cursor, key, value, MDB_NEXT))
+		{
+			result_a.push_back (static_cast<xpeed::block_hash> (value));
+			mdb_cursor_del (cursor, 0);
+			--spilled;
+			--count_a;
+		}
+		mdb_cursor_close (cursor);
+	}
+}
+
+size_t xpeed::spilling_queue::spill (xpeed::spill_store & store_a)
+{
+	if (store == nullptr)
+	{
+		store = &store_a;
+		table = store_a.table (name);
+	}
+	assert (store == &store_a);
+	auto result (memory.size ());
+	{
+		auto transaction (store->env->tx_begin (true));
+		for (auto & hash : memory)
+		{
+			auto key (boost::endian::native_to_big (sequence++));
+			auto status (mdb_put (store->env->tx (transaction), table, xpeed::mdb_val (sizeof (key), &key), xpeed::mdb_val (hash), 0));
+			release_assert (status == MDB_SUCCESS);
+			++spilled;
+		}
+	}
+	decltype (memory) ().swap (memory);
+	return result;
+}
+
+void xpeed::spilling_queue::clear ()
+{
+	decltype (memory) ().swap (memory);
+	if (spilled > 0)
+	{
+		auto transaction (store->env->tx_begin (true));
+		mdb_drop (store->env->tx (transaction), table, 0);
+		spilled = 0;
+	}
+}
+
+bool xpeed::spilling_queue::empty () const
+{
+	return memory.empty () && spilled == 0;
+}
+
+size_t xpeed::spilling_queue::size () const
+{
+	return memory.size () + spilled;
+}
+
+size_t xpeed::spilling_queue::memory_size () const
+{
+	return memory.size ();
+}
+
+size_t xpeed::spilling_queue::memory_bytes () const
+{
+	return memory.size () * entry_size;
+}
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <xpeed/node/lmdb.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace xpeed
+{
+/**
+ * Temporary LMDB environment for bootstrap state which doesn't fit in memory. Nothing in it has to survive a restart so
+ * writes aren't synced and the file is removed when it's opened and when it's destroyed.
+ */
+class spill_store
+{
+public:
+	spill_store (bool &, boost::filesystem::path const &);
+	~spill_store ();
+	/** Open the table \p name_a, emptying whatever a previous user left in it */
+	MDB_dbi table (std::string const & name_a);
+	boost::filesystem::path path;
+	std::unique_ptr<xpeed::mdb_env> env;
+};
+
+/**
+ * Bloom filter over the keys of a spilled table so lookups and erases for keys which were never spilled don't open a
+ * transaction. Block hashes are uniformly distributed so their words serve as the bit positions directly.
+ */
+class spill_filter
+{
+public:
+	void insert (xpeed::block_hash const &);
+	/** False if \p hash_a was certainly not inserted since the last reset */
+	bool maybe (xpeed::block_hash const & hash_a) const;
+	/** Empty the filter, sizing it for \p count_a keys */
+	void reset (size_t count_a);
+	/** True once the filter holds more keys than it was sized for and should be rebuilt */
+	bool saturated () const;
+
+private:
+	// Keeps false positives around 2% with 3 probes
+	static size_t constexpr bits_per_key = 8;
+	static size_t constexpr min_bits = 1 << 16;
+	std::vector<uint64_t> words;
+	size_t capacity{ 0 };
+	size_t count{ 0 };
+};
+
+/**
+ * Block hash keyed table with fixed size values. Entries are kept in memory until spill moves all of them to a table
+ * in a spill_store, lookups only reach the disk once something was spilled and the filter can't rule the key out.
+ * Memory and disk never hold the same key.
+ */
+template <typename T>
+class spilling_map
+{
+public:
+	spilling_map (std::string const & name_a) :
+	name (name_a)
+	{
+	}
+	/** Adds \p hash_a unless it's already in the table, like emplace an existing value is kept */
+	void insert (xpeed::block_hash const & hash_a, T const & value_a)
+	{
+		if (!on_disk (hash_a))
+		{
+			memory.emplace (hash_a, value_a);
+		}
+	}
+	/** Returns true and sets \p value_a if \p hash_a is in the table */
+	bool find (xpeed::block_hash const & hash_a, T & value_a) const
+	{
+		auto result (false);
+		auto existing (memory.find (hash_a));
+		if (existing != memory.end ())
+		{
+			value_a = existing->second;
+			result = true;
+		}
+		else if (spilled > 0 && filter.maybe (hash_a))
+		{
+			auto transaction (store->env->tx_begin ());
+			xpeed::mdb_val value;
+			if (mdb_get (store->env->tx (transaction), table, xpeed::mdb_val (hash_a), value) == MDB_SUCCESS)
+			{
+				assert (value.size () == sizeof (T));
+				std::memcpy (&value_a, value.data (), sizeof (T));
+				result = true;
+			}
+		}
+		return result;
+	}
+	bool exists (xpeed::block_hash const & hash_a) const
+	{
+		T value;
+		return find (hash_a, value);
+	}
+	void erase (xpeed::block_hash const & hash_a)
+	{
+		if (memory.erase (hash_a) == 0 && on_disk (hash_a))
+		{
+			auto transaction (store->env->tx_begin (true));
+			if (mdb_del (store->env->tx (transaction), table, xpeed::mdb_val (hash_a), nullptr) == MDB_SUCCESS)
+			{
+				--spilled;
+			}
+		}
+	}
+	void clear ()
+	{
+		decltype (memory) ().swap (memory);
+		if (spilled > 0)
+		{
+			auto transaction (store->env->tx_begin (true));
+			mdb_drop (store->env->tx (transaction), table, 0);
+			spilled = 0;
+			filter.reset (0);
+		}
+	}
+	/** Move every entry held in memory to \p store_a, returns how many were moved */
+	size_t spill (xpeed::spill_store & store_a)
+	{
+		if (store == nullptr)
+		{
+			store = &store_a;
+			table = store_a.table (name);
+		}
+		assert (store == &store_a);
+		auto result (memory.size ());
+		{
+			auto transaction (store->env->tx_begin (true));
+			for (auto & i : memory)
+			{
+				if (mdb_put (store->env->tx (transaction), table, xpeed::mdb_val (i.first), xpeed::mdb_val (sizeof (T), const_cast<T *> (&i.second)), MDB_NOOVERWRITE) == MDB_SUCCESS)
+				{
+					++spilled;
+					filter.insert (i.first);
+				}
+			}
+			if (filter.saturated ())
+			{
+				// Erased keys stay in the filter too, rebuilding from the table drops them while growing it
+				filter.reset (spilled * 2);
+				MDB_cursor * cursor;
+				auto status (mdb_cursor_open (store->env->tx (transaction), table, &cursor));
+				release_assert (status == MDB_SUCCESS);
+				xpeed::mdb_val key;
+				xpeed::mdb_val value;
+				for (auto read (mdb_cursor_get (cursor, key, value, MDB_FIRST)); read == MDB_SUCCESS; read = mdb_cursor_get (cursor, key, value, MDB_NEXT))
+				{
+					filter.insert (static_cast<xpeed::block_hash> (key));
+				}
+				mdb_cursor_close (cursor);
+			}
+		}
+		decltype (memory) ().swap (memory);
+		return result;
+	}
+	size_t size () const
+	{
+		return memory.size () + spilled;
+	}
+	size_t memory_size () const
+	{
+		return memory.size ();
+	}
+	size_t memory_bytes () const
+	{
+		return memory.size () * entry_size;
+	}
+	// Hash, value, node links, cached hash code and allocator overhead
+	static size_t constexpr entry_size = sizeof (xpeed::block_hash) + sizeof (T) + 48;
+	size_t spilled{ 0 };
+
+private:
+	bool on_disk (xpeed::block_hash const & hash_a) const
+	{
+		auto result (false);
+		if (spilled > 0 && filter.maybe (hash_a))
+		{
+			auto transaction (store->env->tx_begin ());
+			xpeed::mdb_val value;
+			result = mdb_get (store->env->tx (transaction), table, xpeed::mdb_val (hash_a), value) == MDB_SUCCESS;
+		}
+		return result;
+	}
+	std::string name;
+	std::unordered_map<xpeed::block_hash, T> memory;
+	xpeed::spill_store * store{ nullptr };
+	MDB_dbi table{ 0 };
+	xpeed::spill_filter filter;
+};
+template <typename T>
+size_t constexpr spilling_map<T>::entry_size;
+
+/**
+ * FIFO of block hashes which moves its entries to a spill_store on request. Hashes still in memory are taken before
+ * spilled ones, callers mustn't rely on a strict order.
+ */
+class spilling_queue
+{
+public:
+	spilling_queue (std::string const &);
+	void push_back (xpeed::block_hash const &);
+	/** Move up to \p count_a hashes from the queue to the end of \p result_a */
+	void pop_front (std::vector<xpeed::block_hash> & result_a, size_t count_a);
+	size_t spill (xpeed::spill_store &);
+	void clear ();
+	bool empty () const;
+	size_t size () const;
+	size_t memory_size () const;
+	size_t memory_bytes () const;
+	static size_t constexpr entry_size = sizeof (xpeed::block_hash);
+	size_t spilled;
+
+private:
+	std::string name;
+	std::deque<xpeed::block_hash> memory;
+	xpeed::spill_store * store;
+	MDB_dbi table;
+	// Key of the next spilled hash, stored big endian so the table iterates in insertion order
+	uint64_t sequence;
+};
+}
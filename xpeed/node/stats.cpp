@@ -369,6 +369,27 @@ std::string xpeed::stat::type_to_string (uint32_t key)
 		case xpeed::stat::type::message:
 			res = "message";
 			break;
+		case xpeed::stat::type::active:
+			res = "active";
+			break;
+		case xpeed::stat::type::confirmation_height:
+			res = "confirmation_height";
+			break;
+		case xpeed::stat::type::filter:
+			res = "filter";
+			break;
+		case xpeed::stat::type::rate_limit:
+			res = "rate_limit";
+			break;
+		case xpeed::stat::type::tcp:
+			res = "tcp";
+			break;
+		case xpeed::stat::type::decode:
+			res = "decode";
+			break;
+		case xpeed::stat::type::block_processor:
+			res = "block_processor";
+			break;
 	}
 	return res;
 }
@@ -412,9 +433,57 @@ std::string xpeed::stat::detail_to_string (uint32_t key)
 		case xpeed::stat::detail::frontier_req:
 			res = "frontier_req";
 			break;
+		case xpeed::stat::detail::blocks_served:
+			res = "blocks_served";
+			break;
+		case xpeed::stat::detail::frontiers_served:
+			res = "frontiers_served";
+			break;
+		case xpeed::stat::detail::lazy_spilled:
+			res = "lazy_spilled";
+			break;
+		case xpeed::stat::detail::blocks_verified:
+			res = "blocks_verified";
+			break;
+		case xpeed::stat::detail::peer_penalized:
+			res = "peer_penalized";
+			break;
+		case xpeed::stat::detail::serving_delayed:
+			res = "serving_delayed";
+			break;
+		case xpeed::stat::detail::serving_throttled:
+			res = "serving_throttled";
+			break;
 		case xpeed::stat::detail::handshake:
 			res = "handshake";
 			break;
+		case xpeed::stat::detail::channel_connect:
+			res = "channel_connect";
+			break;
+		case xpeed::stat::detail::channel_accept:
+			res = "channel_accept";
+			break;
+		case xpeed::stat::detail::channel_refused:
+			res = "channel_refused";
+			break;
+		case xpeed::stat::detail::channel_close:
+			res = "channel_close";
+			break;
+		case xpeed::stat::detail::arena:
+			res = "arena";
+			break;
+		case xpeed::stat::detail::promote:
+			res = "promote";
+			break;
+		case xpeed::stat::detail::signature_verify:
+			res = "signature_verify";
+			break;
+		case xpeed::stat::detail::ledger_apply:
+			res = "ledger_apply";
+			break;
+		case xpeed::stat::detail::unchecked_resolve:
+			res = "unchecked_resolve";
+			break;
 		case xpeed::stat::detail::http_callback:
 			res = "http_callback";
 			break;
@@ -427,6 +496,9 @@ std::string xpeed::stat::detail_to_string (uint32_t key)
 		case xpeed::stat::detail::initiate_wallet_lazy:
 			res = "initiate_wallet_lazy";
 			break;
+		case xpeed::stat::detail::initiate_ascending:
+			res = "initiate_ascending";
+			break;
 		case xpeed::stat::detail::insufficient_work:
 			res = "insufficient_work";
 			break;
@@ -469,9 +541,36 @@ std::string xpeed::stat::detail_to_string (uint32_t key)
 		case xpeed::stat::detail::vote_overflow:
 			res = "vote_overflow";
 			break;
+		case xpeed::stat::detail::vote_overflow_tier_0:
+			res = "vote_overflow_tier_0";
+			break;
+		case xpeed::stat::detail::vote_overflow_tier_1:
+			res = "vote_overflow_tier_1";
+			break;
+		case xpeed::stat::detail::vote_overflow_tier_2:
+			res = "vote_overflow_tier_2";
+			break;
+		case xpeed::stat::detail::vote_overflow_tier_3:
+			res = "vote_overflow_tier_3";
+			break;
+		case xpeed::stat::detail::vote_duplicate:
+			res = "vote_duplicate";
+			break;
 		case xpeed::stat::detail::blocking:
 			res = "blocking";
 			break;
+		case xpeed::stat::detail::ingress_batch:
+			res = "ingress_batch";
+			break;
+		case xpeed::stat::detail::ingress_drop:
+			res = "ingress_drop";
+			break;
+		case xpeed::stat::detail::egress_batch:
+			res = "egress_batch";
+			break;
+		case xpeed::stat::detail::egress_coalesced:
+			res = "egress_coalesced";
+			break;
 		case xpeed::stat::detail::overflow:
 			res = "overflow";
 			break;
@@ -508,6 +607,21 @@ std::string xpeed::stat::detail_to_string (uint32_t key)
 		case xpeed::stat::detail::outdated_version:
 			res = "outdated_version";
 			break;
+		case xpeed::stat::detail::shard_contention:
+			res = "shard_contention";
+			break;
+		case xpeed::stat::detail::election_request:
+			res = "election_request";
+			break;
+		case xpeed::stat::detail::request_slice_full:
+			res = "request_slice_full";
+			break;
+		case xpeed::stat::detail::blocks_confirmed:
+			res = "blocks_confirmed";
+			break;
+		case xpeed::stat::detail::invalid_block:
+			res = "invalid_block";
+			break;
 	}
 	return res;
 }
@@ -228,7 +228,14 @@ public:
 		http_callback,
 		peering,
 		ipc,
-		udp
+		udp,
+		active,
+		confirmation_height,
+		filter,
+		rate_limit,
+		tcp,
+		decode,
+		block_processor
 	};
 
 	/** Optional detail type */
@@ -263,21 +270,38 @@ public:
 		initiate,
 		initiate_lazy,
 		initiate_wallet_lazy,
+		initiate_ascending,
 
 		// bootstrap specific
 		bulk_pull,
 		bulk_push,
 		bulk_pull_account,
 		frontier_req,
+		blocks_served,
+		frontiers_served,
+		lazy_spilled,
+		blocks_verified,
+		peer_penalized,
+		serving_delayed,
+		serving_throttled,
 
 		// vote specific
 		vote_valid,
 		vote_replay,
 		vote_invalid,
 		vote_overflow,
+		vote_overflow_tier_0,
+		vote_overflow_tier_1,
+		vote_overflow_tier_2,
+		vote_overflow_tier_3,
+		vote_duplicate,
 
 		// udp
 		blocking,
+		ingress_batch,
+		ingress_drop,
+		egress_batch,
+		egress_coalesced,
 		overflow,
 		invalid_magic,
 		invalid_network,
@@ -295,6 +319,30 @@ public:
 
 		// peering
 		handshake,
+
+		// tcp
+		channel_connect,
+		channel_accept,
+		channel_refused,
+		channel_close,
+
+		// decode
+		arena,
+		promote,
+
+		// block processor, durations in microseconds
+		signature_verify,
+		ledger_apply,
+		unchecked_resolve,
+
+		// active
+		shard_contention,
+		election_request,
+		request_slice_full,
+
+		// confirmation height
+		blocks_confirmed,
+		invalid_block,
 	};
 
 	/** Direction of the stat. If the direction is irrelevant, use in */
@@ -0,0 +1,564 @@
+#include <xpeed/node/tcp_channels.hpp>
+
+#include <xpeed/node/node.hpp>
+
+size_t constexpr xpeed::tcp_channel::max_queued_bytes;
+size_t constexpr xpeed::tcp_channel::max_write_bytes;
+size_t constexpr xpeed::tcp_channel::max_frame_size;
+std::chrono::seconds constexpr xpeed::tcp_channel::idle_timeout;
+std::chrono::seconds constexpr xpeed::tcp_channels::connect_interval;
+std::chrono::minutes constexpr xpeed::tcp_channels::retry_interval;
+
+xpeed::tcp_channel::tcp_channel (xpeed::tcp_channels & channels_a, std::shared_ptr<xpeed::socket> socket_a, xpeed::endpoint const & endpoint_a, bool outbound_a) :
+endpoint (endpoint_a),
+outbound (outbound_a),
+channels (channels_a),
+socket (socket_a),
+queued_bytes (0),
+writing (false),
+closed (false),
+write_buffer (std::make_shared<std::vector<uint8_t>> ()),
+receive_buffer (std::make_shared<std::vector<uint8_t>> (max_frame_size)),
+last_read (std::chrono::steady_clock::now ().time_since_epoch ().count ()),
+write_started (std::numeric_limits<uint64_t>::max ())
+{
+}
+
+bool xpeed::tcp_channel::send (std::shared_ptr<std::vector<uint8_t>> const & message_a, xpeed::stat::detail detail_a)
+{
+	assert (message_a->size () <= max_frame_size);
+	auto result (true);
+	auto write (false);
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		if (!closed)
+		{
+			if (queued_bytes + message_a->size () <= max_queued_bytes)
+			{
+				queue.push_back (frame{ message_a, detail_a });
+				queued_bytes += message_a->size ();
+				if (queued_bytes > max_queued)
+				{
+					max_queued = queued_bytes;
+				}
+				write = !writing;
+				writing = true;
+				result = false;
+			}
+			else
+			{
+				++overflows;
+			}
+		}
+	}
+	if (write)
+	{
+		write_next ();
+	}
+	return result;
+}
+
+void xpeed::tcp_channel::start ()
+{
+	last_read = std::chrono::steady_clock::now ().time_since_epoch ().count ();
+	read_length ();
+	checkup ();
+}
+
+void xpeed::tcp_channel::close ()
+{
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		closed = true;
+		queue.clear ();
+		queued_bytes = 0;
+	}
+	socket->close ();
+}
+
+void xpeed::tcp_channel::write_next ()
+{
+	// Only the thread which set writing gets here, write_buffer and write_details are left alone until the write completes
+	write_buffer->clear ();
+	write_details.clear ();
+	auto write (false);
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		while (!queue.empty () && write_buffer->size () + queue.front ().message->size () + 2 <= max_write_bytes)
+		{
+			auto & message (*queue.front ().message);
+			write_buffer->push_back (static_cast<uint8_t> (message.size () >> 8));
+			write_buffer->push_back (static_cast<uint8_t> (message.size ()));
+			write_buffer->insert (write_buffer->end (), message.begin (), message.end ());
+			write_details.push_back (queue.front ().detail);
+			queued_bytes -= message.size ();
+			queue.pop_front ();
+		}
+		write = !write_buffer->empty ();
+		writing = write;
+	}
+	// Once writing is cleared a concurrent send may already be refilling write_buffer, only the local decision is ours
+	if (write)
+	{
+		auto this_l (shared_from_this ());
+		write_started = std::chrono::steady_clock::now ().time_since_epoch ().count ();
+		boost::asio::async_write (socket->socket_m, boost::asio::buffer (write_buffer->data (), write_buffer->size ()), [this_l](boost::system::error_code const & ec, size_t size_a) {
+			this_l->write_started = std::numeric_limits<uint64_t>::max ();
+			if (!ec)
+			{
+				auto & stats (this_l->channels.node.stats);
+				this_l->bytes_out += size_a;
+				this_l->messages_out += this_l->write_details.size ();
+				++this_l->writes;
+				stats.add (xpeed::stat::type::tcp, xpeed::stat::dir::out, size_a);
+				stats.add (xpeed::stat::type::traffic, xpeed::stat::dir::out, size_a);
+				for (auto detail : this_l->write_details)
+				{
+					if (detail != xpeed::stat::detail::all)
+					{
+						stats.inc (xpeed::stat::type::message, detail, xpeed::stat::dir::out);
+					}
+				}
+				this_l->write_next ();
+			}
+			else
+			{
+				this_l->fail (ec);
+			}
+		});
+	}
+}
+
+void xpeed::tcp_channel::read_length ()
+{
+	auto this_l (shared_from_this ());
+	boost::asio::async_read (socket->socket_m, boost::asio::buffer (receive_buffer->data (), 2), [this_l](boost::system::error_code const & ec, size_t size_a) {
+		if (!ec)
+		{
+			this_l->last_read = std::chrono::steady_clock::now ().time_since_epoch ().count ();
+			auto size ((static_cast<size_t> ((*this_l->receive_buffer)[0]) << 8) | (*this_l->receive_buffer)[1]);
+			if (size > 0 && size <= max_frame_size)
+			{
+				this_l->read_frame (size);
+			}
+			else
+			{
+				this_l->fail (boost::system::errc::make_error_code (boost::system::errc::message_size));
+			}
+		}
+		else
+		{
+			this_l->fail (ec);
+		}
+	});
+}
+
+void xpeed::tcp_channel::read_frame (size_t size_a)
+{
+	auto this_l (shared_from_this ());
+	boost::asio::async_read (socket->socket_m, boost::asio::buffer (receive_buffer->data (), size_a), [this_l](boost::system::error_code const & ec, size_t size_a) {
+		if (!ec)
+		{
+			this_l->last_read = std::chrono::steady_clock::now ().time_since_epoch ().count ();
+			this_l->bytes_in += size_a + 2;
+			++this_l->messages_in;
+			this_l->channels.node.stats.add (xpeed::stat::type::tcp, xpeed::stat::dir::in, size_a + 2);
+			this_l->channels.node.network.process_message (this_l->receive_buffer->data (), size_a, this_l->endpoint, max_frame_size);
+			xpeed::message_arena::local ().reset ();
+			this_l->read_length ();
+		}
+		else
+		{
+			this_l->fail (ec);
+		}
+	});
+}
+
+void xpeed::tcp_channel::fail (boost::system::error_code const & ec)
+{
+	if (channels.node.config.logging.network_logging () && ec != boost::asio::error::operation_aborted)
+	{
+		BOOST_LOG (channels.node.log) << boost::str (boost::format ("Closing realtime channel with %1%: %2%") % endpoint % ec.message ());
+	}
+	channels.erase (*this);
+	close ();
+}
+
+void xpeed::tcp_channel::checkup ()
+{
+	std::weak_ptr<xpeed::tcp_channel> this_w (shared_from_this ());
+	channels.node.alarm.add (std::chrono::steady_clock::now () + std::min<std::chrono::steady_clock::duration> (idle_timeout, std::chrono::seconds (10)), [this_w]() {
+		if (auto this_l = this_w.lock ())
+		{
+			auto closed_l (false);
+			{
+				std::lock_guard<std::mutex> lock (this_l->mutex);
+				closed_l = this_l->closed;
+			}
+			if (!closed_l)
+			{
+				auto cutoff (static_cast<uint64_t> ((std::chrono::steady_clock::now () - idle_timeout).time_since_epoch ().count ()));
+				if (this_l->last_read < cutoff || this_l->write_started < cutoff)
+				{
+					this_l->fail (boost::asio::error::timed_out);
+				}
+				else
+				{
+					this_l->checkup ();
+				}
+			}
+		}
+	});
+}
+
+void xpeed::tcp_channel::serialize_stats (boost::property_tree::ptree & tree_a)
+{
+	std::stringstream endpoint_l;
+	endpoint_l << endpoint;
+	tree_a.put ("endpoint", endpoint_l.str ());
+	tree_a.put ("direction", outbound ? "out" : "in");
+	tree_a.put ("bytes_in", bytes_in.load ());
+	tree_a.put ("bytes_out", bytes_out.load ());
+	tree_a.put ("messages_in", messages_in.load ());
+	tree_a.put ("messages_out", messages_out.load ());
+	tree_a.put ("writes", writes.load ());
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		tree_a.put ("queued_messages", queue.size ());
+		tree_a.put ("queued_bytes", queued_bytes);
+	}
+	tree_a.put ("max_queued_bytes", max_queued.load ());
+	tree_a.put ("overflows", overflows.load ());
+}
+
+xpeed::tcp_channels::tcp_channels (xpeed::node & node_a) :
+node (node_a),
+outbound (0),
+stopped (false)
+{
+}
+
+void xpeed::tcp_channels::start ()
+{
+	if (node.config.tcp_realtime_channels > 0)
+	{
+		ongoing_connect ();
+	}
+}
+
+void xpeed::tcp_channels::stop ()
+{
+	decltype (channels) channels_l;
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		stopped = true;
+		channels_l.swap (channels);
+		outbound = 0;
+	}
+	for (auto & i : channels_l)
+	{
+		i.second->close ();
+	}
+}
+
+bool xpeed::tcp_channels::send (std::shared_ptr<std::vector<uint8_t>> const & message_a, xpeed::endpoint const & endpoint_a, xpeed::stat::detail detail_a)
+{
+	auto result (true);
+	if (node.config.tcp_realtime_channels > 0)
+	{
+		std::shared_ptr<xpeed::tcp_channel> channel;
+		{
+			std::lock_guard<std::mutex> lock (mutex);
+			auto existing (channels.find (endpoint_a));
+			if (existing != channels.end ())
+			{
+				channel = existing->second;
+			}
+		}
+		if (channel != nullptr)
+		{
+			result = channel->send (message_a, detail_a);
+			if (result)
+			{
+				// The peer isn't keeping up, this message goes by UDP instead
+				node.stats.inc (xpeed::stat::type::tcp, xpeed::stat::detail::overflow, xpeed::stat::dir::out);
+			}
+		}
+	}
+	return result;
+}
+
+bool xpeed::tcp_channels::connected (xpeed::endpoint const & endpoint_a)
+{
+	auto result (false);
+	if (node.config.tcp_realtime_channels > 0)
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		result = channels.find (endpoint_a) != channels.end ();
+	}
+	return result;
+}
+
+bool xpeed::tcp_channels::accept (std::shared_ptr<xpeed::socket> socket_a, xpeed::keepalive const & request_a)
+{
+	auto result (false);
+	if (node.config.tcp_realtime_channels > 0)
+	{
+		auto remote (socket_a->remote_endpoint ());
+		auto endpoint (xpeed::map_endpoint_to_v6 (xpeed::endpoint (remote.address (), request_a.peers[0].port ())));
+		if (endpoint.port () != 0 && (!xpeed::reserved_address (endpoint, false) || node.config.allow_local_peers))
+		{
+			auto keep_outbound_l (keep_outbound (endpoint));
+			std::lock_guard<std::mutex> lock (mutex);
+			auto existing (channels.find (endpoint));
+			auto replace (existing != channels.end () && existing->second->outbound && keep_outbound_l && !*keep_outbound_l);
+			result = !stopped && channels.size () - outbound < node.config.tcp_realtime_channels && (existing == channels.end () || replace);
+		}
+		if (result)
+		{
+			auto peers (request_a.peers);
+			peers[0] = xpeed::endpoint (boost::asio::ip::address_v6 (), 0);
+			node.network.merge_peers (peers);
+			xpeed::keepalive response;
+			node.peers.random_fill (response.peers);
+			response.header.extensions.set (xpeed::message_header::keepalive_tcp_realtime_flag);
+			socket_a->async_write (response.to_bytes (), [this, socket_a, endpoint](boost::system::error_code const & ec, size_t) {
+				if (!ec)
+				{
+					add (std::make_shared<xpeed::tcp_channel> (*this, socket_a, endpoint, false));
+				}
+				else
+				{
+					socket_a->close ();
+				}
+			});
+		}
+	}
+	return result;
+}
+
+void xpeed::tcp_channels::erase (xpeed::tcp_channel & channel_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	auto existing (channels.find (channel_a.endpoint));
+	if (existing != channels.end () && existing->second.get () == &channel_a)
+	{
+		if (channel_a.outbound)
+		{
+			--outbound;
+			// Don't reconnect straight away to a peer which just dropped the channel
+			attempts[channel_a.endpoint] = std::chrono::steady_clock::now ();
+		}
+		channels.erase (existing);
+		node.stats.inc (xpeed::stat::type::tcp, xpeed::stat::detail::channel_close);
+	}
+}
+
+size_t xpeed::tcp_channels::size ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	return channels.size ();
+}
+
+void xpeed::tcp_channels::serialize_stats (boost::property_tree::ptree & tree_a)
+{
+	std::vector<std::shared_ptr<xpeed::tcp_channel>> channels_l;
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		for (auto & i : channels)
+		{
+			channels_l.push_back (i.second);
+		}
+	}
+	boost::property_tree::ptree channels_tree;
+	for (auto & i : channels_l)
+	{
+		boost::property_tree::ptree channel_tree;
+		i->serialize_stats (channel_tree);
+		channels_tree.push_back (std::make_pair ("", channel_tree));
+	}
+	tree_a.add_child ("channels", channels_tree);
+}
+
+void xpeed::tcp_channels::ongoing_connect ()
+{
+	// Representatives are preferred since most of the volume is confirm_req and confirm_ack exchanged with them
+	auto limit (node.config.tcp_realtime_channels);
+	auto candidates (node.peers.representatives (limit));
+	auto random (node.peers.list_vector (limit));
+	candidates.insert (candidates.end (), random.begin (), random.end ());
+	std::vector<xpeed::endpoint> targets;
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		auto now (std::chrono::steady_clock::now ());
+		for (auto i (attempts.begin ()); i != attempts.end ();)
+		{
+			i = now - i->second > retry_interval ? attempts.erase (i) : std::next (i);
+		}
+		for (auto i (candidates.begin ()), n (candidates.end ()); i != n && !stopped && outbound + targets.size () < limit; ++i)
+		{
+			if (channels.find (i->endpoint) == channels.end () && attempts.find (i->endpoint) == attempts.end ())
+			{
+				attempts[i->endpoint] = now;
+				targets.push_back (i->endpoint);
+			}
+		}
+	}
+	for (auto & i : targets)
+	{
+		connect (i);
+	}
+	std::weak_ptr<xpeed::node> node_w (node.shared ());
+	node.alarm.add (std::chrono::steady_clock::now () + connect_interval, [node_w]() {
+		if (auto node_l = node_w.lock ())
+		{
+			node_l->network.channels.ongoing_connect ();
+		}
+	});
+}
+
+void xpeed::tcp_channels::connect (xpeed::endpoint const & endpoint_a)
+{
+	// Pending operations on the socket keep the node, and with it this object, alive
+	auto socket (std::make_shared<xpeed::socket> (node.shared ()));
+	socket->async_connect (xpeed::tcp_endpoint (endpoint_a.address (), endpoint_a.port ()), [this, socket, endpoint_a](boost::system::error_code const & ec) {
+		if (!ec)
+		{
+			xpeed::keepalive request;
+			node.peers.random_fill (request.peers);
+			request.peers[0] = xpeed::endpoint (boost::asio::ip::address_v6 (), node.network.endpoint ().port ());
+			request.header.extensions.set (xpeed::message_header::keepalive_tcp_realtime_flag);
+			socket->async_write (request.to_bytes (), [this, socket, endpoint_a](boost::system::error_code const & ec, size_t) {
+				if (!ec)
+				{
+					auto buffer (std::make_shared<std::vector<uint8_t>> (xpeed::bootstrap_message_header_size + xpeed::keepalive::size));
+					socket->async_read (buffer, buffer->size (), [this, socket, endpoint_a, buffer](boost::system::error_code const & ec, size_t size_a) {
+						auto error (static_cast<bool> (ec));
+						xpeed::bufferstream stream (buffer->data (), size_a);
+						xpeed::message_header header (error, stream);
+						if (!error && header.keepalive_is_tcp_realtime ())
+						{
+							xpeed::keepalive response (error, stream, header);
+							if (!error)
+							{
+								node.network.merge_peers (response.peers);
+								add (std::make_shared<xpeed::tcp_channel> (*this, socket, endpoint_a, true));
+							}
+						}
+						else
+						{
+							if (!error)
+							{
+								// Answered like a plain keepalive, the peer stays on UDP until retry_interval passes
+								node.stats.inc (xpeed::stat::type::tcp, xpeed::stat::detail::channel_refused, xpeed::stat::dir::out);
+							}
+							error = true;
+						}
+						// Nothing else owns the connection unless it became a channel
+						if (error)
+						{
+							socket->close ();
+						}
+					});
+				}
+				else
+				{
+					socket->close ();
+				}
+			});
+		}
+		else if (node.config.logging.network_logging ())
+		{
+			BOOST_LOG (node.log) << boost::str (boost::format ("Unable to open realtime channel to %1%: %2%") % endpoint_a % ec.message ());
+		}
+	});
+}
+
+void xpeed::tcp_channels::add (std::shared_ptr<xpeed::tcp_channel> channel_a)
+{
+	auto added (false);
+	std::shared_ptr<xpeed::tcp_channel> replaced;
+	auto keep_outbound_l (keep_outbound (channel_a->endpoint));
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		// Accepting doesn't reserve a slot, both directions are held to the limit here under the same lock
+		auto count (channel_a->outbound ? outbound : channels.size () - outbound);
+		auto existing (channels.find (channel_a->endpoint));
+		if (!stopped && count < node.config.tcp_realtime_channels)
+		{
+			if (existing == channels.end ())
+			{
+				channels[channel_a->endpoint] = channel_a;
+				if (channel_a->outbound)
+				{
+					++outbound;
+					attempts.erase (channel_a->endpoint);
+				}
+				added = true;
+			}
+			else if (existing->second->outbound != channel_a->outbound && keep_outbound_l && *keep_outbound_l == channel_a->outbound)
+			{
+				// Both ends opened a channel at the same time, each end keeps the same connection and drops the other
+				replaced = existing->second;
+				existing->second = channel_a;
+				if (channel_a->outbound)
+				{
+					++outbound;
+					attempts.erase (channel_a->endpoint);
+				}
+				else
+				{
+					--outbound;
+				}
+				added = true;
+			}
+		}
+	}
+	if (replaced != nullptr)
+	{
+		replaced->close ();
+	}
+	if (added)
+	{
+		node.stats.inc (xpeed::stat::type::tcp, channel_a->outbound ? xpeed::stat::detail::channel_connect : xpeed::stat::detail::channel_accept);
+		if (node.config.logging.network_logging ())
+		{
+			BOOST_LOG (node.log) << boost::str (boost::format ("Realtime channel %1% %2%") % (channel_a->outbound ? "opened to" : "accepted from") % channel_a->endpoint);
+		}
+		channel_a->start ();
+	}
+	else
+	{
+		// The other end's channel was kept or the limit was reached meanwhile
+		channel_a->close ();
+	}
+}
+
+boost::optional<bool> xpeed::tcp_channels::keep_outbound (xpeed::endpoint const & endpoint_a)
+{
+	boost::optional<bool> result;
+	auto node_id (node.peers.node_id (endpoint_a));
+	if (node_id)
+	{
+		result = node.node_id.pub < *node_id;
+	}
+	return result;
+}
+
+namespace xpeed
+{
+std::unique_ptr<seq_con_info_component> collect_seq_con_info (tcp_channels & tcp_channels, const std::string & name)
+{
+	size_t channels_count;
+	size_t attempts_count;
+	{
+		std::lock_guard<std::mutex> guard (tcp_channels.mutex);
+		channels_count = tcp_channels.channels.size ();
+		attempts_count = tcp_channels.attempts.size ();
+	}
+	auto composite = std::make_unique<seq_con_info_composite> (name);
+	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "channels", channels_count, sizeof (decltype (tcp_channels.channels)::value_type) }));
+	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "attempts", attempts_count, sizeof (decltype (tcp_channels.attempts)::value_type) }));
+	return composite;
+}
+}
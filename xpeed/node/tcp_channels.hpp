@@ -0,0 +1,121 @@
+#pragma once
+
+#include <xpeed/lib/utility.hpp>
+#include <xpeed/node/common.hpp>
+#include <xpeed/node/stats.hpp>
+
+#include <boost/optional.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace xpeed
+{
+class node;
+class socket;
+class tcp_channels;
+/**
+ * Realtime messages exchanged with one peer over a connection to its bootstrap port. Each frame is a big endian 16 bit
+ * length followed by a serialized keepalive, publish, confirm_req or confirm_ack. Outgoing frames wait in a queue
+ * bounded by max_queued_bytes and are coalesced in to writes of up to max_write_bytes, with a single write in flight.
+ */
+class tcp_channel : public std::enable_shared_from_this<xpeed::tcp_channel>
+{
+public:
+	tcp_channel (xpeed::tcp_channels &, std::shared_ptr<xpeed::socket>, xpeed::endpoint const &, bool);
+	/** Queue \p message_a, returns true if the queue is full or the channel is closed */
+	bool send (std::shared_ptr<std::vector<uint8_t>> const & message_a, xpeed::stat::detail detail_a);
+	void start ();
+	void close ();
+	void serialize_stats (boost::property_tree::ptree &);
+	/** Peering endpoint of the peer, messages received here are processed as if they came from it */
+	xpeed::endpoint const endpoint;
+	bool const outbound;
+	static size_t constexpr max_queued_bytes = 1024 * 1024;
+	static size_t constexpr max_write_bytes = 64 * 1024;
+	static size_t constexpr max_frame_size = 16 * 1024;
+	/** A channel is closed once nothing was received or a write has been pending this long, live peers send keepalives well within it */
+	static std::chrono::seconds constexpr idle_timeout = xpeed::is_test_network ? std::chrono::seconds (5) : std::chrono::seconds (5 * 60);
+
+private:
+	class frame
+	{
+	public:
+		std::shared_ptr<std::vector<uint8_t>> message;
+		xpeed::stat::detail detail;
+	};
+	void write_next ();
+	void read_length ();
+	void read_frame (size_t);
+	void fail (boost::system::error_code const &);
+	/** Reads and writes bypass xpeed::socket, whose single deadline can't cover both, so the channel keeps its own */
+	void checkup ();
+	xpeed::tcp_channels & channels;
+	std::shared_ptr<xpeed::socket> socket;
+	std::mutex mutex;
+	std::deque<frame> queue;
+	size_t queued_bytes;
+	bool writing;
+	bool closed;
+	std::shared_ptr<std::vector<uint8_t>> write_buffer;
+	std::vector<xpeed::stat::detail> write_details;
+	std::shared_ptr<std::vector<uint8_t>> receive_buffer;
+	// Steady clock ticks of the last completed read and of the start of the write in flight, max when none is
+	std::atomic<uint64_t> last_read;
+	std::atomic<uint64_t> write_started;
+	std::atomic<uint64_t> bytes_in{ 0 };
+	std::atomic<uint64_t> bytes_out{ 0 };
+	std::atomic<uint64_t> messages_in{ 0 };
+	std::atomic<uint64_t> messages_out{ 0 };
+	std::atomic<uint64_t> writes{ 0 };
+	std::atomic<uint64_t> overflows{ 0 };
+	std::atomic<uint64_t> max_queued{ 0 };
+};
+/**
+ * Optional realtime channels multiplexed over bootstrap connections. The initiator sends a keepalive with
+ * keepalive_tcp_realtime_flag set whose first peer carries its own peering port, a peer which agrees echoes the flag
+ * and both ends switch the connection to tcp_channel framing. Peers which don't answer with the flag, including nodes
+ * without this feature, keep receiving everything over UDP and aren't asked again for retry_interval.
+ */
+class tcp_channels
+{
+public:
+	tcp_channels (xpeed::node &);
+	void start ();
+	void stop ();
+	/** Send \p message_a over the channel to \p endpoint_a, returns true if there is none or it's congested and UDP should be used */
+	bool send (std::shared_ptr<std::vector<uint8_t>> const & message_a, xpeed::endpoint const & endpoint_a, xpeed::stat::detail detail_a);
+	bool connected (xpeed::endpoint const &);
+	/** Take over an incoming bootstrap connection which asked for a realtime channel, returns true if it was accepted */
+	bool accept (std::shared_ptr<xpeed::socket>, xpeed::keepalive const &);
+	void erase (xpeed::tcp_channel &);
+	size_t size ();
+	void serialize_stats (boost::property_tree::ptree &);
+	xpeed::node & node;
+	static std::chrono::seconds constexpr connect_interval = std::chrono::seconds (15);
+	static std::chrono::minutes constexpr retry_interval = std::chrono::minutes (5);
+
+private:
+	void ongoing_connect ();
+	void connect (xpeed::endpoint const &);
+	void add (std::shared_ptr<xpeed::tcp_channel>);
+	/** When both ends open a channel, both keep the one opened by the lower node ID. Whether that's ours, none if the peer's node ID isn't known */
+	boost::optional<bool> keep_outbound (xpeed::endpoint const &);
+	std::mutex mutex;
+	std::unordered_map<xpeed::endpoint, std::shared_ptr<xpeed::tcp_channel>> channels;
+	// Endpoints being connected to or which refused a channel, by time of the attempt
+	std::unordered_map<xpeed::endpoint, std::chrono::steady_clock::time_point> attempts;
+	size_t outbound;
+	bool stopped;
+
+	friend std::unique_ptr<seq_con_info_component> collect_seq_con_info (tcp_channels &, const std::string &);
+};
+
+std::unique_ptr<seq_con_info_component> collect_seq_con_info (tcp_channels &, const std::string &);
+}
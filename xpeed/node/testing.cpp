@@ -17,9 +17,10 @@ std::string xpeed::error_system_messages::message (int ev) const
 	return "Invalid error code";
 }
 
-xpeed::system::system (uint16_t port_a, uint16_t count_a) :
+xpeed::system::system (uint16_t port_a, uint16_t count_a, std::shared_ptr<xpeed::transport> transport_a) :
 alarm (io_ctx),
-work (1, nullptr)
+work (1, nullptr),
+transport (transport_a)
 {
 	auto scale_str = std::getenv ("DEADLINE_SCALE_FACTOR");
 	if (scale_str)
@@ -34,6 +35,11 @@ work (1, nullptr)
 		xpeed::node_config config (port_a + i, logging);
 		auto node (std::make_shared<xpeed::node> (init, io_ctx, xpeed::unique_path (), alarm, config, work));
 		assert (!init.error ());
+		if (transport != nullptr)
+		{
+			node->network.transport = transport;
+			transport->attach (node);
+		}
 		node->start ();
 		xpeed::uint256_union wallet;
 		xpeed::random_pool::generate_block (wallet.bytes.data (), wallet.bytes.size ());
@@ -65,6 +71,10 @@ work (1, nullptr)
 
 xpeed::system::~system ()
 {
+	if (transport != nullptr)
+	{
+		transport->stop ();
+	}
 	for (auto & i : nodes)
 	{
 		i->stop ();
@@ -121,6 +131,7 @@ class traffic_generator : public std::enable_shared_from_this<traffic_generator>
 {
 public:
 	traffic_generator (uint32_t count_a, uint32_t wait_a, std::shared_ptr<xpeed::node> node_a, xpeed::system & system_a) :
+	accounts (1, xpeed::test_genesis_key.pub),
 	count (count_a),
 	wait (wait_a),
 	node (node_a),
@@ -130,7 +141,7 @@ public:
 	void run ()
 	{
 		auto count_l (count - 1);
-		count = count_l - 1;
+		count = count_l;
 		system.generate_activity (*node, accounts);
 		if (count_l > 0)
 		{
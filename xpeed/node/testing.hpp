@@ -3,6 +3,7 @@
 #include <chrono>
 #include <xpeed/lib/errors.hpp>
 #include <xpeed/node/node.hpp>
+#include <xpeed/node/transport.hpp>
 
 namespace xpeed
 {
@@ -15,7 +16,8 @@ enum class error_system
 class system
 {
 public:
-	system (uint16_t, uint16_t);
+	/** Start \p count_a nodes on consecutive ports, connected through \p transport_a instead of UDP if one is given */
+	system (uint16_t port_a, uint16_t count_a, std::shared_ptr<xpeed::transport> transport_a = nullptr);
 	~system ();
 	void generate_activity (xpeed::node &, std::vector<xpeed::account> &);
 	void generate_mass_activity (uint32_t, xpeed::node &);
@@ -43,6 +45,7 @@ public:
 	std::vector<std::shared_ptr<xpeed::node>> nodes;
 	xpeed::logging logging;
 	xpeed::work_pool work;
+	std::shared_ptr<xpeed::transport> transport;
 	std::chrono::time_point<std::chrono::steady_clock, std::chrono::duration<double>> deadline{ std::chrono::steady_clock::time_point::max () };
 	double deadline_scaling_factor{ 1.0 };
 };
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <xpeed/node/common.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace xpeed
+{
+class node;
+/**
+ * Carries peering datagrams in place of the UDP socket. A node given a transport before it starts hands every outgoing
+ * datagram to send and neither reads nor writes its socket, the transport delivers incoming datagrams straight in to
+ * the node's udp_buffer. Bootstrap connections still use TCP.
+ */
+class transport
+{
+public:
+	virtual ~transport () = default;
+	/** Make \p node_a reachable at its network endpoint */
+	virtual void attach (std::shared_ptr<xpeed::node> node_a) = 0;
+	virtual void send (std::shared_ptr<std::vector<uint8_t>> const & payload_a, xpeed::endpoint const & source_a, xpeed::endpoint const & destination_a) = 0;
+	virtual void stop () = 0;
+};
+}
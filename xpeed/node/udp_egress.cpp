@@ -0,0 +1,243 @@
+#include <xpeed/node/udp_egress.hpp>
+
+#include <xpeed/node/node.hpp>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/socket.h>
+#endif
+
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+
+size_t constexpr xpeed::udp_egress::batch_size;
+size_t constexpr xpeed::udp_egress::max_queued;
+std::chrono::microseconds constexpr xpeed::udp_egress::flush_delay;
+
+xpeed::udp_egress::udp_egress (xpeed::network & network_a) :
+network (network_a),
+descriptor (-1),
+started (false),
+stopped (false)
+{
+}
+
+xpeed::udp_egress::~udp_egress ()
+{
+	stop ();
+}
+
+void xpeed::udp_egress::start (boost::asio::ip::udp::socket & socket_a, unsigned count_a)
+{
+#if defined(__linux__)
+	descriptor = socket_a.native_handle ();
+	boost::thread::attributes attrs;
+	xpeed::thread_attributes::set (attrs);
+	for (unsigned i (0); i < std::max (count_a, 1u); ++i)
+	{
+		queues.push_back (std::make_unique<xpeed::udp_egress::queue> ());
+		queues.back ()->datagrams.reserve (batch_size);
+	}
+	for (auto & entry : queues)
+	{
+		auto entry_l (entry.get ());
+		entry->thread = boost::thread (attrs, [this, entry_l]() {
+			xpeed::thread_role::set (xpeed::thread_role::name::udp_egress);
+			run (*entry_l);
+		});
+	}
+	started = true;
+#endif
+}
+
+void xpeed::udp_egress::stop ()
+{
+	stopped = true;
+	for (auto & entry : queues)
+	{
+		{
+			std::lock_guard<std::mutex> lock (entry->mutex);
+		}
+		entry->condition.notify_all ();
+		if (entry->thread.joinable ())
+		{
+			entry->thread.join ();
+		}
+	}
+}
+
+void xpeed::udp_egress::send (std::shared_ptr<std::vector<uint8_t>> const & payload_a, xpeed::endpoint const & endpoint_a, xpeed::stat::detail detail_a)
+{
+	auto & stats (network.node.stats);
+	if (started && !stopped)
+	{
+		// Threads keep to one queue so datagrams from a single sender leave in order
+		auto & entry (*queues[std::hash<std::thread::id> () (std::this_thread::get_id ()) % queues.size ()]);
+		auto notify (false);
+		{
+			std::lock_guard<std::mutex> lock (entry.mutex);
+			if (entry.datagrams.size () < max_queued)
+			{
+				if (entry.datagrams.empty ())
+				{
+					entry.oldest = std::chrono::steady_clock::now ();
+					notify = true;
+				}
+				entry.datagrams.push_back (xpeed::udp_egress::datagram{ payload_a, endpoint_a, detail_a });
+				notify = notify || entry.datagrams.size () == batch_size;
+			}
+			else
+			{
+				stats.inc (xpeed::stat::type::udp, xpeed::stat::detail::overflow, xpeed::stat::dir::out);
+			}
+		}
+		if (notify)
+		{
+			entry.condition.notify_one ();
+		}
+	}
+	else if (network.on)
+	{
+		std::weak_ptr<xpeed::node> node_w (network.node.shared ());
+		network.send_buffer (payload_a->data (), payload_a->size (), endpoint_a, [payload_a, node_w, endpoint_a, detail_a](boost::system::error_code const & ec, size_t) {
+			if (auto node_l = node_w.lock ())
+			{
+				if (ec)
+				{
+					if (node_l->config.logging.network_logging ())
+					{
+						BOOST_LOG (node_l->log) << boost::str (boost::format ("Error sending datagram to %1%: %2%") % endpoint_a % ec.message ());
+					}
+				}
+				else if (detail_a != xpeed::stat::detail::all)
+				{
+					node_l->stats.inc (xpeed::stat::type::message, detail_a, xpeed::stat::dir::out);
+				}
+			}
+		});
+	}
+}
+
+void xpeed::udp_egress::run (xpeed::udp_egress::queue & queue_a)
+{
+	std::vector<xpeed::udp_egress::datagram> datagrams;
+	datagrams.reserve (batch_size);
+	std::unique_lock<std::mutex> lock (queue_a.mutex);
+	while (!stopped)
+	{
+		if (queue_a.datagrams.empty ())
+		{
+			queue_a.condition.wait (lock);
+		}
+		else if (queue_a.datagrams.size () < batch_size && std::chrono::steady_clock::now () < queue_a.oldest + flush_delay)
+		{
+			// Give other senders a moment to fill the batch
+			queue_a.condition.wait_until (lock, queue_a.oldest + flush_delay);
+		}
+		else
+		{
+			datagrams.swap (queue_a.datagrams);
+			lock.unlock ();
+			flush (datagrams);
+			datagrams.clear ();
+			lock.lock ();
+		}
+	}
+}
+
+void xpeed::udp_egress::flush (std::vector<xpeed::udp_egress::datagram> & datagrams_a)
+{
+#if defined(__linux__)
+	auto & stats (network.node.stats);
+	// Drop a payload queued more than once for the same destination, e.g. a block republished by two paths
+	std::unordered_multimap<xpeed::endpoint, size_t> destinations;
+	std::vector<size_t> unique;
+	unique.reserve (datagrams_a.size ());
+	for (size_t i (0), n (datagrams_a.size ()); i < n; ++i)
+	{
+		auto & datagram (datagrams_a[i]);
+		auto duplicate (false);
+		auto existing (destinations.equal_range (datagram.endpoint));
+		for (auto j (existing.first); j != existing.second && !duplicate; ++j)
+		{
+			auto & other (*datagrams_a[j->second].payload);
+			duplicate = datagram.payload.get () == &other || (datagram.payload->size () == other.size () && std::memcmp (datagram.payload->data (), other.data (), other.size ()) == 0);
+		}
+		if (!duplicate)
+		{
+			destinations.emplace (datagram.endpoint, i);
+			unique.push_back (i);
+		}
+	}
+	if (unique.size () < datagrams_a.size ())
+	{
+		stats.add (xpeed::stat::type::udp, xpeed::stat::detail::egress_coalesced, xpeed::stat::dir::out, datagrams_a.size () - unique.size ());
+	}
+	std::array<mmsghdr, batch_size> headers;
+	std::array<iovec, batch_size> vectors;
+	std::unordered_map<uint32_t, uint64_t> details;
+	uint64_t bytes (0);
+	uint64_t unreachable (0);
+	for (size_t offset (0); offset < unique.size () && !stopped;)
+	{
+		auto count (std::min (batch_size, unique.size () - offset));
+		for (size_t i (0); i < count; ++i)
+		{
+			auto & datagram (datagrams_a[unique[offset + i]]);
+			vectors[i].iov_base = datagram.payload->data ();
+			vectors[i].iov_len = datagram.payload->size ();
+			std::memset (&headers[i], 0, sizeof (headers[i]));
+			headers[i].msg_hdr.msg_name = const_cast<xpeed::endpoint &> (datagram.endpoint).data ();
+			headers[i].msg_hdr.msg_namelen = datagram.endpoint.size ();
+			headers[i].msg_hdr.msg_iov = &vectors[i];
+			headers[i].msg_hdr.msg_iovlen = 1;
+		}
+		auto sent (sendmmsg (descriptor, headers.data (), count, MSG_DONTWAIT));
+		if (sent > 0)
+		{
+			stats.inc (xpeed::stat::type::udp, xpeed::stat::detail::egress_batch, xpeed::stat::dir::out);
+			for (int i (0); i < sent; ++i)
+			{
+				auto & datagram (datagrams_a[unique[offset + i]]);
+				bytes += headers[i].msg_len;
+				if (datagram.detail != xpeed::stat::detail::all)
+				{
+					++details[static_cast<uint32_t> (datagram.detail)];
+				}
+			}
+			offset += sent;
+		}
+		else if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS)
+		{
+			pollfd poll_fd{ descriptor, POLLOUT, 0 };
+			poll (&poll_fd, 1, 100);
+		}
+		else if (errno != EINTR)
+		{
+			// sendmmsg only reports an error for the first message of a batch, skip it and carry on with the rest
+			if (errno == EHOSTUNREACH)
+			{
+				++unreachable;
+			}
+			if (network.node.config.logging.network_logging ())
+			{
+				BOOST_LOG (network.node.log) << boost::str (boost::format ("Error sending datagram to %1%: %2%") % datagrams_a[unique[offset]].endpoint % std::strerror (errno));
+			}
+			++offset;
+		}
+	}
+	if (bytes > 0)
+	{
+		stats.add (xpeed::stat::type::traffic, xpeed::stat::dir::out, bytes);
+	}
+	for (auto & i : details)
+	{
+		stats.add (xpeed::stat::type::message, static_cast<xpeed::stat::detail> (i.first), xpeed::stat::dir::out, i.second);
+	}
+	if (unreachable > 0)
+	{
+		stats.add (xpeed::stat::type::error, xpeed::stat::detail::unreachable_host, xpeed::stat::dir::out, unreachable);
+	}
+#endif
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <xpeed/node/common.hpp>
+#include <xpeed/node/stats.hpp>
+
+#include <boost/asio/ip/udp.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace xpeed
+{
+class network;
+/**
+ * Collects outgoing datagrams in per-thread queues and writes them to the peering socket in batches with sendmmsg.
+ * A queue is flushed once it holds batch_size datagrams or its oldest datagram has waited flush_delay.
+ * Payloads are shared by reference between destinations, and a payload queued twice for the same destination
+ * within one flush is sent once. Message and error counters are updated once per flush.
+ * Without sendmmsg support datagrams go straight to network::send_buffer.
+ */
+class udp_egress
+{
+public:
+	udp_egress (xpeed::network &);
+	~udp_egress ();
+	void start (boost::asio::ip::udp::socket &, unsigned);
+	void stop ();
+	/** Queue \p payload_a for \p endpoint_a, \p detail_a is counted as an outgoing message once it is sent */
+	void send (std::shared_ptr<std::vector<uint8_t>> const & payload_a, xpeed::endpoint const & endpoint_a, xpeed::stat::detail detail_a = xpeed::stat::detail::all);
+	static size_t constexpr batch_size = 64;
+	static size_t constexpr max_queued = 16 * 1024;
+	static std::chrono::microseconds constexpr flush_delay = std::chrono::microseconds (500);
+
+private:
+	class datagram
+	{
+	public:
+		std::shared_ptr<std::vector<uint8_t>> payload;
+		xpeed::endpoint endpoint;
+		xpeed::stat::detail detail;
+	};
+	class queue
+	{
+	public:
+		std::mutex mutex;
+		std::condition_variable condition;
+		std::vector<xpeed::udp_egress::datagram> datagrams;
+		std::chrono::steady_clock::time_point oldest;
+		boost::thread thread;
+	};
+	void run (xpeed::udp_egress::queue &);
+	void flush (std::vector<xpeed::udp_egress::datagram> &);
+	xpeed::network & network;
+	std::vector<std::unique_ptr<xpeed::udp_egress::queue>> queues;
+	int descriptor;
+	std::atomic<bool> started;
+	std::atomic<bool> stopped;
+};
+}
@@ -0,0 +1,234 @@
+#include <xpeed/node/udp_ingress.hpp>
+
+#include <xpeed/node/node.hpp>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/socket.h>
+#endif
+
+#include <cstring>
+
+size_t constexpr xpeed::udp_ingress::batch_size;
+
+xpeed::udp_ingress::udp_ingress (xpeed::network & network_a) :
+network (network_a),
+stopped (false)
+{
+}
+
+xpeed::udp_ingress::~udp_ingress ()
+{
+	stop ();
+}
+
+bool xpeed::udp_ingress::supported ()
+{
+#if defined(__linux__)
+	return true;
+#else
+	return false;
+#endif
+}
+
+void xpeed::udp_ingress::reuse_port (boost::asio::ip::udp::socket & socket_a)
+{
+#if defined(__linux__)
+	socket_a.set_option (boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT> (true));
+#endif
+}
+
+bool xpeed::udp_ingress::start (boost::asio::ip::udp::socket & socket_a, unsigned count_a)
+{
+	auto error (!supported ());
+#if defined(__linux__)
+	auto local (socket_a.local_endpoint ());
+	for (unsigned i (0); !error && i < count_a; ++i)
+	{
+		auto entry (std::make_unique<ingress_socket> ());
+		if (i == 0)
+		{
+			entry->socket = &socket_a;
+		}
+		else
+		{
+			boost::system::error_code ec;
+			entry->owned = std::make_unique<boost::asio::ip::udp::socket> (network.node.io_ctx);
+			entry->owned->open (local.protocol (), ec);
+			if (!ec)
+			{
+				reuse_port (*entry->owned);
+				entry->owned->bind (local, ec);
+			}
+			if (ec)
+			{
+				BOOST_LOG (network.node.log) << boost::str (boost::format ("Unable to open ingress socket %1% on %2%: %3%") % i % local % ec.message ());
+				error = true;
+			}
+			entry->socket = entry->owned.get ();
+		}
+		if (!error)
+		{
+			// Have the kernel report how many datagrams it dropped for this socket
+			int enable (1);
+			setsockopt (entry->socket->native_handle (), SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof (enable));
+			sockets.push_back (std::move (entry));
+		}
+	}
+	if (!error)
+	{
+		boost::thread::attributes attrs;
+		xpeed::thread_attributes::set (attrs);
+		for (auto & entry : sockets)
+		{
+			auto entry_l (entry.get ());
+			entry->thread = boost::thread (attrs, [this, entry_l]() {
+				xpeed::thread_role::set (xpeed::thread_role::name::udp_ingress);
+				run (*entry_l);
+			});
+		}
+	}
+	else
+	{
+		sockets.clear ();
+	}
+#endif
+	return error;
+}
+
+void xpeed::udp_ingress::stop ()
+{
+	stopped = true;
+	for (auto & entry : sockets)
+	{
+		if (entry->thread.joinable ())
+		{
+			entry->thread.join ();
+		}
+	}
+	for (auto & entry : sockets)
+	{
+		if (entry->owned != nullptr && entry->owned->is_open ())
+		{
+			boost::system::error_code ignored;
+			entry->owned->close (ignored);
+		}
+	}
+}
+
+void xpeed::udp_ingress::run (ingress_socket & socket_a)
+{
+#if defined(__linux__)
+	std::array<xpeed::udp_data *, batch_size> data;
+	data.fill (nullptr);
+	std::array<mmsghdr, batch_size> headers;
+	std::array<iovec, batch_size> vectors;
+	std::array<std::array<uint8_t, CMSG_SPACE (sizeof (uint32_t))>, batch_size> controls;
+	auto fd (socket_a.socket->native_handle ());
+	uint32_t kernel_drops (0);
+	auto & buffer_container (network.buffer_container);
+	auto & stats (network.node.stats);
+	auto filled (true);
+	while (!stopped && filled)
+	{
+		for (size_t i (0); i < batch_size && filled; ++i)
+		{
+			if (data[i] == nullptr)
+			{
+				data[i] = buffer_container.allocate ();
+				filled = data[i] != nullptr;
+			}
+		}
+		// Wake periodically so stop () doesn't depend on traffic arriving
+		pollfd poll_fd{ fd, POLLIN, 0 };
+		if (filled && poll (&poll_fd, 1, 100) > 0)
+		{
+			for (size_t i (0); i < batch_size; ++i)
+			{
+				vectors[i].iov_base = data[i]->buffer;
+				vectors[i].iov_len = xpeed::network::buffer_size;
+				std::memset (&headers[i], 0, sizeof (headers[i]));
+				headers[i].msg_hdr.msg_name = data[i]->endpoint.data ();
+				headers[i].msg_hdr.msg_namelen = data[i]->endpoint.capacity ();
+				headers[i].msg_hdr.msg_iov = &vectors[i];
+				headers[i].msg_hdr.msg_iovlen = 1;
+				headers[i].msg_hdr.msg_control = controls[i].data ();
+				headers[i].msg_hdr.msg_controllen = controls[i].size ();
+			}
+			auto received (recvmmsg (fd, headers.data (), batch_size, MSG_DONTWAIT, nullptr));
+			if (received > 0)
+			{
+				uint64_t truncated (0);
+				for (int i (0); i < received; ++i)
+				{
+					auto & header (headers[i].msg_hdr);
+					for (auto control (CMSG_FIRSTHDR (&header)); control != nullptr; control = CMSG_NXTHDR (&header, control))
+					{
+						if (control->cmsg_level == SOL_SOCKET && control->cmsg_type == SO_RXQ_OVFL)
+						{
+							std::memcpy (&kernel_drops, CMSG_DATA (control), sizeof (kernel_drops));
+						}
+					}
+					if ((header.msg_flags & MSG_TRUNC) == 0)
+					{
+						data[i]->size = headers[i].msg_len;
+						data[i]->endpoint.resize (header.msg_namelen);
+						buffer_container.enqueue (data[i]);
+					}
+					else
+					{
+						++truncated;
+						buffer_container.release (data[i]);
+					}
+					data[i] = nullptr;
+				}
+				auto previous_drops (socket_a.kernel_drops.exchange (kernel_drops));
+				auto dropped ((kernel_drops > previous_drops ? kernel_drops - previous_drops : 0) + truncated);
+				socket_a.packets += received;
+				socket_a.truncated += truncated;
+				++socket_a.batches;
+				auto max_batch (socket_a.max_batch.load ());
+				if (static_cast<uint64_t> (received) > max_batch)
+				{
+					socket_a.max_batch = received;
+				}
+				stats.inc (xpeed::stat::type::udp, xpeed::stat::detail::ingress_batch);
+				if (dropped > 0)
+				{
+					stats.add (xpeed::stat::type::udp, xpeed::stat::detail::ingress_drop, xpeed::stat::dir::in, dropped);
+				}
+			}
+			else if (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+			{
+				if (network.node.config.logging.network_logging ())
+				{
+					BOOST_LOG (network.node.log) << boost::str (boost::format ("UDP Receive error: %1%") % std::strerror (errno));
+				}
+			}
+		}
+	}
+	for (auto i : data)
+	{
+		if (i != nullptr)
+		{
+			buffer_container.release (i);
+		}
+	}
+#endif
+}
+
+void xpeed::udp_ingress::serialize_stats (boost::property_tree::ptree & tree_a)
+{
+	boost::property_tree::ptree sockets_l;
+	for (auto & entry : sockets)
+	{
+		boost::property_tree::ptree socket_l;
+		socket_l.put ("packets", entry->packets.load ());
+		socket_l.put ("batches", entry->batches.load ());
+		socket_l.put ("max_batch", entry->max_batch.load ());
+		socket_l.put ("kernel_drops", entry->kernel_drops.load ());
+		socket_l.put ("truncated", entry->truncated.load ());
+		sockets_l.push_back (std::make_pair ("", socket_l));
+	}
+	tree_a.add_child ("sockets", sockets_l);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <boost/asio/ip/udp.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace xpeed
+{
+class network;
+/**
+ * Receives peering traffic on several UDP sockets bound to the same port with SO_REUSEPORT, the kernel spreads
+ * flows across them. Each socket is drained by a dedicated thread which reads batches of datagrams with recvmmsg
+ * straight in to udp_buffer entries.
+ * Only available on Linux, elsewhere the network keeps its single asynchronous receive.
+ */
+class udp_ingress
+{
+public:
+	udp_ingress (xpeed::network &);
+	~udp_ingress ();
+	static bool supported ();
+	/** Mark \p socket_a as shareable, must be called before it is bound */
+	static void reuse_port (boost::asio::ip::udp::socket & socket_a);
+	/** Drain the bound \p socket_a and \p count_a - 1 additional sockets sharing its port, returns true on error */
+	bool start (boost::asio::ip::udp::socket & socket_a, unsigned count_a);
+	void stop ();
+	void serialize_stats (boost::property_tree::ptree &);
+	static size_t constexpr batch_size = 64;
+
+private:
+	class ingress_socket
+	{
+	public:
+		boost::asio::ip::udp::socket * socket;
+		std::unique_ptr<boost::asio::ip::udp::socket> owned;
+		boost::thread thread;
+		std::atomic<uint64_t> packets{ 0 };
+		std::atomic<uint64_t> batches{ 0 };
+		std::atomic<uint64_t> max_batch{ 0 };
+		// Datagrams the kernel dropped because the socket receive queue was full
+		std::atomic<uint64_t> kernel_drops{ 0 };
+		// Datagrams larger than a udp_buffer entry
+		std::atomic<uint64_t> truncated{ 0 };
+	};
+	void run (ingress_socket &);
+	xpeed::network & network;
+	std::vector<std::unique_ptr<ingress_socket>> sockets;
+	std::atomic<bool> stopped;
+};
+}
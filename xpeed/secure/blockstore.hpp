@@ -295,6 +295,13 @@ public:
 	virtual size_t online_weight_count (xpeed::transaction const &) const = 0;
 	virtual void online_weight_clear (xpeed::transaction const &) = 0;
 
+	virtual void confirmation_height_put (xpeed::transaction const &, xpeed::account const &, uint64_t) = 0;
+	// Return the height of the highest cemented block in the account chain, zero if none is cemented
+	virtual uint64_t confirmation_height_get (xpeed::transaction const &, xpeed::account const &) = 0;
+	virtual void confirmation_height_del (xpeed::transaction const &, xpeed::account const &) = 0;
+	virtual size_t confirmation_height_count (xpeed::transaction const &) = 0;
+	virtual void confirmation_height_clear (xpeed::transaction const &) = 0;
+
 	virtual void version_put (xpeed::transaction const &, int) = 0;
 	virtual int version_get (xpeed::transaction const &) = 0;
 
@@ -306,6 +313,12 @@ public:
 	virtual xpeed::store_iterator<xpeed::endpoint_key, xpeed::no_value> peers_begin (xpeed::transaction const & transaction_a) = 0;
 	virtual xpeed::store_iterator<xpeed::endpoint_key, xpeed::no_value> peers_end () = 0;
 
+	/** Replace the saved bootstrap progress with \p records_a */
+	virtual void bootstrap_checkpoint_put (xpeed::transaction const &, std::vector<std::vector<uint8_t>> const & records_a) = 0;
+	/** Saved bootstrap progress records in the order they were put, empty if there is none */
+	virtual std::vector<std::vector<uint8_t>> bootstrap_checkpoint_get (xpeed::transaction const &) = 0;
+	virtual void bootstrap_checkpoint_clear (xpeed::transaction const &) = 0;
+
 	// Requires a write transaction
 	virtual xpeed::raw_key get_node_id (xpeed::transaction const &) = 0;
 
@@ -14,7 +14,8 @@ public:
 	rollback_visitor (xpeed::transaction const & transaction_a, xpeed::ledger & ledger_a, std::vector<xpeed::block_hash> & list_a) :
 	transaction (transaction_a),
 	ledger (ledger_a),
-	list (list_a)
+	list (list_a),
+	error (false)
 	{
 	}
 	virtual ~rollback_visitor () = default;
@@ -23,21 +24,24 @@ public:
 		auto hash (block_a.hash ());
 		xpeed::pending_info pending;
 		xpeed::pending_key key (block_a.hashables.destination, hash);
-		while (ledger.store.pending_get (transaction, key, pending))
+		while (!error && ledger.store.pending_get (transaction, key, pending))
 		{
-			ledger.rollback (transaction, ledger.latest (transaction, block_a.hashables.destination), list);
+			error = ledger.rollback (transaction, ledger.latest (transaction, block_a.hashables.destination), list);
+		}
+		if (!error)
+		{
+			xpeed::account_info info;
+			auto latest_error (ledger.store.account_get (transaction, pending.source, info));
+			assert (!latest_error);
+			ledger.store.pending_del (transaction, key);
+			ledger.store.representation_add (transaction, ledger.representative (transaction, hash), pending.amount.number ());
+			ledger.change_latest (transaction, pending.source, block_a.hashables.previous, info.rep_block, ledger.balance (transaction, block_a.hashables.previous), info.block_count - 1);
+			ledger.store.block_del (transaction, hash);
+			ledger.store.frontier_del (transaction, hash);
+			ledger.store.frontier_put (transaction, block_a.hashables.previous, pending.source);
+			ledger.store.block_successor_clear (transaction, block_a.hashables.previous);
+			ledger.stats.inc (xpeed::stat::type::rollback, xpeed::stat::detail::send);
 		}
-		xpeed::account_info info;
-		auto error (ledger.store.account_get (transaction, pending.source, info));
-		assert (!error);
-		ledger.store.pending_del (transaction, key);
-		ledger.store.representation_add (transaction, ledger.representative (transaction, hash), pending.amount.number ());
-		ledger.change_latest (transaction, pending.source, block_a.hashables.previous, info.rep_block, ledger.balance (transaction, block_a.hashables.previous), info.block_count - 1);
-		ledger.store.block_del (transaction, hash);
-		ledger.store.frontier_del (transaction, hash);
-		ledger.store.frontier_put (transaction, block_a.hashables.previous, pending.source);
-		ledger.store.block_successor_clear (transaction, block_a.hashables.previous);
-		ledger.stats.inc (xpeed::stat::type::rollback, xpeed::stat::detail::send);
 	}
 	void receive_block (xpeed::receive_block const & block_a) override
 	{
@@ -92,64 +96,70 @@ public:
 	void state_block (xpeed::state_block const & block_a) override
 	{
 		auto hash (block_a.hash ());
-		xpeed::block_hash representative (0);
-		if (!block_a.hashables.previous.is_zero ())
-		{
-			representative = ledger.representative (transaction, block_a.hashables.previous);
-		}
 		auto balance (ledger.balance (transaction, block_a.hashables.previous));
 		auto is_send (block_a.hashables.balance < balance);
-		// Add in amount delta
-		ledger.store.representation_add (transaction, hash, 0 - block_a.hashables.balance.number ());
-		if (!representative.is_zero ())
+		xpeed::pending_key key (block_a.hashables.link, hash);
+		// Roll back the receive of a send first, nothing of this block is touched if that fails
+		while (is_send && !error && !ledger.store.pending_exists (transaction, key))
 		{
-			// Move existing representation
-			ledger.store.representation_add (transaction, representative, balance);
+			error = ledger.rollback (transaction, ledger.latest (transaction, block_a.hashables.link), list);
 		}
+		if (!error)
+		{
+			xpeed::block_hash representative (0);
+			if (!block_a.hashables.previous.is_zero ())
+			{
+				representative = ledger.representative (transaction, block_a.hashables.previous);
+			}
+			// Add in amount delta
+			ledger.store.representation_add (transaction, hash, 0 - block_a.hashables.balance.number ());
+			if (!representative.is_zero ())
+			{
+				// Move existing representation
+				ledger.store.representation_add (transaction, representative, balance);
+			}
 
-		xpeed::account_info info;
-		auto error (ledger.store.account_get (transaction, block_a.hashables.account, info));
+			xpeed::account_info info;
+			auto latest_error (ledger.store.account_get (transaction, block_a.hashables.account, info));
 
-		if (is_send)
-		{
-			xpeed::pending_key key (block_a.hashables.link, hash);
-			while (!ledger.store.pending_exists (transaction, key))
+			if (is_send)
 			{
-				ledger.rollback (transaction, ledger.latest (transaction, block_a.hashables.link), list);
+				ledger.store.pending_del (transaction, key);
+				ledger.stats.inc (xpeed::stat::type::rollback, xpeed::stat::detail::send);
+			}
+			else if (!block_a.hashables.link.is_zero () && !ledger.is_epoch_link (block_a.hashables.link))
+			{
+				auto source_version (ledger.store.block_version (transaction, block_a.hashables.link));
+				xpeed::pending_info pending_info (ledger.account (transaction, block_a.hashables.link), block_a.hashables.balance.number () - balance, source_version);
+				ledger.store.pending_put (transaction, xpeed::pending_key (block_a.hashables.account, block_a.hashables.link), pending_info);
+				ledger.stats.inc (xpeed::stat::type::rollback, xpeed::stat::detail::receive);
 			}
-			ledger.store.pending_del (transaction, key);
-			ledger.stats.inc (xpeed::stat::type::rollback, xpeed::stat::detail::send);
-		}
-		else if (!block_a.hashables.link.is_zero () && !ledger.is_epoch_link (block_a.hashables.link))
-		{
-			auto source_version (ledger.store.block_version (transaction, block_a.hashables.link));
-			xpeed::pending_info pending_info (ledger.account (transaction, block_a.hashables.link), block_a.hashables.balance.number () - balance, source_version);
-			ledger.store.pending_put (transaction, xpeed::pending_key (block_a.hashables.account, block_a.hashables.link), pending_info);
-			ledger.stats.inc (xpeed::stat::type::rollback, xpeed::stat::detail::receive);
-		}
 
-		assert (!error);
-		auto previous_version (ledger.store.block_version (transaction, block_a.hashables.previous));
-		ledger.change_latest (transaction, block_a.hashables.account, block_a.hashables.previous, representative, balance, info.block_count - 1, false, previous_version);
+			assert (!latest_error);
+			auto previous_version (ledger.store.block_version (transaction, block_a.hashables.previous));
+			ledger.change_latest (transaction, block_a.hashables.account, block_a.hashables.previous, representative, balance, info.block_count - 1, false, previous_version);
 
-		auto previous (ledger.store.block_get (transaction, block_a.hashables.previous));
-		if (previous != nullptr)
-		{
-			ledger.store.block_successor_clear (transaction, block_a.hashables.previous);
-			if (previous->type () < xpeed::block_type::state)
+			auto previous (ledger.store.block_get (transaction, block_a.hashables.previous));
+			if (previous != nullptr)
 			{
-				ledger.store.frontier_put (transaction, block_a.hashables.previous, block_a.hashables.account);
+				ledger.store.block_successor_clear (transaction, block_a.hashables.previous);
+				if (previous->type () < xpeed::block_type::state)
+				{
+					ledger.store.frontier_put (transaction, block_a.hashables.previous, block_a.hashables.account);
+				}
 			}
+			else
+			{
+				ledger.stats.inc (xpeed::stat::type::rollback, xpeed::stat::detail::open);
+			}
+			ledger.store.block_del (transaction, hash);
 		}
-		else
-		{
-			ledger.stats.inc (xpeed::stat::type::rollback, xpeed::stat::detail::open);
-		}
-		ledger.store.block_del (transaction, hash);
 	}
 	xpeed::transaction const & transaction;
 	xpeed::ledger & ledger;
 	std::vector<xpeed::block_hash> & list;
+	// Set when a dependent block is cemented and the rollback had to stop
+	bool error;
 };
 
 class ledger_processor : public xpeed::block_visitor
@@ -736,6 +746,20 @@ bool xpeed::ledger::block_exists (xpeed::block_type type, xpeed::block_hash cons
 	return result;
 }
 
+// Return true if the block exists and is at or below the cemented height of its account chain
+bool xpeed::ledger::block_confirmed (xpeed::transaction const & transaction_a, xpeed::block_hash const & hash_a)
+{
+	auto result (false);
+	xpeed::block_sideband sideband;
+	auto block (store.block_get (transaction_a, hash_a, &sideband));
+	if (block != nullptr && sideband.height != 0)
+	{
+		auto account (block->account ().is_zero () ? sideband.account : block->account ());
+		result = sideband.height <= store.confirmation_height_get (transaction_a, account);
+	}
+	return result;
+}
+
 std::string xpeed::ledger::block_text (char const * hash_a)
 {
 	return block_text (xpeed::block_hash (hash_a));
@@ -825,27 +849,38 @@ xpeed::uint128_t xpeed::ledger::weight (xpeed::transaction const & transaction_a
 	return store.representation_get (transaction_a, account_a);
 }
 
-// Rollback blocks until `block_a' doesn't exist
-void xpeed::ledger::rollback (xpeed::transaction const & transaction_a, xpeed::block_hash const & block_a, std::vector<xpeed::block_hash> & list_a)
+// Rollback blocks until `block_a' doesn't exist or it tries to penetrate the confirmation height
+bool xpeed::ledger::rollback (xpeed::transaction const & transaction_a, xpeed::block_hash const & block_a, std::vector<xpeed::block_hash> & list_a)
 {
 	assert (store.block_exists (transaction_a, block_a));
 	auto account_l (account (transaction_a, block_a));
 	rollback_visitor rollback (transaction_a, *this, list_a);
 	xpeed::account_info info;
-	while (store.block_exists (transaction_a, block_a))
+	auto error (false);
+	while (!error && store.block_exists (transaction_a, block_a))
 	{
-		auto latest_error (store.account_get (transaction_a, account_l, info));
-		assert (!latest_error);
-		auto block (store.block_get (transaction_a, info.head));
-		list_a.push_back (info.head);
-		block->visit (rollback);
+		// Cemented blocks are final, everything above them is uncemented and so is anything depending on those
+		if (!block_confirmed (transaction_a, block_a))
+		{
+			auto latest_error (store.account_get (transaction_a, account_l, info));
+			assert (!latest_error);
+			auto block (store.block_get (transaction_a, info.head));
+			list_a.push_back (info.head);
+			block->visit (rollback);
+			error = rollback.error;
+		}
+		else
+		{
+			error = true;
+		}
 	}
+	return error;
 }
 
-void xpeed::ledger::rollback (xpeed::transaction const & transaction_a, xpeed::block_hash const & block_a)
+bool xpeed::ledger::rollback (xpeed::transaction const & transaction_a, xpeed::block_hash const & block_a)
 {
 	std::vector<xpeed::block_hash> rollback_list;
-	rollback (transaction_a, block_a, rollback_list);
+	return rollback (transaction_a, block_a, rollback_list);
 }
 
 // Return account containing hash
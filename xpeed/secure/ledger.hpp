@@ -35,11 +35,13 @@ public:
 	std::string block_text (char const *);
 	std::string block_text (xpeed::block_hash const &);
 	bool is_send (xpeed::transaction const &, xpeed::state_block const &);
+	bool block_confirmed (xpeed::transaction const &, xpeed::block_hash const &);
 	xpeed::block_hash block_destination (xpeed::transaction const &, xpeed::block const &);
 	xpeed::block_hash block_source (xpeed::transaction const &, xpeed::block const &);
 	xpeed::process_return process (xpeed::transaction const &, xpeed::block const &, xpeed::signature_verification = xpeed::signature_verification::unknown);
-	void rollback (xpeed::transaction const &, xpeed::block_hash const &, std::vector<xpeed::block_hash> &);
-	void rollback (xpeed::transaction const &, xpeed::block_hash const &);
+	/** Returns true if a block which would have to be rolled back is cemented, nothing at or below it is changed */
+	bool rollback (xpeed::transaction const &, xpeed::block_hash const &, std::vector<xpeed::block_hash> &);
+	bool rollback (xpeed::transaction const &, xpeed::block_hash const &);
 	void change_latest (xpeed::transaction const &, xpeed::account const &, xpeed::block_hash const &, xpeed::account const &, xpeed::uint128_union const &, uint64_t, bool = false, xpeed::epoch = xpeed::epoch::epoch_0);
 	void dump_account_chain (xpeed::account const &);
 	bool could_fit (xpeed::transaction const &, xpeed::block const &);
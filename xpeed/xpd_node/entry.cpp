@@ -3,7 +3,10 @@
 #include <xpeed/node/cli.hpp>
 #include <xpeed/node/node.hpp>
 #include <xpeed/node/rpc.hpp>
+#include <xpeed/node/simulator.hpp>
 #include <xpeed/node/testing.hpp>
+#include <numeric>
+#include <random>
 #include <sstream>
 
 #include <argon2.h>
@@ -48,6 +51,19 @@ int main (int argc, char * const * argv)
 		("debug_profile_sign", "Profile signature generation")
 		("debug_profile_process", "Profile active blocks processing (only for xpd_test_network)")
 		("debug_profile_votes", "Profile votes processing (only for xpd_test_network)")
+		("debug_simulate", "Run generated traffic through nodes on a simulated network and report confirmation latency (only for xpd_test_network)")
+		("simulate_nodes", boost::program_options::value<unsigned> (), "Number of nodes for debug_simulate, default 4")
+		("simulate_count", boost::program_options::value<unsigned> (), "Number of generated ledger actions for debug_simulate, default 1000")
+		("simulate_latency", boost::program_options::value<unsigned> (), "One way link latency in milliseconds for debug_simulate, default 50")
+		("simulate_jitter", boost::program_options::value<unsigned> (), "Maximum additional random link delay in milliseconds for debug_simulate, default 10")
+		("simulate_loss", boost::program_options::value<double> (), "Fraction of datagrams lost for debug_simulate, default 0")
+		("simulate_bandwidth", boost::program_options::value<uint64_t> (), "Link bandwidth in bytes per second for debug_simulate, default 0 (unlimited)")
+		("debug_bootstrap_benchmark", "Bootstrap a fresh node from a node holding a generated ledger over loopback and write stage timings as JSON (only for xpd_test_network)")
+		("benchmark_accounts", boost::program_options::value<unsigned> (), "Number of generated accounts for debug_bootstrap_benchmark, default 10000")
+		("benchmark_chain_length", boost::program_options::value<unsigned> (), "Average number of blocks per generated account for debug_bootstrap_benchmark, default 10")
+		("benchmark_chain_distribution", boost::program_options::value<std::string> (), "Distribution of chain lengths for debug_bootstrap_benchmark, <fixed|uniform|geometric>, default geometric")
+		("benchmark_legacy_ratio", boost::program_options::value<double> (), "Fraction of generated accounts using legacy blocks for debug_bootstrap_benchmark, default 0.25")
+		("benchmark_output", boost::program_options::value<std::string> (), "JSON result file for debug_bootstrap_benchmark, default bootstrap_benchmark.json")
 		("debug_rpc", "Read an RPC command from stdin and invoke it. Network operations will have no effect.")
 		("debug_validate_blocks", "Check all blocks for correct hash, signature, work value")
 		("debug_peers", "Display peer IPv6:port connections")
@@ -641,6 +657,342 @@ int main (int argc, char * const * argv)
 				std::cerr << "For this test ACTIVE_NETWORK should be xpd_test_network" << std::endl;
 			}
 		}
+		else if (vm.count ("debug_simulate"))
+		{
+			if (xpeed::is_test_network)
+			{
+				auto nodes_count (vm.count ("simulate_nodes") ? vm["simulate_nodes"].as<unsigned> () : 4);
+				auto count (vm.count ("simulate_count") ? vm["simulate_count"].as<unsigned> () : 1000);
+				xpeed::link_properties link;
+				link.latency = std::chrono::milliseconds (vm.count ("simulate_latency") ? vm["simulate_latency"].as<unsigned> () : 50);
+				link.jitter = std::chrono::milliseconds (vm.count ("simulate_jitter") ? vm["simulate_jitter"].as<unsigned> () : 10);
+				link.loss = vm.count ("simulate_loss") ? vm["simulate_loss"].as<double> () : 0.0;
+				link.bandwidth = vm.count ("simulate_bandwidth") ? vm["simulate_bandwidth"].as<uint64_t> () : 0;
+				uint32_t const interval_ms (10);
+				std::cerr << boost::str (boost::format ("Starting %1% nodes with %2% ms latency, %3% ms jitter, %4% loss and %5% B/s links\n") % nodes_count % (link.latency.count () / 1000) % (link.jitter.count () / 1000) % link.loss % link.bandwidth);
+				auto transport (std::make_shared<xpeed::simulated_transport> (link));
+				xpeed::system system (24000, nodes_count, transport);
+				system.wallet (0)->insert_adhoc (xpeed::test_genesis_key.prv);
+				std::mutex mutex;
+				std::unordered_map<xpeed::block_hash, std::vector<std::chrono::steady_clock::time_point>> confirmations;
+				for (auto & node : system.nodes)
+				{
+					node->observers.blocks.add ([&mutex, &confirmations](std::shared_ptr<xpeed::block> block_a, xpeed::account const &, xpeed::uint128_t const &, bool) {
+						auto now (std::chrono::steady_clock::now ());
+						std::lock_guard<std::mutex> lock (mutex);
+						confirmations[block_a->hash ()].push_back (now);
+					});
+				}
+				xpeed::thread_runner runner (system.io_ctx, system.nodes[0]->config.io_threads);
+				auto begin (std::chrono::steady_clock::now ());
+				system.generate_usage_traffic (count, interval_ms, 0);
+				// Generation takes at least count * interval, afterwards wait for confirmations to settle
+				auto settle (std::chrono::seconds (10));
+				auto last_change (begin);
+				size_t last_total (0);
+				while (std::chrono::steady_clock::now () < begin + std::chrono::milliseconds (count * interval_ms) || std::chrono::steady_clock::now () < last_change + settle)
+				{
+					std::this_thread::sleep_for (std::chrono::milliseconds (100));
+					size_t total (0);
+					{
+						std::lock_guard<std::mutex> lock (mutex);
+						for (auto & i : confirmations)
+						{
+							total += i.second.size ();
+						}
+					}
+					if (total != last_total)
+					{
+						last_total = total;
+						last_change = std::chrono::steady_clock::now ();
+					}
+				}
+				auto end (last_change);
+				// Latency runs from the block's first arrival at any node to its confirmation by each node
+				std::vector<double> latencies;
+				size_t confirmed_all (0);
+				{
+					std::lock_guard<std::mutex> lock (mutex);
+					for (auto & i : confirmations)
+					{
+						auto arrival (std::chrono::steady_clock::time_point::max ());
+						for (auto & node : system.nodes)
+						{
+							std::lock_guard<std::mutex> arrival_lock (node->block_arrival.mutex);
+							auto existing (node->block_arrival.arrival.get<1> ().find (i.first));
+							if (existing != node->block_arrival.arrival.get<1> ().end ())
+							{
+								arrival = std::min (arrival, existing->arrival);
+							}
+						}
+						if (arrival != std::chrono::steady_clock::time_point::max ())
+						{
+							for (auto & confirmed : i.second)
+							{
+								latencies.push_back (std::chrono::duration<double, std::milli> (confirmed - arrival).count ());
+							}
+						}
+						confirmed_all += i.second.size () >= system.nodes.size () ? 1 : 0;
+					}
+				}
+				std::sort (latencies.begin (), latencies.end ());
+				auto percentile = [&latencies](double fraction_a) {
+					return latencies.empty () ? 0.0 : latencies[std::min (latencies.size () - 1, static_cast<size_t> (fraction_a * latencies.size ()))];
+				};
+				auto sent (transport->sent.load ());
+				std::cerr << boost::str (boost::format ("%1% blocks confirmed by all nodes in %2% ms\n") % confirmed_all % std::chrono::duration_cast<std::chrono::milliseconds> (end - begin).count ());
+				std::cerr << boost::str (boost::format ("Confirmation latency ms: p50 %1$.1f p90 %2$.1f p99 %3$.1f max %4$.1f\n") % percentile (0.5) % percentile (0.9) % percentile (0.99) % (latencies.empty () ? 0.0 : latencies.back ()));
+				std::cerr << boost::str (boost::format ("%1% datagrams sent, %2% lost, %3% dropped, %4$.1f messages per confirmation\n") % sent % transport->lost.load () % transport->dropped.load () % (confirmed_all > 0 ? static_cast<double> (sent) / confirmed_all : 0.0));
+				system.stop ();
+				system.io_ctx.stop ();
+				runner.join ();
+			}
+			else
+			{
+				std::cerr << "For this test ACTIVE_NETWORK should be xpd_test_network" << std::endl;
+			}
+		}
+		else if (vm.count ("debug_bootstrap_benchmark"))
+		{
+			if (xpeed::is_test_network)
+			{
+				auto accounts_count (vm.count ("benchmark_accounts") ? vm["benchmark_accounts"].as<unsigned> () : 10000);
+				auto chain_length (std::max (1U, vm.count ("benchmark_chain_length") ? vm["benchmark_chain_length"].as<unsigned> () : 10));
+				auto distribution (vm.count ("benchmark_chain_distribution") ? vm["benchmark_chain_distribution"].as<std::string> () : std::string ("geometric"));
+				auto legacy_ratio (vm.count ("benchmark_legacy_ratio") ? vm["benchmark_legacy_ratio"].as<double> () : 0.25);
+				auto output (vm.count ("benchmark_output") ? vm["benchmark_output"].as<std::string> () : std::string ("bootstrap_benchmark.json"));
+				if (distribution == "fixed" || distribution == "uniform" || distribution == "geometric")
+				{
+					boost::asio::io_context io_ctx;
+					xpeed::alarm alarm (io_ctx);
+					xpeed::node_init init;
+					xpeed::work_pool work (std::numeric_limits<unsigned>::max (), nullptr);
+					xpeed::logging logging;
+					auto path (xpeed::unique_path ());
+					logging.init (path);
+					auto source (std::make_shared<xpeed::node> (init, io_ctx, 24001, path, alarm, logging, work));
+					auto fresh (std::make_shared<xpeed::node> (init, io_ctx, 24002, xpeed::unique_path (), alarm, logging, work));
+					// Fixed seeds so every run generates the same ledger
+					std::mt19937 random (0);
+					xpeed::uint256_union seed (0);
+					std::vector<unsigned> lengths (accounts_count);
+					for (auto & length : lengths)
+					{
+						if (distribution == "fixed")
+						{
+							length = chain_length;
+						}
+						else if (distribution == "uniform")
+						{
+							length = std::uniform_int_distribution<unsigned> (1, 2 * chain_length - 1) (random);
+						}
+						else
+						{
+							length = 1 + std::geometric_distribution<unsigned> (1.0 / chain_length) (random);
+						}
+					}
+					std::cerr << boost::str (boost::format ("Generating %1% blocks for %2% accounts\n") % (std::accumulate (lengths.begin (), lengths.end (), uint64_t (0)) + accounts_count) % accounts_count);
+					xpeed::block_builder builder;
+					uint64_t generated (0);
+					{
+						auto transaction (source->store.tx_begin_write ());
+						xpeed::block_hash genesis_latest (source->ledger.latest (transaction, xpeed::test_genesis_key.pub));
+						xpeed::uint128_t genesis_balance (std::numeric_limits<xpeed::uint128_t>::max ());
+						xpeed::uint128_t const amount (1000000000);
+						auto process ([&source, &transaction, &generated](std::shared_ptr<xpeed::block> block_a) {
+							auto result (source->ledger.process (transaction, *block_a));
+							release_assert (result.code == xpeed::process_result::progress);
+							++generated;
+							return block_a->hash ();
+						});
+						for (auto i (0U); i != accounts_count; ++i)
+						{
+							xpeed::raw_key prv;
+							xpeed::deterministic_key (seed, i, prv.data);
+							xpeed::keypair key (std::move (prv));
+							auto legacy (std::bernoulli_distribution (legacy_ratio) (random));
+							genesis_balance -= amount;
+							genesis_latest = process (builder.state ()
+							                          .account (xpeed::test_genesis_key.pub)
+							                          .previous (genesis_latest)
+							                          .representative (xpeed::test_genesis_key.pub)
+							                          .balance (genesis_balance)
+							                          .link (key.pub)
+							                          .sign (xpeed::test_genesis_key.prv, xpeed::test_genesis_key.pub)
+							                          .work (work.generate (genesis_latest))
+							                          .build ());
+							xpeed::block_hash latest;
+							if (legacy)
+							{
+								latest = process (builder.open ()
+								                  .source (genesis_latest)
+								                  .representative (key.pub)
+								                  .account (key.pub)
+								                  .sign (key.prv, key.pub)
+								                  .work (work.generate (key.pub))
+								                  .build ());
+							}
+							else
+							{
+								latest = process (builder.state ()
+								                  .account (key.pub)
+								                  .previous (0)
+								                  .representative (key.pub)
+								                  .balance (amount)
+								                  .link (genesis_latest)
+								                  .sign (key.prv, key.pub)
+								                  .work (work.generate (key.pub))
+								                  .build ());
+							}
+							// The rest of the chain alternates sending one raw to itself and receiving it back
+							for (auto j (1U); j < lengths[i]; ++j)
+							{
+								auto send (j % 2 == 1);
+								auto balance (send ? amount - 1 : amount);
+								if (legacy && send)
+								{
+									latest = process (builder.send ()
+									                  .previous (latest)
+									                  .destination (key.pub)
+									                  .balance (balance)
+									                  .sign (key.prv, key.pub)
+									                  .work (work.generate (latest))
+									                  .build ());
+								}
+								else if (legacy)
+								{
+									latest = process (builder.receive ()
+									                  .previous (latest)
+									                  .source (latest)
+									                  .sign (key.prv, key.pub)
+									                  .work (work.generate (latest))
+									                  .build ());
+								}
+								else
+								{
+									latest = process (builder.state ()
+									                  .account (key.pub)
+									                  .previous (latest)
+									                  .representative (key.pub)
+									                  .balance (balance)
+									                  .link (send ? xpeed::uint256_union (key.pub) : latest)
+									                  .sign (key.prv, key.pub)
+									                  .work (work.generate (latest))
+									                  .build ());
+								}
+							}
+						}
+					}
+					auto expected (generated + 1);
+					source->start ();
+					fresh->start ();
+					xpeed::thread_runner runner (io_ctx, source->config.io_threads);
+					std::cerr << boost::str (boost::format ("Bootstrapping %1% blocks over loopback\n") % expected);
+					auto begin (std::chrono::steady_clock::now ());
+					fresh->bootstrap_initiator.bootstrap (source->network.endpoint ());
+					// Stage ends, frontiers are scanned once every range is done and pulls are transferred once the attempt ends
+					auto frontiers_done (begin);
+					auto pulls_done (begin);
+					auto frontiers_finished (false);
+					auto pulls_finished (false);
+					auto settle (std::chrono::seconds (60));
+					auto last_change (begin);
+					uint64_t block_count (0);
+					uint64_t pulled (0);
+					boost::property_tree::ptree samples;
+					while (block_count < expected && std::chrono::steady_clock::now () < last_change + settle)
+					{
+						std::this_thread::sleep_for (std::chrono::milliseconds (250));
+						auto now (std::chrono::steady_clock::now ());
+						auto attempt (fresh->bootstrap_initiator.current_attempt ());
+						if (attempt != nullptr)
+						{
+							pulled = attempt->total_blocks;
+							std::lock_guard<std::mutex> lock (attempt->mutex);
+							if (!frontiers_finished && !attempt->frontier_ranges.empty () && attempt->frontier_ranges_pending () == 0)
+							{
+								frontiers_finished = true;
+								frontiers_done = now;
+							}
+						}
+						else if (!pulls_finished && !fresh->bootstrap_initiator.in_progress ())
+						{
+							if (!frontiers_finished)
+							{
+								frontiers_finished = true;
+								frontiers_done = now;
+							}
+							pulls_finished = true;
+							pulls_done = now;
+						}
+						size_t unchecked (0);
+						uint64_t previous_count (block_count);
+						{
+							auto transaction (fresh->store.tx_begin_read ());
+							block_count = fresh->store.block_count (transaction).sum ();
+							unchecked = fresh->store.unchecked_count (transaction);
+						}
+						if (block_count != previous_count)
+						{
+							last_change = now;
+						}
+						auto elapsed (std::chrono::duration_cast<std::chrono::milliseconds> (now - begin).count ());
+						boost::property_tree::ptree sample;
+						sample.put ("elapsed_ms", elapsed);
+						sample.put ("blocks", block_count);
+						sample.put ("pulled", pulled);
+						sample.put ("unchecked", unchecked);
+						sample.put ("blocks_per_second", elapsed > 0 ? block_count * 1000 / elapsed : 0);
+						samples.push_back (std::make_pair ("", sample));
+					}
+					auto end (std::chrono::steady_clock::now ());
+					if (!pulls_finished)
+					{
+						pulls_done = end;
+						frontiers_done = frontiers_finished ? frontiers_done : end;
+					}
+					auto milliseconds ([](std::chrono::steady_clock::duration const & duration_a) {
+						return std::chrono::duration_cast<std::chrono::milliseconds> (duration_a).count ();
+					});
+					auto total (milliseconds (end - begin));
+					boost::property_tree::ptree result;
+					result.put ("accounts", accounts_count);
+					result.put ("chain_length", chain_length);
+					result.put ("chain_distribution", distribution);
+					result.put ("legacy_ratio", legacy_ratio);
+					result.put ("expected_blocks", expected);
+					result.put ("blocks", block_count);
+					result.put ("elapsed_ms", total);
+					result.put ("blocks_per_second", total > 0 ? block_count * 1000 / total : 0);
+					boost::property_tree::ptree stages;
+					stages.put ("frontier_scan_ms", milliseconds (frontiers_done - begin));
+					stages.put ("pull_transfer_ms", milliseconds (pulls_done - frontiers_done));
+					stages.put ("unchecked_resolution_ms", milliseconds (end - pulls_done));
+					// Time spent in the block processor, overlapping the stages above
+					stages.put ("signature_verify_ms", fresh->stats.count (xpeed::stat::type::block_processor, xpeed::stat::detail::signature_verify) / 1000);
+					stages.put ("ledger_apply_ms", fresh->stats.count (xpeed::stat::type::block_processor, xpeed::stat::detail::ledger_apply) / 1000);
+					stages.put ("unchecked_resolve_ms", fresh->stats.count (xpeed::stat::type::block_processor, xpeed::stat::detail::unchecked_resolve) / 1000);
+					result.add_child ("stages", stages);
+					result.add_child ("samples", samples);
+					boost::property_tree::write_json (output, result);
+					std::cerr << boost::str (boost::format ("%1% of %2% blocks bootstrapped in %3% ms, %4% blocks per second, results written to %5%\n") % block_count % expected % total % result.get<uint64_t> ("blocks_per_second") % output);
+					fresh->stop ();
+					source->stop ();
+					io_ctx.stop ();
+					runner.join ();
+					xpeed::remove_temporary_directories ();
+				}
+				else
+				{
+					std::cerr << "Invalid benchmark_chain_distribution, use fixed, uniform or geometric" << std::endl;
+					result = -1;
+				}
+			}
+			else
+			{
+				std::cerr << "For this test ACTIVE_NETWORK should be xpd_test_network" << std::endl;
+			}
+		}
 		else if (vm.count ("debug_rpc"))
 		{
 			std::string rpc_input_l;